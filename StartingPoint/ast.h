@@ -10,29 +10,70 @@
 //   Part 4 : IF/WHILE, custom op/keyword, skins
 // =============================================================================
 #pragma once
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
-#include <variant>
+#include <cstring>
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
 #include <cmath>
 #include <cstdint>
+#include <charconv>
+#include <type_traits>
+#include "budget.h"  // tick() at every step, for --max-steps and --timeout
+#include "hashing.h" // fnv::hash() for the string pool
 using namespace std;
 
 using IntType = int32_t;
 using RealType = double;
-using ValueVariant = variant<IntType, RealType>;
+
+// -----------------------------------------------------------------------------
+// Runtime value: one 8-byte word
+// -----------------------------------------------------------------------------
+// A REAL is kept as its IEEE-754 bits. An INTEGER sits in the low 32 bits of a
+// NaN pattern whose high word is INT_TAG, so the type test is one 32-bit
+// compare and a frame slot is half the size of a variant<int32_t, double>.
+// A REAL NaN that happens to carry INT_TAG is stored as the default -NaN
+// instead (TIPS can only observe a NaN's sign, which both share).
+class ValueVariant {
+public:
+  ValueVariant() : bits(uint64_t{INT_TAG} << 32) {}
+  ValueVariant(IntType i) : bits((uint64_t{INT_TAG} << 32) | static_cast<uint32_t>(i)) {}
+  ValueVariant(RealType d) {
+    memcpy(&bits, &d, sizeof bits);
+    if ((bits >> 32) == INT_TAG) bits = NEG_NAN;
+  }
+
+  bool isInt() const { return (bits >> 32) == INT_TAG; }
+  bool isReal() const { return !isInt(); }
+  static bool bothInt(const ValueVariant& a, const ValueVariant& b) {
+    return ((a.bits >> 32) == INT_TAG) & ((b.bits >> 32) == INT_TAG);
+  }
+  IntType intValue() const { return static_cast<IntType>(static_cast<uint32_t>(bits)); }
+  RealType realValue() const {
+    RealType d;
+    memcpy(&d, &bits, sizeof d);
+    return d;
+  }
+
+private:
+  static constexpr uint32_t INT_TAG = 0xFFFA0000u;            // sign + quiet NaN + 0b010
+  static constexpr uint64_t NEG_NAN = 0xFFF8000000000000ull;  // x86 default NaN
+  uint64_t bits;
+};
+static_assert(sizeof(ValueVariant) == 8, "runtime values must fit one word");
 
 // Logical comparisons tolerate floating point noise via EPSILON.
 constexpr RealType EPSILON = 1e-5;
 
 inline RealType asReal(const ValueVariant& v) {
-  return holds_alternative<RealType>(v)
-           ? get<RealType>(v)
-           : static_cast<RealType>(get<IntType>(v));
+  return v.isReal()
+           ? v.realValue()
+           : static_cast<RealType>(v.intValue());
 }
 
 inline bool approxEqual(RealType a, RealType b) {
@@ -44,46 +85,222 @@ inline ValueVariant boolToValue(bool b) {
 }
 
 inline bool isTrueValue(const ValueVariant& v) {
-  if (holds_alternative<IntType>(v)) {
-    return get<IntType>(v) != 0;
+  if (v.isInt()) {
+    return v.intValue() != 0;
   }
-  return fabs(get<RealType>(v)) >= EPSILON;
+  return fabs(v.realValue()) >= EPSILON;
 }
 
 // -----------------------------------------------------------------------------
 // Global Variable
 // -----------------------------------------------------------------------------
-extern map<string, ValueVariant> symbolTable;
+// Every declared VAR owns one slot of the variable frame; the parser assigns
+// slots in declaration order and resolves each identifier use to its slot.
+// Slots past the declared VARs hold optimizer temporaries, which never appear
+// in symbolTable (and so never in the -s dump).
+struct Frame {
+  vector<ValueVariant> slots;
+  vector<char> ready;  // temporaries only: slot holds a usable value
+
+  size_t addSlot(ValueVariant init) {
+    slots.push_back(init);
+    ready.push_back(0);
+    return slots.size() - 1;
+  }
+};
+
+extern map<string, size_t> symbolTable;  // VAR name -> slot in varFrame
+extern Frame varFrame;
+
+// -----------------------------------------------------------------------------
+// String literal pool
+// -----------------------------------------------------------------------------
+// WRITE operands are stored once each, already rendered as the bytes WRITE
+// prints for a literal ('text' plus newline), in fixed-size blocks that never
+// move; identical texts share an entry. VAR names of WRITE(id) live here too
+// so a WriteStmt carries no string of its own.
+class StringPool {
+public:
+
+  struct Span {
+    uint32_t block = 0, offset = 0, length = 0;  // rendered bytes
+  };
+
+  Span intern(const string& text) {
+    if (text.size() > UINT32_MAX - 3) throw runtime_error("Parse error: string literal too long");
+    if (2 * (count + 1) > table.size()) grow();
+    for (size_t i = hash(text) & (table.size() - 1);; i = (i + 1) & (table.size() - 1)) {
+      if (table[i].length == 0) {  // rendered spans are never empty
+        table[i] = store(text);
+        ++count;
+        return table[i];
+      }
+      if (this->text(table[i]) == text) return table[i];
+    }
+  }
+
+  // 'text' and the newline, ready for one write().
+  string_view rendered(Span s) const { return {blocks[s.block].get() + s.offset, s.length}; }
+  // The text itself, without quotes or newline.
+  string_view text(Span s) const { return {blocks[s.block].get() + s.offset + 1, s.length - 3u}; }
+
+private:
+  static constexpr size_t BLOCK = 64 * 1024;
+  static constexpr size_t MAX_BLOCKS = 16 * 1024;  // 1 GiB of literals
+
+  vector<unique_ptr<char[]>> blocks;
+  size_t used = BLOCK;  // bytes filled in blocks.back()
+  vector<Span> table;   // open addressing, power-of-two size, at most half full
+  size_t count = 0;
+
+  static uint64_t hash(string_view t) { return fnv::hash(t); }
+
+  Span store(const string& text) {
+    size_t n = text.size() + 3;
+    if (used + n > BLOCK) {  // a literal longer than a block gets its own
+      if (blocks.size() == MAX_BLOCKS) throw runtime_error("Parse error: string literals exceed 1 GiB");
+      blocks.push_back(make_unique<char[]>(max(n, BLOCK)));
+      used = 0;
+    }
+    char* p = blocks.back().get() + used;
+    p[0] = '\'';
+    text.copy(p + 1, text.size());
+    p[n - 2] = '\'';
+    p[n - 1] = '\n';
+    Span s{static_cast<uint32_t>(blocks.size() - 1), static_cast<uint32_t>(used),
+           static_cast<uint32_t>(n)};
+    used = n > BLOCK ? BLOCK : used + n;
+    return s;
+  }
+
+  void grow() {
+    vector<Span> old = std::move(table);
+    table.assign(old.empty() ? 64 : old.size() * 2, Span{});
+    for (const Span& s : old) {
+      if (s.length == 0) continue;
+      size_t i = hash(text(s)) & (table.size() - 1);
+      while (table[i].length != 0) i = (i + 1) & (table.size() - 1);
+      table[i] = s;
+    }
+  }
+};
+
+extern StringPool stringPool;  // WRITE operands of the parsed program
+
+// Pool WRITE operands are interned into and rendered from: stringPool,
+// except in tipsd, where every cached program has a pool of its own (so its
+// literals are freed when it leaves the cache) and the thread compiling or
+// running a program points this at that program's pool. A pool is only
+// added to while its program is parsed, before anything runs it.
+inline thread_local StringPool* activePool = &stringPool;
+
+// Frame that statements and expressions read and write at run time. It is
+// varFrame except on worker threads, which point it at a private copy while
+// they run their share of a parallel loop (see ParallelLoop in optimize.h).
+inline thread_local Frame* activeFrame = &varFrame;
+
+// Where READ takes its input: cin, except on tipsd workers, which point it
+// at the bytes sent with the request they are running.
+inline thread_local istream* activeInput = &cin;
 
 inline void printValue(ostream& out, const ValueVariant& val) {
-  if (holds_alternative<IntType>(val)) {
-    out << get<IntType>(val);
+  if (val.isInt()) {
+    out << val.intValue();
   } else {
     auto flags = out.flags();
     auto precision = out.precision();
-    out << fixed << setprecision(4) << get<RealType>(val);
+    out << fixed << setprecision(4) << val.realValue();
     out.flags(flags);
     out.precision(precision);
   }
 }
 
+// Stores rv into a VAR's cell, keeping the VAR's declared type.
+inline void assignValue(ValueVariant& cell, const ValueVariant& rv) {
+  if (cell.isInt()) {
+    // store as integer (truncate if real)
+    cell = rv.isInt() ? rv.intValue() : static_cast<IntType>(rv.realValue());
+  } else {
+    // store as real (widen int)
+    cell = asReal(rv);
+  }
+}
+
+// `-s` dump: one "name : TYPE = value" line per VAR, in name order.
+inline void printSymbols(ostream& out, const Frame& frame,
+                         const map<string, size_t>& symbols = symbolTable) {
+  for (const auto& [name, slot] : symbols) {
+    const ValueVariant& val = frame.slots[slot];
+    out << name << " : " << (val.isInt() ? "INTEGER" : "REAL") << " = ";
+    printValue(out, val);
+    out << "\n";
+  }
+}
+
 // -----------------------------------------------------------------------------
 // Pretty printer
 // -----------------------------------------------------------------------------
-inline void ast_line(ostream& os, string prefix, bool last, string label) {
-  os << prefix << (last ? "└── " : "├── ") << label << "\n";
-}
-inline string kid_prefix(const string& prefix, bool isLast) {
-  return prefix + (isLast ? "    " : "│   ");
-}
+// -p writes through one TreePrinter. The prefix of the current depth is a
+// single buffer: entering a node's children appends a "│   " or "    "
+// segment and leaving them cuts it off again, and each line is assembled
+// from its parts straight into an output buffer that reaches the stream in
+// 64 KiB writes. A line then costs its own bytes, however deep it sits.
+class TreePrinter {
+public:
+  explicit TreePrinter(ostream& os) : os(os) { buf.reserve(FLUSH_AT + 4096); }
+  ~TreePrinter() { flush(); }
+  TreePrinter(const TreePrinter&) = delete;
+  TreePrinter& operator=(const TreePrinter&) = delete;
+
+  // prefix, branch, then each part of the label, then a newline.
+  template <class... Parts>
+  void line(bool last, const Parts&... parts) {
+    buf.append(prefix).append(last ? "└── " : "├── ");
+    (put(parts), ...);
+    buf.push_back('\n');
+    if (buf.size() >= FLUSH_AT) flush();
+  }
+  // Text with no prefix or branch (the "Program" header).
+  void raw(string_view s) { buf.append(s); }
+
+  // Children of a node printed with `last` hang under the segment pushed
+  // here; pop() removes the most recent segment.
+  void push(bool last) {
+    marks.push_back(prefix.size());
+    prefix.append(last ? "    " : "│   ");
+  }
+  void pop() { prefix.resize(marks.back()); marks.pop_back(); }
+
+  void flush() {
+    os.write(buf.data(), static_cast<streamsize>(buf.size()));
+    buf.clear();
+  }
+
+private:
+  static constexpr size_t FLUSH_AT = 1 << 16;
+  ostream& os;
+  string buf;
+  string prefix;
+  vector<size_t> marks;
+
+  void put(string_view s) { buf.append(s); }
+  void put(const char* s) { buf.append(s); }
+  void put(char c) { buf.push_back(c); }
+  void put(RealType v) { buf.append(to_string(v)); }
+  template <class T, enable_if_t<is_integral_v<T>, int> = 0>
+  void put(T v) {
+    char digits[24];
+    buf.append(digits, static_cast<size_t>(to_chars(digits, digits + sizeof digits, v).ptr - digits));
+  }
+};
 
 // Write and Block Structs
 
 struct Write {
     string text;  
 
-    void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const {
-        ast_line(os, prefix, isLast, "Write( '" + text + "' )");
+    void print_tree(TreePrinter& tp, bool isLast = true) const {
+        tp.line(isLast, "Write( '", text, "' )");
     }
 
     void interpret(ostream& out) const {
@@ -98,37 +315,38 @@ struct Value {
 
   Value(Kind k, string s) : kind(k), lexeme(std::move(s)) {}
 
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const {
-    string tag = (kind == Kind::IntLit)   ? "INT " :
-                 (kind == Kind::FloatLit) ? "REAL " : "IDENT ";
-    ast_line(os, prefix, isLast, "Value(" + tag + lexeme + ")");
+  void print_tree(TreePrinter& tp, bool isLast = true) const {
+    const char* tag = (kind == Kind::IntLit)   ? "INT " :
+                      (kind == Kind::FloatLit) ? "REAL " : "IDENT ";
+    tp.line(isLast, "Value(", tag, lexeme, ")");
   }
 };
 
 struct Statement {
+  int line = 0;  // source line the statement starts on (0 if made by -O)
   virtual ~Statement() = default;
-  virtual void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const = 0;
+  virtual void print_tree(TreePrinter& tp, bool isLast = true) const = 0;
   virtual void interpret(ostream& out) const { (void)out; }  // Step 4 will implement behavior
 };
 struct ReadStmt : Statement {
   string id;
-  explicit ReadStmt(string id_) : id(std::move(id_)) {}
+  size_t slot;
+  ReadStmt(string id_, size_t slot_) : id(std::move(id_)), slot(slot_) {}
 
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, "Read(" + id + ")");
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "Read(", id, ")");
   }
 
   void interpret(ostream& out) const override {
-    auto it = symbolTable.find(id);
-    if (it == symbolTable.end())
-      throw runtime_error("Runtime error: READ of undeclared identifier " + id);
-    if (holds_alternative<IntType>(it->second)) {
-      IntType v; if (!(cin >> v)) throw runtime_error("Input error: expected INTEGER for " + id);
-      it->second = v;
+    out.flush();  // prompts written so far must show before we block on input
+    ValueVariant& cell = activeFrame->slots[slot];
+    if (cell.isInt()) {
+      IntType v; if (!(*activeInput >> v)) throw runtime_error("Input error: expected INTEGER for " + id);
+      cell = v;
     } 
     else {
-      RealType v; if (!(cin >> v)) throw runtime_error("Input error: expected REAL for " + id);
-      it->second = v;
+      RealType v; if (!(*activeInput >> v)) throw runtime_error("Input error: expected REAL for " + id);
+      cell = v;
     }
   }
 };
@@ -136,24 +354,27 @@ struct ReadStmt : Statement {
 struct WriteStmt : Statement {
   enum class ArgKind { Str, Id };
   ArgKind kind;
-  string text_or_id;
+  StringPool::Span text;  // Str: the literal; Id: the VAR name (in activePool)
+  size_t slot;            // ArgKind::Id only
+
+  WriteStmt(ArgKind k, const string& v, size_t slot_ = 0)
+    : kind(k), text(activePool->intern(v)), slot(slot_) {}
 
-  WriteStmt(ArgKind k, string v) : kind(k), text_or_id(std::move(v)) {}
+  string id() const { return string(activePool->text(text)); }
 
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    string payload = (kind == ArgKind::Str) ? ("'" + text_or_id + "'") : text_or_id;
-    ast_line(os, prefix, isLast, "Write(" + payload + ")");
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    string_view name = activePool->text(text);
+    if (kind == ArgKind::Str) tp.line(isLast, "Write('", name, "')");
+    else                      tp.line(isLast, "Write(", name, ")");
   }
 
   void interpret(ostream& out) const override {
     if (kind == ArgKind::Str) {
-      out << "'" << text_or_id << "'" << '\n';
+      string_view r = activePool->rendered(text);
+      out.write(r.data(), static_cast<streamsize>(r.size()));
       return;
     }
-    auto it = symbolTable.find(text_or_id);
-    if (it == symbolTable.end())
-      throw runtime_error("Runtime error: WRITE of undeclared identifier " + text_or_id);
-    printValue(out, it->second);
+    printValue(out, activeFrame->slots[slot]);
     out << '\n';
   }
 };
@@ -163,15 +384,15 @@ struct WriteStmt : Statement {
 // -----------------------------------------------------------------------------
 struct Expr {
   virtual ~Expr() = default;
-  virtual void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const = 0;
+  virtual void print_tree(TreePrinter& tp, bool isLast = true) const = 0;
   virtual ValueVariant eval() const = 0;
 };
 
 struct IntLiteral : Expr {
   IntType value;
   explicit IntLiteral(IntType v) : value(v) {}
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, "INT " + to_string(value));
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "INT ", value);
   }
   ValueVariant eval() const override { return value; }
 };
@@ -179,42 +400,41 @@ struct IntLiteral : Expr {
 struct RealLiteral : Expr {
   RealType value;
   explicit RealLiteral(RealType v) : value(v) {}
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, "REAL " + to_string(value));
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "REAL ", value);
   }
   ValueVariant eval() const override { return value; }
 };
 
 struct IdentExpr : Expr {
   string name;
-  explicit IdentExpr(string n) : name(std::move(n)) {}
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, "IDENT " + name);
-  }
-  ValueVariant eval() const override {
-    auto it = symbolTable.find(name);
-    if (it == symbolTable.end()) throw runtime_error("Runtime error: undeclared identifier " + name);
-    return it->second;
+  size_t slot;
+  IdentExpr(string n, size_t s) : name(std::move(n)), slot(s) {}
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "IDENT ", name);
   }
+  ValueVariant eval() const override { return activeFrame->slots[slot]; }
 };
 
 struct UnaryExpr : Expr {
   enum class Op { Plus, Minus };
   Op op; unique_ptr<Expr> child;
   UnaryExpr(Op o, unique_ptr<Expr> e) : op(o), child(std::move(e)) {}
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    string o = (op == Op::Plus) ? "+" : "-";
-    ast_line(os, prefix, isLast, string("Unary(") + o + ")");
-    child->print_tree(os, kid_prefix(prefix, isLast), true);
-  }
-  ValueVariant eval() const override {
-    auto v = child->eval();
-    if (holds_alternative<IntType>(v)) {
-      IntType i = get<IntType>(v);
-      return (op == Op::Plus) ? i : -i;
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "Unary(", op == Op::Plus ? '+' : '-', ")");
+    tp.push(isLast);
+    child->print_tree(tp, true);
+    tp.pop();
+  }
+  ValueVariant eval() const override { return apply(op, child->eval()); }
+  ValueVariant apply(const ValueVariant& v) const { return apply(op, v); }
+  static ValueVariant apply(Op op, const ValueVariant& v) {
+    if (v.isInt()) {
+      IntType i = v.intValue();
+      return (op == Op::Plus) ? i : static_cast<IntType>(0u - static_cast<uint32_t>(i));
     } 
     else {
-      RealType d = get<RealType>(v);
+      RealType d = v.realValue();
       return (op == Op::Plus) ? d : -d;
     }
   }
@@ -223,9 +443,11 @@ struct UnaryExpr : Expr {
 struct NotExpr : Expr {
   unique_ptr<Expr> child;
   explicit NotExpr(unique_ptr<Expr> e) : child(std::move(e)) {}
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, "NOT");
-    child->print_tree(os, kid_prefix(prefix, isLast), true);
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "NOT");
+    tp.push(isLast);
+    child->print_tree(tp, true);
+    tp.pop();
   }
   ValueVariant eval() const override {
     return boolToValue(!isTrueValue(child->eval()));
@@ -233,24 +455,23 @@ struct NotExpr : Expr {
 };
 
 struct PreIncDecExpr : Expr {
-  bool isInc; string name;
-  PreIncDecExpr(bool inc, string n) : isInc(inc), name(std::move(n)) {}
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, string(isInc?"PreInc":"PreDec") + "(" + name + ")");
-  }
-  ValueVariant eval() const override {
-    auto it = symbolTable.find(name);
-    if (it == symbolTable.end()) throw runtime_error("Runtime error: undeclared identifier " + name);
-    if (holds_alternative<IntType>(it->second)) {
-      IntType v = get<IntType>(it->second);
-      v += isInc ? IntType{1} : IntType{-1};
-      it->second = v;
+  bool isInc; string name; size_t slot;
+  PreIncDecExpr(bool inc, string n, size_t s) : isInc(inc), name(std::move(n)), slot(s) {}
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, isInc ? "PreInc(" : "PreDec(", name, ")");
+  }
+  ValueVariant eval() const override { return bump(activeFrame->slots[slot], isInc); }
+  // Steps a VAR's cell by +/-1 in its own type and returns the new value.
+  static ValueVariant bump(ValueVariant& cell, bool isInc) {
+    if (cell.isInt()) {
+      IntType v = static_cast<IntType>(static_cast<uint32_t>(cell.intValue()) + (isInc ? 1u : ~0u));
+      cell = v;
       return v;
     } 
     else {
-      RealType v = get<RealType>(it->second);
+      RealType v = cell.realValue();
       v += isInc ? 1.0 : -1.0;
-      it->second = v;
+      cell = v;
       return v;
     }
   }
@@ -261,33 +482,40 @@ struct BinaryExpr : Expr {
   Op op; unique_ptr<Expr> lhs, rhs;
   BinaryExpr(Op o, unique_ptr<Expr> L, unique_ptr<Expr> R)
     : op(o), lhs(std::move(L)), rhs(std::move(R)) {}
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    string name;
+  static const char* opName(Op op) {
     switch (op) {
-      case Op::Add: name = "+"; break;
-      case Op::Sub: name = "-"; break;
-      case Op::Mul: name = "*"; break;
-      case Op::Div: name = "/"; break;
-      case Op::Mod: name = "MOD"; break;
-      case Op::Pow: name = "^^"; break;
-      case Op::Lt: name = "<"; break;
-      case Op::Gt: name = ">"; break;
-      case Op::Eq: name = "="; break;
-      case Op::Ne: name = "<>"; break;
-      case Op::And: name = "AND"; break;
-      case Op::Or: name = "OR"; break;
+      case Op::Add: return "+";
+      case Op::Sub: return "-";
+      case Op::Mul: return "*";
+      case Op::Div: return "/";
+      case Op::Mod: return "MOD";
+      case Op::Pow: return "^^";
+      case Op::Lt: return "<";
+      case Op::Gt: return ">";
+      case Op::Eq: return "=";
+      case Op::Ne: return "<>";
+      case Op::And: return "AND";
+      case Op::Or: return "OR";
     }
-    ast_line(os, prefix, isLast, string("Bin(") + name + ")");
-    auto kp = kid_prefix(prefix, isLast);
-    lhs->print_tree(os, kp, false);
-    rhs->print_tree(os, kp, true);
+    return "";
+  }
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "Bin(", opName(op), ")");
+    tp.push(isLast);
+    lhs->print_tree(tp, false);
+    rhs->print_tree(tp, true);
+    tp.pop();
+  }
+  // INTEGER + - * wrap modulo 2^32. Done in uint32_t, so overflow is
+  // defined and the -O loop forms (optimize.h) compute the same values.
+  static inline IntType addWrap(IntType a, IntType b) {
+    return static_cast<IntType>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
   }
-  static inline bool anyReal(const ValueVariant& a, const ValueVariant& b){
-    return holds_alternative<RealType>(a) || holds_alternative<RealType>(b);
+  static inline IntType subWrap(IntType a, IntType b) {
+    return static_cast<IntType>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b));
   }
   static inline IntType mulWrap(IntType a, IntType b) {
-    int64_t prod = static_cast<int64_t>(a) * static_cast<int64_t>(b);
-    return static_cast<IntType>(prod);
+    return static_cast<IntType>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b));
   }
   static IntType powInt(IntType base, IntType exp) {
     if (exp == 0) return IntType{1};
@@ -318,124 +546,204 @@ struct BinaryExpr : Expr {
       auto R = rhs->eval();
       return boolToValue(isTrueValue(R));
     }
-    auto A = lhs->eval();
+    auto A = lhs->eval();  // lhs first: ++/-- and runtime errors are ordered
     auto B = rhs->eval();
-    if (op == Op::Mod) {
-      if (!holds_alternative<IntType>(A) || !holds_alternative<IntType>(B))
-        throw runtime_error("Runtime error: MOD requires INTEGER operands");
-      IntType ai = get<IntType>(A);
-      IntType bi = get<IntType>(B);
-      if (bi == 0) throw runtime_error("Runtime error: division by zero in MOD");
-      IntType r = ai % bi;
-      if (r < 0) {
-        IntType divisor = (bi > 0) ? bi : -bi;
-        r += divisor;
+    return apply(op, A, B);
+  }
+  // Every operator but AND/OR (which short-circuit) on evaluated operands.
+  static ValueVariant apply(Op op, const ValueVariant& A, const ValueVariant& B) {
+    // One tag test covers the common INTEGER-op-INTEGER case; everything
+    // below it has at least one REAL operand.
+    if (ValueVariant::bothInt(A, B)) {
+      IntType a = A.intValue();
+      IntType b = B.intValue();
+      switch (op) {
+        case Op::Add: return addWrap(a, b);
+        case Op::Sub: return subWrap(a, b);
+        case Op::Mul: return mulWrap(a, b);
+        case Op::Lt:  return boolToValue(a < b);
+        case Op::Gt:  return boolToValue(a > b);
+        case Op::Eq:  return boolToValue(a == b);
+        case Op::Ne:  return boolToValue(a != b);
+        case Op::Mod: {
+          if (b == 0) throw runtime_error("Runtime error: division by zero in MOD");
+          IntType r = b == -1 ? 0 : a % b;  // INT_MIN % -1 overflows
+          if (r < 0) {
+            IntType divisor = (b > 0) ? b : -b;
+            r += divisor;
+          }
+          return r;
+        }
+        case Op::Pow:
+          if (b < 0) return pow(static_cast<RealType>(a), static_cast<RealType>(b));
+          return powInt(a, b);
+        case Op::Div:
+          if (b == 0) throw runtime_error("Runtime error: division by zero");
+          return static_cast<RealType>(a) / static_cast<RealType>(b);  // always REAL
+        default: break;
       }
-      return r;
+      throw runtime_error("Runtime error: unknown binary op");
     }
-    if (op == Op::Lt) {
-      return boolToValue(asReal(A) < asReal(B));
-    }
-    if (op == Op::Gt) {
-      return boolToValue(asReal(A) > asReal(B));
-    }
-    if (op == Op::Eq) {
-      bool eq;
-      if (holds_alternative<IntType>(A) && holds_alternative<IntType>(B)) {
-        eq = (get<IntType>(A) == get<IntType>(B));
-      } else {
-        eq = approxEqual(asReal(A), asReal(B));
-      }
-      return boolToValue(eq);
+    if (op == Op::Mod) throw runtime_error("Runtime error: MOD requires INTEGER operands");
+    RealType a = asReal(A);
+    RealType b = asReal(B);
+    switch (op) {
+      case Op::Add: return a + b;
+      case Op::Sub: return a - b;
+      case Op::Mul: return a * b;
+      case Op::Lt:  return boolToValue(a < b);
+      case Op::Gt:  return boolToValue(a > b);
+      case Op::Eq:  return boolToValue(approxEqual(a, b));
+      case Op::Ne:  return boolToValue(!approxEqual(a, b));
+      case Op::Pow: return pow(a, b);
+      case Op::Div:
+        if (b == 0.0) throw runtime_error("Runtime error: division by zero");
+        return a / b;  // division always yields REAL
+      default: break;
     }
-    if (op == Op::Ne) {
-      bool eq;
-      if (holds_alternative<IntType>(A) && holds_alternative<IntType>(B)) {
-        eq = (get<IntType>(A) == get<IntType>(B));
-      } else {
-        eq = approxEqual(asReal(A), asReal(B));
+    throw runtime_error("Runtime error: unknown binary op");
+  }
+};
+
+// -----------------------------------------------------------------------------
+// Strength-reduced forms (built only by the -O optimizer)
+// -----------------------------------------------------------------------------
+// Each node evaluates its operand exactly once and prints the same tree as the
+// BinaryExpr it replaced. Integer results agree with BinaryExpr because its
+// + - * (addWrap, mulWrap) and these shifts all work modulo 2^32, where
+// multiplication is associative.
+
+// base ^^ k for an integer literal 0 <= k <= 4.
+struct PowSmallExpr : Expr {
+  unique_ptr<Expr> base; IntType k;
+  PowSmallExpr(unique_ptr<Expr> b, IntType e) : base(std::move(b)), k(e) {}
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "Bin(^^)");
+    tp.push(isLast);
+    base->print_tree(tp, false);
+    tp.line(true, "INT ", k);
+    tp.pop();
+  }
+  ValueVariant eval() const override { return apply(base->eval(), k); }
+  ValueVariant apply(const ValueVariant& A) const { return apply(A, k); }
+  static ValueVariant apply(const ValueVariant& A, IntType k) {
+    if (A.isInt()) {
+      IntType a = A.intValue();
+      switch (k) {
+        case 0: return IntType{1};
+        case 1: return a;
+        case 2: return BinaryExpr::mulWrap(a, a);
+        case 3: return BinaryExpr::mulWrap(BinaryExpr::mulWrap(a, a), a);
+        default: { IntType sq = BinaryExpr::mulWrap(a, a); return BinaryExpr::mulWrap(sq, sq); }
       }
-      return boolToValue(!eq);
     }
-    if (op == Op::Pow) {
-      bool lhsReal = holds_alternative<RealType>(A);
-      bool rhsReal = holds_alternative<RealType>(B);
-      if (!lhsReal && !rhsReal) {
-        IntType base = get<IntType>(A);
-        IntType exponent = get<IntType>(B);
-        if (exponent < 0) {
-          RealType da = static_cast<RealType>(base);
-          RealType db = static_cast<RealType>(exponent);
-          return pow(da, db);
-        }
-        return powInt(base, exponent);
-      }
-      RealType da = lhsReal ? get<RealType>(A) : static_cast<RealType>(get<IntType>(A));
-      RealType db = rhsReal ? get<RealType>(B) : static_cast<RealType>(get<IntType>(B));
-      RealType pd = pow(da, db);
-      return pd;
+    // pow(d, 0) == 1 and pow(d, 1) == d exactly (NaN aside: pow drops its
+    // sign). Squares stay on pow: libm's pow is not correctly rounded, so d*d
+    // can differ from it in the last bit.
+    RealType d = A.realValue();
+    if (k == 0) return RealType{1.0};
+    if (k == 1 && !isnan(d)) return d;
+    return pow(d, static_cast<RealType>(k));
+  }
+};
+
+// lhs MOD d for a literal d = +/-2^s. BinaryExpr's non-negative remainder of
+// a two's complement int is exactly its low s bits.
+struct ModPow2Expr : Expr {
+  unique_ptr<Expr> lhs; IntType divisor; IntType mask;
+  ModPow2Expr(unique_ptr<Expr> L, IntType d)
+    : lhs(std::move(L)), divisor(d), mask((d > 0 ? d : -d) - 1) {}
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "Bin(MOD)");
+    tp.push(isLast);
+    lhs->print_tree(tp, false);
+    tp.line(true, "INT ", divisor);
+    tp.pop();
+  }
+  ValueVariant eval() const override { return apply(lhs->eval(), mask); }
+  ValueVariant apply(const ValueVariant& A) const { return apply(A, mask); }
+  static ValueVariant apply(const ValueVariant& A, IntType mask) {
+    if (!A.isInt())
+      throw runtime_error("Runtime error: MOD requires INTEGER operands");
+    return static_cast<IntType>(A.intValue() & mask);
+  }
+};
+
+// operand * k (or k * operand) for an integer literal k. Powers of two become
+// a shift on INTEGER operands; REAL operands multiply by (double)k as before.
+struct MulConstExpr : Expr {
+  unique_ptr<Expr> operand; IntType k; bool constOnLeft; int shift;
+  MulConstExpr(unique_ptr<Expr> e, IntType c, bool left)
+    : operand(std::move(e)), k(c), constOnLeft(left), shift(-1) {
+    if (k > 0 && (k & (k - 1)) == 0) {
+      shift = 0;
+      while ((IntType{1} << shift) != k) ++shift;
     }
-    if (op == Op::Div) {
-      RealType a = holds_alternative<IntType>(A) ? static_cast<RealType>(get<IntType>(A)) : get<RealType>(A);
-      RealType b = holds_alternative<IntType>(B) ? static_cast<RealType>(get<IntType>(B)) : get<RealType>(B);
-      if (b == 0.0) throw runtime_error("Runtime error: division by zero");
-      return a / b;  // division always yields REAL
+  }
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "Bin(*)");
+    tp.push(isLast);
+    if (constOnLeft) tp.line(false, "INT ", k);
+    operand->print_tree(tp, constOnLeft);
+    if (!constOnLeft) tp.line(true, "INT ", k);
+    tp.pop();
+  }
+  ValueVariant eval() const override { return apply(operand->eval(), k, shift); }
+  ValueVariant apply(const ValueVariant& A) const { return apply(A, k, shift); }
+  static ValueVariant apply(const ValueVariant& A, IntType k, int shift) {
+    if (A.isInt()) {
+      uint32_t a = static_cast<uint32_t>(A.intValue());
+      if (shift >= 0) return static_cast<IntType>(a << shift);
+      return static_cast<IntType>(a * static_cast<uint32_t>(k));
     }
-    // + - * /
-    if (anyReal(A,B)) {
-      RealType a = holds_alternative<IntType>(A) ? static_cast<RealType>(get<IntType>(A)) : get<RealType>(A);
-      RealType b = holds_alternative<IntType>(B) ? static_cast<RealType>(get<IntType>(B)) : get<RealType>(B);
-      switch (op) {
-        case Op::Add: return a + b;
-        case Op::Sub: return a - b;
-        case Op::Mul: return a * b;
-        default: break;
-      }
-    } else {
-      IntType a = get<IntType>(A);
-      IntType b = get<IntType>(B);
-      switch (op) {
-        case Op::Add: return a + b;
-        case Op::Sub: return a - b;
-        case Op::Mul: return a * b;
-        default: break;
-      }
+    return A.realValue() * static_cast<RealType>(k);
+  }
+};
+
+// Loop-invariant subexpression moved out of a WHILE by the -O optimizer. The
+// owning WhileStmt primes the temporary slot once per loop entry; if priming
+// raises a runtime error the slot stays unready and eval() falls back to the
+// original expression, so the error surfaces exactly where it used to (or
+// never, if the loop never reaches it).
+struct HoistedExpr : Expr {
+  unique_ptr<Expr> expr; size_t slot;
+  HoistedExpr(unique_ptr<Expr> e, size_t s) : expr(std::move(e)), slot(s) {}
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    expr->print_tree(tp, isLast);
+  }
+  void prime() const {
+    activeFrame->ready[slot] = 0;
+    try {
+      activeFrame->slots[slot] = expr->eval();
+      activeFrame->ready[slot] = 1;
+    } catch (const runtime_error&) {
     }
-    throw runtime_error("Runtime error: unknown binary op");
+  }
+  ValueVariant eval() const override {
+    if (activeFrame->ready[slot]) return activeFrame->slots[slot];
+    return expr->eval();
   }
 };
 
 struct AssignStmt : Statement {
   string id;
+  size_t slot;
   unique_ptr<Expr> rhs;
 
-  AssignStmt(string id_, unique_ptr<Expr> rhs_)
-    : id(std::move(id_)), rhs(std::move(rhs_)) {}
+  AssignStmt(string id_, size_t slot_, unique_ptr<Expr> rhs_)
+    : id(std::move(id_)), slot(slot_), rhs(std::move(rhs_)) {}
 
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, "Assign " + id + " :=");
-    if (rhs) rhs->print_tree(os, kid_prefix(prefix, isLast), true);
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "Assign ", id, " :=");
+    if (!rhs) return;
+    tp.push(isLast);
+    rhs->print_tree(tp, true);
+    tp.pop();
   }
 
   void interpret(ostream& out) const override {
-    auto itL = symbolTable.find(id);
-    if (itL == symbolTable.end())
-      throw runtime_error("Runtime error: ASSIGN to undeclared identifier " + id);
-
     ValueVariant rv = rhs->eval();
-    if (holds_alternative<IntType>(itL->second)) {
-      // store as integer (truncate if real)
-      IntType v = holds_alternative<IntType>(rv) ? get<IntType>(rv)
-                   : static_cast<IntType>(get<RealType>(rv));
-      itL->second = v;
-    } 
-    else {
-      // store as real (widen int)
-      RealType v = holds_alternative<IntType>(rv)
-                     ? static_cast<RealType>(get<IntType>(rv))
-                     : get<RealType>(rv);
-      itL->second = v;
-    }
+    assignValue(activeFrame->slots[slot], rv);
   }
 };
 
@@ -451,28 +759,42 @@ struct IfStmt : Statement {
       thenBranch(std::move(thenStmt)),
       elseBranch(std::move(elseStmt)) {}
 
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, "IF");
-    string kid = kid_prefix(prefix, isLast);
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "IF");
+    tp.push(isLast);
 
-    ast_line(os, kid, false, "COND");
-    condition->print_tree(os, kid_prefix(kid, false), true);
+    tp.line(false, "COND");
+    tp.push(false);
+    condition->print_tree(tp, true);
+    tp.pop();
 
     bool hasElse = static_cast<bool>(elseBranch);
-    ast_line(os, kid, hasElse ? false : true, "THEN");
-    thenBranch->print_tree(os, kid_prefix(kid, hasElse ? false : true), true);
+    tp.line(!hasElse, "THEN");
+    tp.push(!hasElse);
+    thenBranch->print_tree(tp, true);
+    tp.pop();
 
     if (hasElse) {
-      ast_line(os, kid, true, "ELSE");
-      elseBranch->print_tree(os, kid_prefix(kid, true), true);
+      tp.line(true, "ELSE");
+      tp.push(true);
+      elseBranch->print_tree(tp, true);
+      tp.pop();
     }
+    tp.pop();
   }
 
+  // A checkpoint taken inside a branch notes which one (0 THEN, 1 ELSE).
   void interpret(ostream& out) const override {
-    if (isTrueValue(condition->eval())) {
-      thenBranch->interpret(out);
-    } else if (elseBranch) {
-      elseBranch->interpret(out);
+    bool taken = isTrueValue(condition->eval());
+    try {
+      if (taken) {
+        thenBranch->interpret(out);
+      } else if (elseBranch) {
+        elseBranch->interpret(out);
+      }
+    } catch (CheckpointDue& c) {
+      c.path.push_back(taken ? 0 : 1);
+      throw;
     }
   }
 };
@@ -480,28 +802,42 @@ struct IfStmt : Statement {
 struct WhileStmt : Statement {
   unique_ptr<Expr> condition;
   unique_ptr<Statement> body;
+  vector<const HoistedExpr*> hoisted;  // owned by condition/body, primed on entry
   WhileStmt(unique_ptr<Expr> cond, unique_ptr<Statement> b)
     : condition(std::move(cond)), body(std::move(b)) {}
 
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, "WHILE");
-    string kid = kid_prefix(prefix, isLast);
-    ast_line(os, kid, false, "COND");
-    condition->print_tree(os, kid_prefix(kid, false), true);
-    ast_line(os, kid, true, "BODY");
-    body->print_tree(os, kid_prefix(kid, true), true);
-  }
-
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "WHILE");
+    tp.push(isLast);
+    tp.line(false, "COND");
+    tp.push(false);
+    condition->print_tree(tp, true);
+    tp.pop();
+    tp.line(true, "BODY");
+    tp.push(true);
+    body->print_tree(tp, true);
+    tp.pop();
+    tp.pop();
+  }
+
+  // A checkpoint taken during a trip notes 0: the condition held.
   void interpret(ostream& out) const override {
-    while (isTrueValue(condition->eval())) {
-      body->interpret(out);
+    for (auto* h : hoisted) h->prime();
+    try {
+      while (isTrueValue(condition->eval())) {
+        tick();
+        body->interpret(out);
+      }
+    } catch (CheckpointDue& c) {
+      c.path.push_back(0);
+      throw;
     }
   }
 };
 
 struct SenioritisStmt : Statement {
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, "SENIORITIS");
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "SENIORITIS");
   }
 
   void interpret(ostream& out) const override {
@@ -513,22 +849,31 @@ struct SenioritisStmt : Statement {
 struct CompoundStmt : Statement {
   vector<unique_ptr<Statement>> stmts;  // sequence inside BEGIN ... END
 
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const override {
-    ast_line(os, prefix, isLast, "BEGIN");
-    string kid = kid_prefix(prefix, isLast);
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    tp.line(isLast, "BEGIN");
+    tp.push(isLast);
     if (stmts.empty()) {
-      ast_line(os, kid, true, "(empty)");
+      tp.line(true, "(empty)");
     } else {
       for (size_t i = 0; i < stmts.size(); ++i) {
         bool lastChild = (i + 1 == stmts.size());
-        stmts[i]->print_tree(os, kid, lastChild);
+        stmts[i]->print_tree(tp, lastChild);
       }
     }
-    ast_line(os, prefix, true, "END");
+    tp.pop();
+    tp.line(true, "END");
   }
+  // A checkpoint notes the index of the statement it was taken in.
   void interpret(ostream& out) const override {
-    for (auto& s : stmts) {
-      s->interpret(out);
+    size_t i = 0;
+    try {
+      for (; i < stmts.size(); ++i) {
+        tick();
+        stmts[i]->interpret(out);
+      }
+    } catch (CheckpointDue& c) {
+      c.path.push_back(static_cast<uint32_t>(i));
+      throw;
     }
   }
 };
@@ -547,32 +892,43 @@ struct Block {
   unique_ptr<CompoundStmt> body;         // BEGIN ... END
 
 
-  void print_tree(ostream& os, const string& prefix = "", bool isLast = true) const {
-    ast_line(os, prefix, isLast, "Block");
-    string kid = kid_prefix(prefix, isLast);
+  void print_tree(TreePrinter& tp, bool isLast = true) const {
+    tp.line(isLast, "Block");
+    tp.push(isLast);
 
     if (!decls.empty()) {
       // "VAR" line
-      ast_line(os, kid, !body, "VAR");  
-      string varkid = kid_prefix(kid, !body);  
+      tp.line(!body, "VAR");
+      tp.push(!body);
       for (size_t i = 0; i < decls.size(); ++i) {
         const auto& d = decls[i];
-        string typ = (d.type == Decl::Type::Int) ? "INTEGER" : "REAL";
+        const char* typ = (d.type == Decl::Type::Int) ? "INTEGER" : "REAL";
         bool lastDecl = (i + 1 == decls.size()) && !body;  
-        ast_line(os, varkid, lastDecl, d.name + " : " + typ + ";");
+        tp.line(lastDecl, d.name, " : ", typ, ";");
       }
+      tp.pop();
     }
 
     if (body) {
-      body->print_tree(os, kid, true);  
+      body->print_tree(tp, true);  
     } else if (decls.empty()) {
-      ast_line(os, kid, true, "(empty)");
+      tp.line(true, "(empty)");
     }
+    tp.pop();
   }
 
   void interpret(ostream& out) const {
     if (body) {
-      for (auto& s : body->stmts) s->interpret(out);
+      size_t i = 0;
+      try {
+        for (; i < body->stmts.size(); ++i) {
+          tick();
+          body->stmts[i]->interpret(out);
+        }
+      } catch (CheckpointDue& c) {
+        c.path.push_back(static_cast<uint32_t>(i));
+        throw;
+      }
     }
   }
 };
@@ -582,13 +938,16 @@ struct Program
   unique_ptr<Block> block;
   void print_tree(ostream& os)
   {
-    cout << "Program\n";
-    ast_line(os, "", false, "name: " + name);
-    if (block) block->print_tree(os, "", true);
+    TreePrinter tp(os);
+    tp.raw("Program\n");
+    tp.line(false, "name: ", name);
+    if (block) block->print_tree(tp, true);
     else 
     { 
-      ast_line(os, "", true, "Block"); 
-      ast_line(os, "    ", true, "(empty)");
+      tp.line(true, "Block"); 
+      tp.push(true);
+      tp.line(true, "(empty)");
+      tp.pop();
     }
   }
   void interpret(ostream& out) { if (block) block->interpret(out); }
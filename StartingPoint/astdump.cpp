@@ -0,0 +1,557 @@
+// =============================================================================
+//   astdump.cpp — JSON and binary AST dumps, binary token dump, AST loader
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   The formats are documented in astdump.h. Writers build the whole dump in
+//   one string and write it once; the loader reads the whole file and walks
+//   it with a bounds-checked cursor, building nodes with the same
+//   constructors the parser uses.
+// =============================================================================
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "astdump.h"
+#include "lexer.h"
+using namespace std;
+
+namespace {
+
+enum : uint8_t {
+  // statements
+  K_COMPOUND = 1, K_ASSIGN, K_IF, K_WHILE, K_READ, K_WRITE, K_SENIORITIS,
+  // expressions
+  K_INT = 16, K_REAL, K_IDENT, K_UNARY, K_NOT, K_PREINCDEC, K_BINARY,
+};
+
+constexpr char AST_MAGIC[4] = {'T', 'I', 'P', 'A'};
+constexpr char TOKEN_MAGIC[4] = {'T', 'I', 'P', 'T'};
+
+// -----------------------------------------------------------------------------
+// Binary writer
+// -----------------------------------------------------------------------------
+class BinWriter {
+public:
+  string out;
+
+  void u8(uint8_t v) { out.push_back(static_cast<char>(v)); }
+  void varint(uint64_t v) {
+    while (v >= 0x80) { u8(static_cast<uint8_t>(v | 0x80)); v >>= 7; }
+    u8(static_cast<uint8_t>(v));
+  }
+  void zigzag(int64_t v) { varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); }
+  void real(RealType v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    for (int i = 0; i < 8; ++i) u8(static_cast<uint8_t>(bits >> (8 * i)));
+  }
+  void str(string_view s) {
+    varint(s.size());
+    out.append(s);
+  }
+  void ref(string_view s) {
+    auto [it, fresh] = refs.try_emplace(string(s), refs.size());
+    if (fresh) { varint(0); str(s); }
+    else varint(it->second + 1);
+  }
+
+  void stmt(const Statement* s) {
+    if (auto c = dynamic_cast<const CompoundStmt*>(s)) {
+      head(K_COMPOUND, s);
+      varint(c->stmts.size());
+      for (auto& k : c->stmts) stmt(k.get());
+    } else if (auto a = dynamic_cast<const AssignStmt*>(s)) {
+      head(K_ASSIGN, s);
+      ref(a->id);
+      u8(a->rhs != nullptr);
+      if (a->rhs) expr(a->rhs.get());
+    } else if (auto i = dynamic_cast<const IfStmt*>(s)) {
+      head(K_IF, s);
+      expr(i->condition.get());
+      stmt(i->thenBranch.get());
+      u8(i->elseBranch != nullptr);
+      if (i->elseBranch) stmt(i->elseBranch.get());
+    } else if (auto w = dynamic_cast<const WhileStmt*>(s)) {
+      head(K_WHILE, s);
+      expr(w->condition.get());
+      stmt(w->body.get());
+    } else if (auto r = dynamic_cast<const ReadStmt*>(s)) {
+      head(K_READ, s);
+      ref(r->id);
+    } else if (auto wr = dynamic_cast<const WriteStmt*>(s)) {
+      head(K_WRITE, s);
+      u8(wr->kind == WriteStmt::ArgKind::Id);
+      ref(activePool->text(wr->text));
+    } else if (dynamic_cast<const SenioritisStmt*>(s)) {
+      head(K_SENIORITIS, s);
+    } else {
+      throw runtime_error("--dump-ast: unsupported statement node");
+    }
+  }
+
+  void expr(const Expr* e) {
+    if (auto b = dynamic_cast<const BinaryExpr*>(e)) {
+      u8(K_BINARY);
+      u8(static_cast<uint8_t>(b->op));
+      expr(b->lhs.get());
+      expr(b->rhs.get());
+    } else if (auto id = dynamic_cast<const IdentExpr*>(e)) {
+      u8(K_IDENT);
+      ref(id->name);
+    } else if (auto i = dynamic_cast<const IntLiteral*>(e)) {
+      u8(K_INT);
+      zigzag(i->value);
+    } else if (auto r = dynamic_cast<const RealLiteral*>(e)) {
+      u8(K_REAL);
+      real(r->value);
+    } else if (auto u = dynamic_cast<const UnaryExpr*>(e)) {
+      u8(K_UNARY);
+      u8(u->op == UnaryExpr::Op::Minus);
+      expr(u->child.get());
+    } else if (auto n = dynamic_cast<const NotExpr*>(e)) {
+      u8(K_NOT);
+      expr(n->child.get());
+    } else if (auto p = dynamic_cast<const PreIncDecExpr*>(e)) {
+      u8(K_PREINCDEC);
+      u8(p->isInc);
+      ref(p->name);
+    } else {
+      throw runtime_error("--dump-ast: unsupported expression node");
+    }
+  }
+
+private:
+  unordered_map<string, size_t> refs;
+
+  void head(uint8_t kind, const Statement* s) {
+    u8(kind);
+    varint(static_cast<uint64_t>(s->line > 0 ? s->line : 0));
+  }
+};
+
+// -----------------------------------------------------------------------------
+// Binary reader
+// -----------------------------------------------------------------------------
+class BinReader {
+public:
+  BinReader(const string& data) : p(reinterpret_cast<const unsigned char*>(data.data())),
+                                  limit(p + data.size()) {}
+
+  void magic(const char (&m)[4], uint8_t version, const char* what) {
+    if (static_cast<size_t>(limit - p) < 5 || memcmp(p, m, 4) != 0)
+      throw runtime_error(string("AST load error: not a ") + what);
+    p += 4;
+    if (uint8_t v = u8(); v != version)
+      throw runtime_error("AST load error: unsupported format version " + to_string(v));
+  }
+
+  bool atEnd() const { return p == limit; }
+
+  uint8_t u8() {
+    need(1);
+    return *p++;
+  }
+  uint64_t varint() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t b = u8();
+      v |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if (!(b & 0x80)) return v;
+    }
+    fail("varint too long");
+  }
+  int64_t zigzag() {
+    uint64_t v = varint();
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+  }
+  RealType real() {
+    need(8);
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) bits |= static_cast<uint64_t>(*p++) << (8 * i);
+    RealType v;
+    memcpy(&v, &bits, sizeof v);
+    return v;
+  }
+  string str() {
+    uint64_t n = varint();
+    need(n);
+    string s(reinterpret_cast<const char*>(p), n);
+    p += n;
+    return s;
+  }
+  const string& ref() {
+    uint64_t k = varint();
+    if (k == 0) {
+      refs.push_back(str());
+      return refs.back();
+    }
+    if (k > refs.size()) fail("string reference out of range");
+    return refs[k - 1];
+  }
+
+  unique_ptr<Statement> stmt() {
+    uint8_t kind = u8();
+    uint64_t line = varint();
+    unique_ptr<Statement> s;
+    switch (kind) {
+      case K_COMPOUND: s = compound(); break;
+      case K_ASSIGN: {
+        const string& id = ref();
+        size_t slot = slotOf(id);
+        string name = id;
+        unique_ptr<Expr> rhs = u8() ? expr() : nullptr;
+        s = make_unique<AssignStmt>(std::move(name), slot, std::move(rhs));
+        break;
+      }
+      case K_IF: {
+        auto cond = expr();
+        auto thenBranch = stmt();
+        unique_ptr<Statement> elseBranch = u8() ? stmt() : nullptr;
+        s = make_unique<IfStmt>(std::move(cond), std::move(thenBranch), std::move(elseBranch));
+        break;
+      }
+      case K_WHILE: {
+        auto cond = expr();
+        auto body = stmt();
+        s = make_unique<WhileStmt>(std::move(cond), std::move(body));
+        break;
+      }
+      case K_READ: {
+        const string& id = ref();
+        s = make_unique<ReadStmt>(id, slotOf(id));
+        break;
+      }
+      case K_WRITE: {
+        bool isVar = u8();
+        const string& text = ref();
+        if (isVar) s = make_unique<WriteStmt>(WriteStmt::ArgKind::Id, text, slotOf(text));
+        else       s = make_unique<WriteStmt>(WriteStmt::ArgKind::Str, text);
+        break;
+      }
+      case K_SENIORITIS: s = make_unique<SenioritisStmt>(); break;
+      default: fail("bad statement kind " + to_string(kind));
+    }
+    s->line = static_cast<int>(line);
+    return s;
+  }
+
+  unique_ptr<CompoundStmt> compound() {
+    auto c = make_unique<CompoundStmt>();
+    uint64_t n = varint();
+    for (uint64_t i = 0; i < n; ++i) c->stmts.push_back(stmt());
+    return c;
+  }
+
+  unique_ptr<Expr> expr() {
+    uint8_t kind = u8();
+    switch (kind) {
+      case K_INT: {
+        int64_t v = zigzag();
+        if (v < INT32_MIN || v > INT32_MAX) fail("INT literal out of range");
+        return make_unique<IntLiteral>(static_cast<IntType>(v));
+      }
+      case K_REAL: return make_unique<RealLiteral>(real());
+      case K_IDENT: {
+        const string& id = ref();
+        return make_unique<IdentExpr>(id, slotOf(id));
+      }
+      case K_UNARY: {
+        uint8_t op = u8();
+        if (op > 1) fail("bad unary operator");
+        auto child = expr();
+        return make_unique<UnaryExpr>(op ? UnaryExpr::Op::Minus : UnaryExpr::Op::Plus, std::move(child));
+      }
+      case K_NOT: return make_unique<NotExpr>(expr());
+      case K_PREINCDEC: {
+        bool inc = u8();
+        const string& id = ref();
+        return make_unique<PreIncDecExpr>(inc, id, slotOf(id));
+      }
+      case K_BINARY: {
+        uint8_t op = u8();
+        if (op > static_cast<uint8_t>(BinaryExpr::Op::Or)) fail("bad binary operator");
+        auto lhs = expr();
+        auto rhs = expr();
+        return make_unique<BinaryExpr>(static_cast<BinaryExpr::Op>(op), std::move(lhs), std::move(rhs));
+      }
+      default: fail("bad expression kind " + to_string(kind));
+    }
+  }
+
+  [[noreturn]] void fail(const string& why) const {
+    throw runtime_error("AST load error: " + why);
+  }
+
+private:
+  const unsigned char* p;
+  const unsigned char* limit;
+  vector<string> refs;
+
+  void need(uint64_t n) const {
+    if (static_cast<uint64_t>(limit - p) < n) fail("unexpected end of file");
+  }
+  size_t slotOf(const string& id) const {
+    auto it = symbolTable.find(id);
+    if (it == symbolTable.end()) fail("undeclared identifier " + id);
+    return it->second;
+  }
+};
+
+// -----------------------------------------------------------------------------
+// JSON writer
+// -----------------------------------------------------------------------------
+class JsonWriter {
+public:
+  string out;
+
+  void program(const Program& p) {
+    out += "{\"format\":\"tips-ast\",\"version\":";
+    out += to_string(AST_FORMAT_VERSION);
+    out += ",\"name\":";
+    quoted(p.name);
+    out += ",\"decls\":[";
+    if (p.block) {
+      for (size_t i = 0; i < p.block->decls.size(); ++i) {
+        const Decl& d = p.block->decls[i];
+        out += i ? ",{\"name\":" : "{\"name\":";
+        quoted(d.name);
+        out += d.type == Decl::Type::Int ? ",\"type\":\"INTEGER\"}" : ",\"type\":\"REAL\"}";
+      }
+    }
+    out += "],\"body\":";
+    if (p.block && p.block->body) stmt(p.block->body.get());
+    else out += "null";
+    out += "}\n";
+  }
+
+  void stmt(const Statement* s) {
+    if (auto c = dynamic_cast<const CompoundStmt*>(s)) {
+      head("Compound", s);
+      out += ",\"stmts\":[";
+      for (size_t i = 0; i < c->stmts.size(); ++i) {
+        if (i) out += ',';
+        stmt(c->stmts[i].get());
+      }
+      out += "]}";
+    } else if (auto a = dynamic_cast<const AssignStmt*>(s)) {
+      head("Assign", s);
+      field("id", a->id);
+      out += ",\"rhs\":";
+      if (a->rhs) expr(a->rhs.get());
+      else out += "null";
+      out += '}';
+    } else if (auto i = dynamic_cast<const IfStmt*>(s)) {
+      head("If", s);
+      out += ",\"cond\":";
+      expr(i->condition.get());
+      out += ",\"then\":";
+      stmt(i->thenBranch.get());
+      out += ",\"else\":";
+      if (i->elseBranch) stmt(i->elseBranch.get());
+      else out += "null";
+      out += '}';
+    } else if (auto w = dynamic_cast<const WhileStmt*>(s)) {
+      head("While", s);
+      out += ",\"cond\":";
+      expr(w->condition.get());
+      out += ",\"body\":";
+      stmt(w->body.get());
+      out += '}';
+    } else if (auto r = dynamic_cast<const ReadStmt*>(s)) {
+      head("Read", s);
+      field("id", r->id);
+      out += '}';
+    } else if (auto wr = dynamic_cast<const WriteStmt*>(s)) {
+      head("Write", s);
+      field(wr->kind == WriteStmt::ArgKind::Id ? "id" : "string", activePool->text(wr->text));
+      out += '}';
+    } else if (dynamic_cast<const SenioritisStmt*>(s)) {
+      head("Senioritis", s);
+      out += '}';
+    } else {
+      throw runtime_error("--dump-ast: unsupported statement node");
+    }
+  }
+
+  void expr(const Expr* e) {
+    if (auto b = dynamic_cast<const BinaryExpr*>(e)) {
+      out += "{\"kind\":\"Binary\"";
+      field("op", BinaryExpr::opName(b->op));
+      out += ",\"lhs\":";
+      expr(b->lhs.get());
+      out += ",\"rhs\":";
+      expr(b->rhs.get());
+      out += '}';
+    } else if (auto id = dynamic_cast<const IdentExpr*>(e)) {
+      out += "{\"kind\":\"Ident\"";
+      field("name", id->name);
+      out += '}';
+    } else if (auto i = dynamic_cast<const IntLiteral*>(e)) {
+      out += "{\"kind\":\"Int\",\"value\":";
+      out += to_string(i->value);
+      out += '}';
+    } else if (auto r = dynamic_cast<const RealLiteral*>(e)) {
+      out += "{\"kind\":\"Real\",\"value\":";
+      if (isfinite(r->value)) {
+        char buf[32];
+        snprintf(buf, sizeof buf, "%.17g", r->value);
+        out += buf;
+      } else {
+        out += "null";  // a literal too long for a double
+      }
+      out += '}';
+    } else if (auto u = dynamic_cast<const UnaryExpr*>(e)) {
+      out += "{\"kind\":\"Unary\"";
+      field("op", u->op == UnaryExpr::Op::Plus ? "+" : "-");
+      out += ",\"operand\":";
+      expr(u->child.get());
+      out += '}';
+    } else if (auto n = dynamic_cast<const NotExpr*>(e)) {
+      out += "{\"kind\":\"Not\",\"operand\":";
+      expr(n->child.get());
+      out += '}';
+    } else if (auto p = dynamic_cast<const PreIncDecExpr*>(e)) {
+      out += "{\"kind\":\"PreIncDec\"";
+      field("op", p->isInc ? "++" : "--");
+      field("name", p->name);
+      out += '}';
+    } else {
+      throw runtime_error("--dump-ast: unsupported expression node");
+    }
+  }
+
+private:
+  void head(const char* kind, const Statement* s) {
+    out += "{\"kind\":\"";
+    out += kind;
+    out += "\",\"line\":";
+    out += to_string(s->line);
+  }
+  void field(const char* name, string_view value) {
+    out += ",\"";
+    out += name;
+    out += "\":";
+    quoted(value);
+  }
+  void quoted(string_view s) {
+    out += '"';
+    for (char c : s) {
+      switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\t': out += "\\t"; break;
+        case '\r': out += "\\r"; break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof buf, "\\u%04x", static_cast<unsigned char>(c));
+            out += buf;
+          } else {
+            out += c;
+          }
+      }
+    }
+    out += '"';
+  }
+};
+
+void writeAll(ostream& os, const string& s) {
+  os.write(s.data(), static_cast<streamsize>(s.size()));
+  os.flush();
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+void writeAstJson(const Program& p, ostream& os) {
+  JsonWriter w;
+  w.program(p);
+  writeAll(os, w.out);
+}
+
+void writeAstBinary(const Program& p, ostream& os) {
+  BinWriter w;
+  w.out.append(AST_MAGIC, 4);
+  w.u8(AST_FORMAT_VERSION);
+  w.str(p.name);
+  w.u8(p.block != nullptr);
+  if (p.block) {
+    w.varint(p.block->decls.size());
+    for (const Decl& d : p.block->decls) {
+      w.str(d.name);
+      w.u8(d.type == Decl::Type::Real);
+    }
+    w.u8(p.block->body != nullptr);
+    if (p.block->body) w.stmt(p.block->body.get());
+  }
+  writeAll(os, w.out);
+}
+
+unique_ptr<Program> loadAstBinary(FILE* in) {
+  string data;
+  char chunk[1 << 16];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof chunk, in)) > 0) data.append(chunk, n);
+  return loadAstBinary(data);
+}
+
+unique_ptr<Program> loadAstBinary(const string& data) {
+  BinReader r(data);
+  r.magic(AST_MAGIC, AST_FORMAT_VERSION, "--dump-ast=bin file");
+  auto p = make_unique<Program>();
+  p->name = r.str();
+  if (r.u8()) {
+    p->block = make_unique<Block>();
+    uint64_t count = r.varint();
+    for (uint64_t i = 0; i < count; ++i) {
+      Decl d;
+      d.name = r.str();
+      uint8_t type = r.u8();
+      if (type > 1) r.fail("bad declaration type");
+      d.type = type ? Decl::Type::Real : Decl::Type::Int;
+      size_t slot = d.type == Decl::Type::Int ? varFrame.addSlot(IntType{0})
+                                              : varFrame.addSlot(RealType{0.0});
+      if (!symbolTable.emplace(d.name, slot).second) r.fail("duplicate declaration of " + d.name);
+      p->block->decls.push_back(std::move(d));
+    }
+    if (r.u8()) {
+      if (r.u8() != K_COMPOUND) r.fail("program body is not a compound statement");
+      int line = static_cast<int>(r.varint());
+      p->block->body = r.compound();
+      p->block->body->line = line;
+    }
+  }
+  if (!r.atEnd()) r.fail("trailing bytes after the program");
+  return p;
+}
+
+int writeTokensBinary(ostream& os) {
+  BinWriter w;
+  w.out.append(TOKEN_MAGIC, 4);
+  w.u8(TOKEN_FORMAT_VERSION);
+  int prevLine = 1;
+  int rc = 0;
+  for (;;) {
+    Token t = gLex();
+    w.varint(static_cast<uint64_t>(t));
+    w.varint(static_cast<uint64_t>(yylineno >= prevLine ? yylineno - prevLine : 0));
+    prevLine = yylineno;
+    if (t == IDENT || t == INTLIT || t == FLOATLIT || t == STRINGLIT || t == UNKNOWN)
+      w.str(yytext ? yytext : "");
+    if (t == UNKNOWN) {
+      cerr << "Lexical error near: '" << (yytext ? yytext : "") << "'\n";
+      rc = 2;
+      break;
+    }
+    if (t == TOK_EOF) break;
+  }
+  writeAll(os, w.out);
+  return rc;
+}
@@ -0,0 +1,71 @@
+// =============================================================================
+//   astdump.h — machine-readable AST and token dumps, and the AST loader
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   --dump-ast=json   the parsed tree as one JSON object (below)
+//   --dump-ast=bin    the parsed tree in the binary format below
+//   --dump-tokens=bin the token stream in the binary format below
+//   --load-ast        run (or -p, -O, ...) a --dump-ast=bin file instead of
+//                     parsing source
+//
+//   The dumps are of the tree as parsed, before any -O rewriting. Every
+//   statement carries the source line it starts on.
+//
+//   Binary encoding (both formats): integers are unsigned LEB128 varints,
+//   INT literals are zigzag varints, REALs are the 8 IEEE-754 bytes little
+//   endian, u8 is one byte. A `ref` is a varint k: k = 0 is followed by a
+//   new string (varint length, bytes) that gets the next table index, and
+//   k > 0 names table entry k-1; identifiers and WRITE literals share the
+//   table. A `str` is always inline (varint length, bytes).
+//
+//   AST ("TIPA", u8 version = 1):
+//     str name, u8 hasBlock; if hasBlock: varint #decls, each (str name,
+//     u8 0=INTEGER/1=REAL), u8 hasBody, [stmt body]
+//     stmt = u8 kind, varint line, then by kind:
+//       1 Compound   varint n, n stmts      5 Read        ref id
+//       2 Assign     ref id, u8 hasRhs, [expr]
+//       3 If         expr, stmt, u8 hasElse, [stmt]
+//       4 While      expr, stmt             6 Write       u8 0=literal/1=VAR, ref
+//       7 Senioritis
+//     expr = u8 kind, then by kind:
+//       16 Int   zigzag value               19 Unary      u8 0=+/1=-, expr
+//       17 Real  8 bytes                    20 Not        expr
+//       18 Ident ref name                   21 PreIncDec  u8 1=++/0=--, ref name
+//       22 Binary u8 BinaryExpr::Op, expr lhs, expr rhs
+//
+//   Tokens ("TIPT", u8 version = 1): one record per token, EOF included:
+//   varint token code (lexer.h), varint lines since the previous token, and
+//   for IDENT, INTLIT, FLOATLIT, STRINGLIT and UNKNOWN a str lexeme. An
+//   UNKNOWN record ends the stream, as it ends -t.
+//
+//   JSON: {"format":"tips-ast","version":1,"name":...,"decls":[{"name":...,
+//   "type":"INTEGER"|"REAL"}],"body":stmt|null}, with statements as
+//   {"kind":"Compound"|"Assign"|"If"|"While"|"Read"|"Write"|"Senioritis",
+//   "line":n, ...children by the names above} and expressions as
+//   {"kind":"Int"|"Real"|"Ident"|"Unary"|"Not"|"PreIncDec"|"Binary", ...}.
+// =============================================================================
+#pragma once
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "ast.h"
+
+constexpr uint8_t AST_FORMAT_VERSION = 1;
+constexpr uint8_t TOKEN_FORMAT_VERSION = 1;
+
+void writeAstJson(const Program& p, std::ostream& os);
+void writeAstBinary(const Program& p, std::ostream& os);
+
+// Reads a --dump-ast=bin file and rebuilds the Program, declaring its VARs
+// in symbolTable/varFrame as the parser would. Throws runtime_error on a
+// file that is not a version-1 AST dump, is truncated or malformed, or uses
+// an undeclared identifier.
+std::unique_ptr<Program> loadAstBinary(FILE* in);
+std::unique_ptr<Program> loadAstBinary(const std::string& data);  // the file's bytes
+
+// --dump-tokens=bin: scans yyin with gLex(). Returns 0, or 2 after an
+// UNKNOWN token (reported on stderr like -t does).
+int writeTokensBinary(std::ostream& os);
@@ -0,0 +1,741 @@
+// =============================================================================
+//   batch.cpp — lockstep execution of many runs over lane vectors (--records)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   A batch holds up to LANES runs. Every VAR slot stores one value per lane
+//   (struct of arrays: a VAR's lanes sit in one int32 or double array, as its
+//   declared type fixes), and the tree is walked once per batch with a lane
+//   mask saying which runs take part:
+//     • expressions produce a whole Lanes vector of one type; BinaryExpr on
+//       two INTEGER vectors, or on two vectors with a REAL side, runs a
+//       fixed-width loop over the plain arrays that the compiler turns into
+//       SIMD instructions, otherwise it applies the scalar operator lane by
+//       lane
+//     • IF splits the mask into THEN and ELSE lanes, WHILE keeps iterating
+//       while any lane still passes its condition
+//     • AND/OR evaluate their right operand only on the undecided lanes
+//     • a runtime error takes its lane out of the mask for good, with the
+//       message it would have printed
+//   The walk goes over a tagged copy of the tree built once per LaneRunner.
+//   Each lane reads its record through its own stream and writes to its own
+//   buffer, so apart from timing every lane sees exactly a sequential run.
+//   Once fewer than SCALAR_BELOW lanes are left (a short batch, or the last
+//   lanes of a WHILE the others have left) statements run per lane on a
+//   scratch frame through their ordinary interpret(); so do the statements
+//   built by the optimizer (closed-form and parallel loops) and SENIORITIS.
+//
+//   With threads > 1 every worker thread owns a LaneRunner (its own lane
+//   frames and output buffers) over the shared, read-only Program. Workers
+//   claim whole batches in input order; the calling thread merges finished
+//   batches to `out` in that order. At most WINDOW_PER_THREAD batches per
+//   worker are claimed ahead of the merge, so memory stays bounded however
+//   long the records file is.
+// =============================================================================
+#include <condition_variable>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "batch.h"
+#include "optimize.h"
+using namespace std;
+
+namespace {
+
+constexpr unsigned LANES = 16;  // runs per batch; a SIMD instruction covers 2-8
+constexpr int SCALAR_BELOW = 4;  // fewer live lanes than this run one at a time
+using Mask = uint32_t;
+static_assert(LANES <= 32, "lane masks are 32 bits");
+
+// One value per lane, kept in a plain array of its type: lane loops over
+// int32s or doubles are what the compiler turns into SIMD. VARs keep their
+// declared type, so a vector's lanes almost always share one; when they do
+// not (^^ with a negative exponent on some lanes only) it is Mixed, and
+// `ints` says which lanes are in i[] and which in d[].
+struct Lanes {
+  enum Kind : uint8_t { Ints, Reals, Mixed };
+  Kind kind;
+  Mask ints;
+  alignas(32) IntType i[LANES];
+  alignas(32) RealType d[LANES];
+
+  bool isInt(unsigned l) const { return kind == Ints || (kind == Mixed && (ints >> l & 1)); }
+  ValueVariant at(unsigned l) const {
+    return isInt(l) ? ValueVariant(i[l]) : ValueVariant(d[l]);
+  }
+  void set(unsigned l, const ValueVariant& v) {  // Mixed only
+    if (v.isInt()) {
+      i[l] = v.intValue();
+      ints |= Mask{1} << l;
+    } else {
+      d[l] = v.realValue();
+      ints &= ~(Mask{1} << l);
+    }
+  }
+};
+
+inline Mask bit(unsigned l) { return Mask{1} << l; }
+
+// Lanes whose value is true, among those in m.
+inline Mask truthMask(const Lanes& x, Mask m) {
+  Mask t = 0;
+  if (x.kind == Lanes::Ints) {
+    for (unsigned l = 0; l < LANES; ++l) t |= Mask{x.i[l] != 0} << l;
+  } else if (x.kind == Lanes::Reals) {
+    for (unsigned l = 0; l < LANES; ++l) t |= Mask{fabs(x.d[l]) >= EPSILON} << l;
+  } else {
+    for (unsigned l = 0; l < LANES; ++l) t |= Mask{isTrueValue(x.at(l))} << l;
+  }
+  return t & m;
+}
+
+// Lane l of a VAR's lanes set as assignValue() would set it.
+inline void store(Lanes& cell, unsigned l, const ValueVariant& v) {
+  if (cell.kind == Lanes::Ints) cell.i[l] = v.isInt() ? v.intValue() : static_cast<IntType>(v.realValue());
+  else cell.d[l] = asReal(v);
+}
+
+// The tree as the lane walk sees it: every node it handles gets a record
+// with a tag, built once per LaneRunner, so the per-batch walk is a switch
+// instead of a chain of dynamic_casts (which cost more than a 16-lane
+// kernel does). Children are indices into the same vector; a CompoundStmt's
+// children are the `count` records listed in `kids` from `first`.
+enum class LaneTag : uint8_t {
+  // expressions
+  Binary, ShortCircuit, Ident, IntLit, RealLit, Unary, Not, PreIncDec, PowSmall, ModPow2, MulConst,
+  // statements
+  Compound, Assign, If, While, Read, Write, Output, Scalar,
+};
+
+struct LaneNode {
+  LaneTag tag;
+  uint32_t a = 0, b = 0, c = 0;  // children, or kids range for Compound
+  const void* src = nullptr;     // the tree node
+};
+
+constexpr uint32_t NONE = UINT32_MAX;
+
+class LaneRunner {
+public:
+  explicit LaneRunner(const Program& p) : vars(varFrame.slots.size()) {
+    root = (p.block && p.block->body) ? stmt(p.block->body.get()) : NONE;
+  }
+
+  // Runs the program on lines[0..n) and leaves results in out/error/alive.
+  void run(const vector<string>& lines) {
+    unsigned n = static_cast<unsigned>(lines.size());
+    for (size_t s = 0; s < vars.size(); ++s) {
+      const ValueVariant& init = varFrame.slots[s];
+      Lanes& cell = vars[s];
+      cell.kind = init.isInt() ? Lanes::Ints : Lanes::Reals;
+      for (unsigned l = 0; l < LANES; ++l) store(cell, l, init);
+    }
+    for (unsigned l = 0; l < n; ++l) {
+      in[l].clear();
+      in[l].str(lines[l]);
+      out[l].str("");
+      error[l].clear();
+    }
+    alive = (n == 32) ? ~Mask{0} : bit(n) - 1;
+    if (root != NONE) exec(root, alive);
+  }
+
+  Frame laneFrame(unsigned l) const {
+    Frame f = varFrame;
+    for (size_t s = 0; s < vars.size(); ++s) f.slots[s] = vars[s].at(l);
+    return f;
+  }
+
+  ostringstream out[LANES];
+  string error[LANES];
+  Mask alive = 0;
+
+private:
+  using Op = BinaryExpr::Op;
+
+  vector<LaneNode> plan;
+  vector<uint32_t> kids;
+  uint32_t root = NONE;
+  vector<Lanes> vars;  // slot -> one value per lane, in the VAR's type
+  istringstream in[LANES];
+  Frame scratch;
+
+  // ---------------------------------------------------------------------------
+  // Building the plan
+  // ---------------------------------------------------------------------------
+  uint32_t add(LaneTag t, const void* src, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0) {
+    plan.push_back({t, a, b, c, src});
+    return static_cast<uint32_t>(plan.size() - 1);
+  }
+
+  uint32_t expr(const Expr* e) {
+    if (auto b = dynamic_cast<const BinaryExpr*>(e)) {
+      uint32_t l = expr(b->lhs.get()), r = expr(b->rhs.get());
+      bool sc = b->op == Op::And || b->op == Op::Or;
+      return add(sc ? LaneTag::ShortCircuit : LaneTag::Binary, b, l, r);
+    }
+    if (auto id = dynamic_cast<const IdentExpr*>(e)) return add(LaneTag::Ident, id);
+    if (auto i = dynamic_cast<const IntLiteral*>(e)) return add(LaneTag::IntLit, i);
+    if (auto f = dynamic_cast<const RealLiteral*>(e)) return add(LaneTag::RealLit, f);
+    if (auto h = dynamic_cast<const HoistedExpr*>(e)) return expr(h->expr.get());
+    if (auto u = dynamic_cast<const UnaryExpr*>(e)) return add(LaneTag::Unary, u, expr(u->child.get()));
+    if (auto n = dynamic_cast<const NotExpr*>(e)) return add(LaneTag::Not, n, expr(n->child.get()));
+    if (auto pi = dynamic_cast<const PreIncDecExpr*>(e)) return add(LaneTag::PreIncDec, pi);
+    if (auto p = dynamic_cast<const PowSmallExpr*>(e)) return add(LaneTag::PowSmall, p, expr(p->base.get()));
+    if (auto mp = dynamic_cast<const ModPow2Expr*>(e)) return add(LaneTag::ModPow2, mp, expr(mp->lhs.get()));
+    if (auto mc = dynamic_cast<const MulConstExpr*>(e))
+      return add(LaneTag::MulConst, mc, expr(mc->operand.get()));
+    throw runtime_error("--records: unsupported expression node");
+  }
+
+  uint32_t stmt(const Statement* s) {
+    if (auto c = dynamic_cast<const CompoundStmt*>(s)) {
+      vector<uint32_t> ks;
+      for (auto& k : c->stmts) ks.push_back(stmt(k.get()));
+      uint32_t first = static_cast<uint32_t>(kids.size());
+      kids.insert(kids.end(), ks.begin(), ks.end());
+      return add(LaneTag::Compound, c, first, static_cast<uint32_t>(ks.size()));
+    }
+    if (auto a = dynamic_cast<const AssignStmt*>(s)) return add(LaneTag::Assign, a, expr(a->rhs.get()));
+    if (auto i = dynamic_cast<const IfStmt*>(s)) {
+      uint32_t c = expr(i->condition.get()), t = stmt(i->thenBranch.get());
+      uint32_t e = i->elseBranch ? stmt(i->elseBranch.get()) : NONE;
+      return add(LaneTag::If, i, c, t, e);
+    }
+    if (auto w = dynamic_cast<const WhileStmt*>(s)) {
+      uint32_t c = expr(w->condition.get()), b = stmt(w->body.get());
+      return add(LaneTag::While, w, c, b);
+    }
+    if (auto rd = dynamic_cast<const ReadStmt*>(s)) return add(LaneTag::Read, rd);
+    if (auto wr = dynamic_cast<const WriteStmt*>(s)) return add(LaneTag::Write, wr);
+    if (auto run = dynamic_cast<const OutputRun*>(s)) return add(LaneTag::Output, run);
+    return add(LaneTag::Scalar, s);
+  }
+
+  void kill(unsigned l, const string& msg) {
+    alive &= ~bit(l);
+    error[l] = msg;
+  }
+
+  template <class F>
+  void eachLane(Mask m, F f) {
+    for (; m; m &= m - 1) f(static_cast<unsigned>(__builtin_ctz(m)));
+  }
+
+  // Per-lane scalar step whose runtime errors retire the lane.
+  template <class F>
+  void eachLaneChecked(Mask m, F f) {
+    eachLane(m, [&](unsigned l) {
+      try {
+        f(l);
+      } catch (const runtime_error& e) {
+        kill(l, e.what());
+      }
+    });
+  }
+
+  // ---------------------------------------------------------------------------
+  // Lane vectors
+  // ---------------------------------------------------------------------------
+  static void fill(Lanes& r, IntType x) {
+    r.kind = Lanes::Ints;
+    for (unsigned l = 0; l < LANES; ++l) r.i[l] = x;
+  }
+  static void fill(Lanes& r, RealType x) {
+    r.kind = Lanes::Reals;
+    for (unsigned l = 0; l < LANES; ++l) r.d[l] = x;
+  }
+  static void setTruth(Lanes& r, Mask t) {
+    r.kind = Lanes::Ints;
+    for (unsigned l = 0; l < LANES; ++l) r.i[l] = (t >> l) & 1;
+  }
+  static void load(const Lanes& cell, Lanes& r) {
+    r.kind = cell.kind;
+    if (cell.kind == Lanes::Ints) memcpy(r.i, cell.i, sizeof r.i);
+    else memcpy(r.d, cell.d, sizeof r.d);
+  }
+  // Into the per-lane form, for the scalar operators.
+  static void toMixed(Lanes& r) {
+    if (r.kind == Lanes::Mixed) return;
+    r.ints = r.kind == Lanes::Ints ? ~Mask{0} : 0;
+    r.kind = Lanes::Mixed;
+  }
+  // Back to one type if the lanes in m agree on it.
+  static void settle(Lanes& r, Mask m) {
+    if ((r.ints & m) == m) r.kind = Lanes::Ints;
+    else if ((r.ints & m) == 0) r.kind = Lanes::Reals;
+  }
+  // The scalar `f` on each lane in m, for what has no lane loop.
+  template <class F>
+  void perLane(Lanes& r, Mask m, F f) {
+    toMixed(r);
+    eachLaneChecked(m, [&](unsigned l) { r.set(l, f(r.at(l))); });
+    settle(r, m & alive);
+  }
+  // Lanes in `z` (among m) stop with `msg`.
+  void killWhere(Mask z, Mask m, const char* msg) {
+    eachLane(z & m, [&](unsigned l) { kill(l, msg); });
+  }
+
+  // ---------------------------------------------------------------------------
+  // Expressions
+  // ---------------------------------------------------------------------------
+  void eval(uint32_t n, Mask m, Lanes& r) {
+    const LaneNode& x = plan[n];
+    switch (x.tag) {
+      case LaneTag::Binary: binary(x, m, r); return;
+      case LaneTag::ShortCircuit: shortCircuit(x, m, r); return;
+      case LaneTag::Ident: load(vars[static_cast<const IdentExpr*>(x.src)->slot], r); return;
+      case LaneTag::IntLit: fill(r, static_cast<const IntLiteral*>(x.src)->value); return;
+      case LaneTag::RealLit: fill(r, static_cast<const RealLiteral*>(x.src)->value); return;
+      case LaneTag::Unary: {
+        auto u = static_cast<const UnaryExpr*>(x.src);
+        eval(x.a, m, r);
+        if (u->op == UnaryExpr::Op::Plus) return;
+        if (r.kind == Lanes::Ints)
+          for (unsigned l = 0; l < LANES; ++l) r.i[l] = static_cast<IntType>(0u - static_cast<uint32_t>(r.i[l]));
+        else if (r.kind == Lanes::Reals)
+          for (unsigned l = 0; l < LANES; ++l) r.d[l] = -r.d[l];
+        else
+          for (unsigned l = 0; l < LANES; ++l) r.set(l, u->apply(r.at(l)));
+        return;
+      }
+      case LaneTag::Not:
+        eval(x.a, m, r);
+        setTruth(r, ~truthMask(r, ~Mask{0}));
+        return;
+      case LaneTag::PreIncDec: {
+        auto pi = static_cast<const PreIncDecExpr*>(x.src);
+        Lanes& cell = vars[pi->slot];
+        if (cell.kind == Lanes::Ints) {
+          uint32_t step = pi->isInc ? 1u : ~0u;
+          eachLane(m, [&](unsigned l) { cell.i[l] = static_cast<IntType>(static_cast<uint32_t>(cell.i[l]) + step); });
+        } else {
+          RealType step = pi->isInc ? 1.0 : -1.0;
+          eachLane(m, [&](unsigned l) { cell.d[l] += step; });
+        }
+        load(cell, r);
+        return;
+      }
+      case LaneTag::PowSmall: {
+        auto p = static_cast<const PowSmallExpr*>(x.src);
+        eval(x.a, m, r);
+        perLane(r, m & alive, [&](const ValueVariant& v) { return p->apply(v); });
+        return;
+      }
+      case LaneTag::ModPow2: {
+        auto mp = static_cast<const ModPow2Expr*>(x.src);
+        eval(x.a, m, r);
+        perLane(r, m & alive, [&](const ValueVariant& v) { return mp->apply(v); });
+        return;
+      }
+      case LaneTag::MulConst: {
+        auto mc = static_cast<const MulConstExpr*>(x.src);
+        eval(x.a, m, r);
+        if (r.kind == Lanes::Ints) {
+          uint32_t k = static_cast<uint32_t>(mc->k);
+          for (unsigned l = 0; l < LANES; ++l) r.i[l] = static_cast<IntType>(static_cast<uint32_t>(r.i[l]) * k);
+        } else if (r.kind == Lanes::Reals) {
+          RealType k = static_cast<RealType>(mc->k);
+          for (unsigned l = 0; l < LANES; ++l) r.d[l] *= k;
+        } else {
+          perLane(r, m & alive, [&](const ValueVariant& v) { return mc->apply(v); });
+        }
+        return;
+      }
+      default: throw runtime_error("--records: unsupported expression node");
+    }
+  }
+
+  void shortCircuit(const LaneNode& x, Mask m, Lanes& r) {
+    eval(x.a, m, r);
+    m &= alive;
+    bool isAnd = static_cast<const BinaryExpr*>(x.src)->op == Op::And;
+    Mask t = truthMask(r, m);
+    Mask undecided = isAnd ? t : (m & ~t);
+    Mask result = isAnd ? 0 : t;
+    if (undecided) {
+      Lanes R;
+      eval(x.b, undecided, R);
+      result |= truthMask(R, undecided & alive);
+    }
+    setTruth(r, result);
+  }
+
+  void binary(const LaneNode& x, Mask m, Lanes& r) {
+    Op op = static_cast<const BinaryExpr*>(x.src)->op;
+    Lanes A;
+    eval(x.a, m, A);
+    m &= alive;
+    if (!m) return;
+    eval(x.b, m, r);  // r holds B until the kernel overwrites it
+    m &= alive;
+    if (!m) return;
+
+    if (A.kind == Lanes::Ints && r.kind == Lanes::Ints) {
+      if (intKernel(op, A, r, m)) return;
+    } else if (A.kind != Lanes::Mixed && r.kind != Lanes::Mixed) {
+      if (realKernel(op, A, r, m)) return;
+    }
+    toMixed(A);
+    toMixed(r);
+    eachLaneChecked(m, [&](unsigned l) { r.set(l, BinaryExpr::apply(op, A.at(l), r.at(l))); });
+    settle(r, m & alive);
+  }
+
+  // Straight-line loops over all lanes; lanes outside m compute garbage
+  // that is never read. + - * wrap like BinaryExpr (addWrap etc.).
+  bool intKernel(Op op, const Lanes& A, Lanes& r, Mask m) {
+    const IntType* a = A.i;
+    IntType* b = r.i;
+    switch (op) {
+      case Op::Add:
+        for (unsigned l = 0; l < LANES; ++l) b[l] = BinaryExpr::addWrap(a[l], b[l]);
+        return true;
+      case Op::Sub:
+        for (unsigned l = 0; l < LANES; ++l) b[l] = BinaryExpr::subWrap(a[l], b[l]);
+        return true;
+      case Op::Mul:
+        for (unsigned l = 0; l < LANES; ++l) b[l] = BinaryExpr::mulWrap(a[l], b[l]);
+        return true;
+      case Op::Lt: for (unsigned l = 0; l < LANES; ++l) b[l] = a[l] < b[l]; return true;
+      case Op::Gt: for (unsigned l = 0; l < LANES; ++l) b[l] = a[l] > b[l]; return true;
+      case Op::Eq: for (unsigned l = 0; l < LANES; ++l) b[l] = a[l] == b[l]; return true;
+      case Op::Ne: for (unsigned l = 0; l < LANES; ++l) b[l] = a[l] != b[l]; return true;
+      case Op::Div: {
+        Mask z = 0;
+        for (unsigned l = 0; l < LANES; ++l) z |= Mask{b[l] == 0} << l;
+        killWhere(z, m, "Runtime error: division by zero");
+        for (unsigned l = 0; l < LANES; ++l)
+          r.d[l] = static_cast<RealType>(a[l]) / static_cast<RealType>(b[l]);  // always REAL
+        r.kind = Lanes::Reals;
+        return true;
+      }
+      case Op::Mod:
+        eachLaneChecked(m, [&](unsigned l) { b[l] = BinaryExpr::apply(op, a[l], b[l]).intValue(); });
+        return true;
+      default: return false;  // ^^ may turn REAL on some lanes only
+    }
+  }
+
+  // At least one side REAL: both widened to double.
+  bool realKernel(Op op, const Lanes& A, Lanes& r, Mask m) {
+    alignas(32) RealType a[LANES], b[LANES];
+    if (A.kind == Lanes::Ints) for (unsigned l = 0; l < LANES; ++l) a[l] = A.i[l];
+    else memcpy(a, A.d, sizeof a);
+    if (r.kind == Lanes::Ints) for (unsigned l = 0; l < LANES; ++l) b[l] = r.i[l];
+    else memcpy(b, r.d, sizeof b);
+    RealType* d = r.d;
+    IntType* t = r.i;
+    switch (op) {
+      case Op::Add: for (unsigned l = 0; l < LANES; ++l) d[l] = a[l] + b[l]; break;
+      case Op::Sub: for (unsigned l = 0; l < LANES; ++l) d[l] = a[l] - b[l]; break;
+      case Op::Mul: for (unsigned l = 0; l < LANES; ++l) d[l] = a[l] * b[l]; break;
+      case Op::Div: {
+        Mask z = 0;
+        for (unsigned l = 0; l < LANES; ++l) z |= Mask{b[l] == 0.0} << l;
+        killWhere(z, m, "Runtime error: division by zero");
+        for (unsigned l = 0; l < LANES; ++l) d[l] = a[l] / b[l];
+        break;
+      }
+      case Op::Lt: for (unsigned l = 0; l < LANES; ++l) t[l] = a[l] < b[l]; r.kind = Lanes::Ints; return true;
+      case Op::Gt: for (unsigned l = 0; l < LANES; ++l) t[l] = a[l] > b[l]; r.kind = Lanes::Ints; return true;
+      case Op::Eq:
+        for (unsigned l = 0; l < LANES; ++l) t[l] = approxEqual(a[l], b[l]);
+        r.kind = Lanes::Ints;
+        return true;
+      case Op::Ne:
+        for (unsigned l = 0; l < LANES; ++l) t[l] = !approxEqual(a[l], b[l]);
+        r.kind = Lanes::Ints;
+        return true;
+      default: return false;  // MOD fails and ^^ goes lane by lane
+    }
+    r.kind = Lanes::Reals;
+    return true;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Statements
+  // ---------------------------------------------------------------------------
+  static bool sparse(Mask m) { return __builtin_popcount(m) < SCALAR_BELOW; }
+
+  void exec(uint32_t n, Mask m) {
+    m &= alive;
+    if (!m) return;
+    const LaneNode& x = plan[n];
+    if (sparse(m) && x.tag != LaneTag::Compound) {
+      scalarFallback(static_cast<const Statement*>(x.src), m);
+      return;
+    }
+    switch (x.tag) {
+      case LaneTag::Compound:
+        for (uint32_t k = 0; k < x.b; ++k) exec(kids[x.a + k], m);
+        return;
+      case LaneTag::Assign: {
+        Lanes r;
+        eval(x.a, m, r);
+        m &= alive;
+        Lanes& cell = vars[static_cast<const AssignStmt*>(x.src)->slot];
+        if (cell.kind == Lanes::Ints && r.kind == Lanes::Ints) {
+          for (unsigned l = 0; l < LANES; ++l) cell.i[l] = (m >> l & 1) ? r.i[l] : cell.i[l];
+        } else if (cell.kind == Lanes::Reals && r.kind == Lanes::Reals) {
+          for (unsigned l = 0; l < LANES; ++l) cell.d[l] = (m >> l & 1) ? r.d[l] : cell.d[l];
+        } else {
+          eachLane(m, [&](unsigned l) { store(cell, l, r.at(l)); });
+        }
+        return;
+      }
+      case LaneTag::If: {
+        Lanes c;
+        eval(x.a, m, c);
+        m &= alive;
+        Mask t = truthMask(c, m);
+        if (t) exec(x.b, t);
+        if ((m & ~t) && x.c != NONE) exec(x.c, m & ~t);
+        return;
+      }
+      case LaneTag::While:
+        while (m) {
+          if (sparse(m)) {  // the last few lanes finish the loop one by one
+            scalarFallback(static_cast<const Statement*>(x.src), m);
+            return;
+          }
+          Lanes c;
+          eval(x.a, m, c);
+          m = truthMask(c, m & alive);
+          if (m) exec(x.b, m);
+          m &= alive;
+        }
+        return;
+      case LaneTag::Read: {
+        auto rd = static_cast<const ReadStmt*>(x.src);
+        Lanes& cell = vars[rd->slot];
+        eachLane(m, [&](unsigned l) {
+          if (cell.kind == Lanes::Ints) {
+            IntType v;
+            if (!(in[l] >> v)) kill(l, "Input error: expected INTEGER for " + rd->id);
+            else cell.i[l] = v;
+          } else {
+            RealType v;
+            if (!(in[l] >> v)) kill(l, "Input error: expected REAL for " + rd->id);
+            else cell.d[l] = v;
+          }
+        });
+        return;
+      }
+      case LaneTag::Write: {
+        auto wr = static_cast<const WriteStmt*>(x.src);
+        if (wr->kind == WriteStmt::ArgKind::Str) {
+          string_view r = activePool->rendered(wr->text);
+          eachLane(m, [&](unsigned l) { out[l].write(r.data(), static_cast<streamsize>(r.size())); });
+        } else {
+          const Lanes& cell = vars[wr->slot];
+          eachLane(m, [&](unsigned l) {
+            printValue(out[l], cell.at(l));
+            out[l] << '\n';
+          });
+        }
+        return;
+      }
+      case LaneTag::Output: {
+        auto run = static_cast<const OutputRun*>(x.src);
+        eachLane(m, [&](unsigned l) {
+          out[l].write(run->text.data(), static_cast<streamsize>(run->text.size()));
+          for (const auto& [slot, v] : run->stores) store(vars[slot], l, v);
+        });
+        return;
+      }
+      default:
+        scalarFallback(static_cast<const Statement*>(x.src), m);
+        return;
+    }
+  }
+
+  // Runs `s` on each lane alone: the lane's values go into a scratch frame
+  // that becomes this thread's activeFrame (its record's stream becomes
+  // activeInput), and the results are copied back. Any statement comes here
+  // once fewer than SCALAR_BELOW lanes run it, where a lane vector costs
+  // more than it saves; optimizer loops (closed-form and parallel) and
+  // SENIORITIS always do.
+  void scalarFallback(const Statement* s, Mask m) {
+    Frame* savedFrame = activeFrame;
+    istream* savedInput = activeInput;
+    eachLane(m, [&](unsigned l) {
+      scratch.slots.resize(vars.size());
+      for (size_t k = 0; k < vars.size(); ++k) scratch.slots[k] = vars[k].at(l);
+      scratch.ready = varFrame.ready;
+      activeFrame = &scratch;
+      activeInput = &in[l];
+      try {
+        s->interpret(out[l]);
+      } catch (const runtime_error& e) {
+        kill(l, e.what());
+      } catch (...) {
+        activeFrame = savedFrame;
+        activeInput = savedInput;
+        throw;
+      }
+      activeFrame = savedFrame;
+      activeInput = savedInput;
+      for (size_t k = 0; k < vars.size(); ++k) store(vars[k], l, scratch.slots[k]);
+    });
+  }
+};
+
+// One batch's rendered results, as the merge writes them.
+struct BatchResult {
+  string text;    // WRITE lines and symbol tables, lane after lane
+  string errors;  // "record N: ..." lines
+  size_t failed = 0;
+};
+
+// Runs lines[0..n) (records first+1 .. first+n) and renders the results.
+void runBatch(LaneRunner& runner, const vector<string>& lines, size_t first,
+              const RecordOptions& opts, BatchResult& res) {
+  runner.run(lines);
+  ostringstream text, errors;
+  for (unsigned l = 0; l < lines.size(); ++l) {
+    text << runner.out[l].str();
+    if (runner.alive & bit(l)) {
+      if (opts.symbols) printSymbols(text, runner.laneFrame(l));
+    } else {
+      errors << "record " << first + l + 1 << ": " << runner.error[l] << "\n";
+      ++res.failed;
+    }
+  }
+  res.text = text.str();
+  res.errors = errors.str();
+}
+
+constexpr size_t WINDOW_PER_THREAD = 4;  // batches claimed ahead of the merge
+
+// Worker threads plus an in-order merge on the calling thread. Batch k lives
+// in ring[k % ring.size()] from the moment it is claimed until it is written.
+class ShardedRun {
+public:
+  ShardedRun(const Program& p, istream& records, const RecordOptions& opts)
+      : prog(p), records(records), opts(opts), ring(opts.threads * WINDOW_PER_THREAD) {}
+
+  RecordStats run(ostream& out, ostream& err) {
+    vector<thread> workers;
+    for (unsigned t = 0; t < opts.threads; ++t) workers.emplace_back([this] { work(); });
+
+    RecordStats stats;
+    exception_ptr failure;
+    {
+      unique_lock<mutex> lk(m);
+      while (true) {
+        merged.wait(lk, [this] {
+          return failure_ || (written < claimed && ring[written % ring.size()].done) ||
+                 (inputDone && written == claimed);
+        });
+        if (failure_ || written == claimed) break;
+        Slot& s = ring[written % ring.size()];
+        BatchResult res = std::move(s.result);
+        size_t n = s.lines.size();
+        s.done = false;
+        ++written;
+        lk.unlock();
+        claimable.notify_one();
+        out << res.text;
+        err << res.errors;
+        stats.records += n;
+        stats.failed += res.failed;
+        lk.lock();
+      }
+      failure = failure_;
+      stop = true;
+    }
+    claimable.notify_all();
+    for (auto& t : workers) t.join();
+    if (failure) rethrow_exception(failure);
+    return stats;
+  }
+
+private:
+  struct Slot {
+    vector<string> lines;
+    BatchResult result;
+    bool done = false;
+  };
+
+  const Program& prog;
+  istream& records;
+  const RecordOptions& opts;
+  vector<Slot> ring;
+  mutex m;
+  condition_variable claimable, merged;
+  size_t claimed = 0, written = 0, firstRecord = 0;
+  bool inputDone = false, stop = false;
+  exception_ptr failure_;
+
+  void work() {
+    LaneRunner runner(prog);
+    unique_lock<mutex> lk(m);
+    while (true) {
+      claimable.wait(lk, [this] { return stop || inputDone || claimed < written + ring.size(); });
+      if (stop || inputDone) return;
+      // Reading under the lock keeps batch numbers in file order.
+      size_t k = claimed;
+      Slot& s = ring[k % ring.size()];
+      s.lines.clear();
+      string line;
+      while (s.lines.size() < LANES && getline(records, line)) s.lines.push_back(line);
+      if (s.lines.empty()) {
+        inputDone = true;
+        lk.unlock();
+        merged.notify_all();
+        claimable.notify_all();
+        return;
+      }
+      size_t first = firstRecord;
+      firstRecord += s.lines.size();
+      ++claimed;
+      lk.unlock();
+
+      BatchResult res;
+      exception_ptr err;
+      try {
+        runBatch(runner, s.lines, first, opts, res);
+      } catch (...) {
+        err = current_exception();
+      }
+
+      lk.lock();
+      if (err && !failure_) failure_ = err;
+      s.result = std::move(res);
+      s.done = true;
+      if (k == written || failure_) merged.notify_one();  // the merge waits on batch `written`
+    }
+  }
+};
+
+}  // namespace
+
+RecordStats runRecords(const Program& p, istream& records, ostream& out, ostream& err,
+                       const RecordOptions& opts) {
+  if (opts.threads > 1) return ShardedRun(p, records, opts).run(out, err);
+  RecordStats stats;
+  LaneRunner runner(p);
+  vector<string> lines;
+  string line;
+  while (true) {
+    lines.clear();
+    while (lines.size() < LANES && getline(records, line)) lines.push_back(line);
+    if (lines.empty()) break;
+    BatchResult res;
+    runBatch(runner, lines, stats.records, opts, res);
+    out << res.text;
+    err << res.errors;
+    stats.records += lines.size();
+    stats.failed += res.failed;
+  }
+  return stats;
+}
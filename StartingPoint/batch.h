@@ -0,0 +1,35 @@
+// =============================================================================
+//   batch.h — --records mode: one program run per input line, in lockstep
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Each line of the records file is the whole stdin of one run of the parsed
+//   program. Runs are packed into batches of lanes that execute the tree
+//   together over struct-of-arrays variable storage, and batches may be
+//   sharded across worker threads; see batch.cpp.
+//
+//   Output per record is exactly what a sequential run writes between the
+//   BEGIN INTERPRETATION and INTERPRETATION COMPLETE banners, minus the
+//   SYMBOL TABLE banner: its WRITE lines, then (with -s, if it finished) its
+//   symbol table lines. Records are emitted in input order.
+// =============================================================================
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include "ast.h"
+
+struct RecordOptions {
+  bool symbols = false;  // -s: append each finished record's symbol table
+  unsigned threads = 1;  // worker threads; > 1 shards batches across them
+};
+
+struct RecordStats {
+  size_t records = 0;
+  size_t failed = 0;     // records that stopped on a runtime or input error
+};
+
+// Runs `p` once per line of `records`. A runtime error ends only its own
+// record; it is reported on `err` as "record N: message" (N counts from 1).
+RecordStats runRecords(const Program& p, istream& records, ostream& out, ostream& err,
+                       const RecordOptions& opts);
@@ -0,0 +1,215 @@
+// =============================================================================
+//   budget.h — step, time and output limits (--max-steps, --timeout,
+//              --max-output)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   A step is one statement of a BEGIN ... END (the program's own included)
+//   or one WHILE trip. Every step calls tick(), which only decrements a
+//   thread-local countdown; when the countdown runs out, expired() works out
+//   whether the step limit is reached, reads the clock for the time limit and
+//   hands out the next countdown. With a time limit the clock is read every
+//   CLOCK_EVERY steps, so a run stops within that many steps of its deadline
+//   (a READ waiting for input is not interrupted). Without limits the
+//   countdown never runs out. Loops the optimizer runs in closed form or on
+//   several threads charge the steps of all their trips up front.
+//
+//   The output limit is an OutputLimit buffer in front of the run's output:
+//   it lets exactly that many bytes through, then throws.
+//
+//   Going over a limit throws LimitExceeded, which the driver reports like
+//   any runtime error but exits with EXIT_LIMIT instead of 2.
+//
+//   The same countdown lets a run stop for a checkpoint (checkpoint.h): once
+//   watchCheckpoints() is on, a tick() that reaches expired() also throws
+//   CheckpointDue when SIGTERM has set checkpointWanted or the checkpoint
+//   interval has passed. chargeSteps() never does, so a loop run in closed
+//   form or on threads is never cut in two; the next tick() takes it.
+//
+//   tipsd also has the countdown run out every CLOCK_EVERY steps for a run
+//   whose client is watched (watchClient()), and expired() then polls the
+//   client's socket: once the client has hung up it throws ClientGone, so a
+//   run that neither writes nor has a limit still stops.
+// =============================================================================
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <poll.h>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+struct LimitExceeded : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+constexpr int EXIT_LIMIT = 4;  // parse's exit code (and tipsd's status) for LimitExceeded
+
+// Thrown at a step when a checkpoint is due. Every BEGIN ... END, WHILE and
+// IF it unwinds through appends where it was, so `path` ends up innermost
+// first (see checkpoint.h for what each entry means).
+struct CheckpointDue {
+  std::vector<uint32_t> path;
+};
+
+// Thrown at a step when the watched client has hung up. Not a
+// std::exception, so nothing in the interpreter takes it for a runtime
+// error; it unwinds to the tipsd worker.
+struct ClientGone {};
+
+struct Limits {
+  uint64_t maxSteps = 0;   // --max-steps; 0: none
+  double timeout = 0;      // --timeout, in seconds; 0: none
+  uint64_t maxOutput = 0;  // --max-output, in bytes; 0: none
+  bool any() const { return maxSteps || timeout > 0 || maxOutput; }
+};
+
+namespace budget {
+
+using Clock = std::chrono::steady_clock;
+constexpr int64_t UNLIMITED = std::numeric_limits<int64_t>::max();
+constexpr int64_t CLOCK_EVERY = 1 << 14;  // steps between clock reads
+
+struct State {
+  uint64_t maxSteps = 0;
+  uint64_t spent = 0;       // steps before the current countdown
+  int64_t grant = UNLIMITED;  // what the current countdown started from
+  double timeout = 0;
+  Clock::time_point deadline;
+  bool checkpoints = false;  // watchCheckpoints() is on
+  double every = 0;          // seconds between checkpoints; 0: on SIGTERM only
+  Clock::time_point nextCheckpoint;
+  int client = -1;           // watchClient()'s socket; -1: none
+};
+
+inline thread_local int64_t left = UNLIMITED;  // steps until expired()
+inline thread_local State state;
+inline volatile std::sig_atomic_t checkpointWanted = 0;  // set by the SIGTERM handler
+
+inline int64_t nextGrant() {
+  int64_t g = state.timeout > 0 || state.checkpoints || state.client >= 0 ? CLOCK_EVERY : UNLIMITED;
+  if (state.maxSteps) g = std::min<int64_t>(g, static_cast<int64_t>(state.maxSteps - state.spent));
+  return g;
+}
+
+// The peer of socket `fd` has closed its end.
+inline bool hungUp(int fd) {
+  pollfd p{fd, 0, 0};
+  return poll(&p, 1, 0) > 0 && (p.revents & (POLLHUP | POLLERR));
+}
+
+// The countdown ran out (left < 0): throws if a limit is passed or the
+// watched client is gone, else starts the next countdown and, at a step,
+// throws if a checkpoint is due.
+[[gnu::noinline]] inline void expired(bool atStep = true) {
+  state.spent += static_cast<uint64_t>(state.grant - left);
+  if (state.maxSteps && state.spent > state.maxSteps)
+    throw LimitExceeded("Limit exceeded: more than " + std::to_string(state.maxSteps) +
+                        " steps (--max-steps)");
+  Clock::time_point now;
+  if (state.timeout > 0 || state.every > 0) now = Clock::now();
+  if (state.timeout > 0 && now >= state.deadline) {
+    char secs[32];
+    snprintf(secs, sizeof secs, "%g", state.timeout);
+    throw LimitExceeded(std::string("Limit exceeded: still running after ") + secs + " s (--timeout)");
+  }
+  if (state.client >= 0 && hungUp(state.client)) throw ClientGone{};
+  state.grant = left = nextGrant();
+  if (atStep && state.checkpoints && (checkpointWanted || (state.every > 0 && now >= state.nextCheckpoint))) {
+    if (state.every > 0) state.nextCheckpoint = now + std::chrono::duration_cast<Clock::duration>(
+                                                          std::chrono::duration<double>(state.every));
+    throw CheckpointDue{};
+  }
+}
+
+// Starts counting this thread's steps and time against `limits`.
+inline void start(const Limits& limits) {
+  state = State{};
+  state.maxSteps = limits.maxSteps;
+  state.timeout = limits.timeout;
+  if (limits.timeout > 0)
+    state.deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double>(limits.timeout));
+  state.grant = left = nextGrant();
+}
+
+// From now on, also stop for a checkpoint on SIGTERM and, if every > 0,
+// every `every` seconds. Call after start().
+inline void watchCheckpoints(double every) {
+  state.spent += static_cast<uint64_t>(state.grant - left);
+  state.checkpoints = true;
+  state.every = every;
+  if (every > 0) state.nextCheckpoint = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                                           std::chrono::duration<double>(every));
+  state.grant = left = nextGrant();
+}
+
+// From now on, also stop with ClientGone once the other end of socket `fd`
+// hangs up. Call after start().
+inline void watchClient(int fd) {
+  state.spent += static_cast<uint64_t>(state.grant - left);
+  state.client = fd;
+  state.grant = left = nextGrant();
+}
+
+// Lifts this thread's limits (checkpoints, watched client) again.
+inline void stop() {
+  state = State{};
+  left = UNLIMITED;
+}
+
+}  // namespace budget
+
+inline void tick() {
+  if (--budget::left < 0) budget::expired();
+}
+
+// n steps at once (n >= 0), for loops that do not step.
+inline void chargeSteps(int64_t n) {
+  if ((budget::left -= std::min(n, budget::UNLIMITED / 2)) < 0) budget::expired(false);
+}
+
+// Output buffer that passes at most `limit` bytes on to `target` and throws
+// LimitExceeded on the next one. Streams over it need exceptions(badbit) so
+// the exception reaches the caller, and pubsync() on the buffer itself
+// pushes out what it holds even after the stream has gone bad.
+class OutputLimit : public std::streambuf {
+public:
+  OutputLimit(std::streambuf* target, uint64_t limit) : target(target), limit(limit), room(limit) { reset(); }
+
+protected:
+  int_type overflow(int_type c) override {
+    flushBuf();
+    if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+    if (room == 0)
+      throw LimitExceeded("Limit exceeded: more than " + std::to_string(limit) +
+                          " bytes of output (--max-output)");
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+  }
+  int sync() override {
+    flushBuf();
+    return target->pubsync();
+  }
+
+private:
+  std::streambuf* target;
+  uint64_t limit;
+  uint64_t room;  // bytes that may still be passed on, buffered ones included
+  char buf[8192];
+
+  void reset() { setp(buf, buf + std::min<uint64_t>(sizeof buf, room)); }
+  void flushBuf() {
+    auto n = pptr() - pbase();
+    if (n > 0) target->sputn(pbase(), n);
+    room -= static_cast<uint64_t>(n);
+    reset();
+  }
+};
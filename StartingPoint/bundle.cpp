@@ -0,0 +1,151 @@
+// =============================================================================
+//   bundle.cpp — reading and writing the program appended to an executable
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   The layout is documented in bundle.h. readBundle() runs at every start,
+//   so it looks at the trailer first and reads nothing more for a plain
+//   interpreter, and a start that cannot open its own file is just a
+//   start without a bundle.
+// =============================================================================
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+#include "astdump.h"
+#include "bundle.h"
+using namespace std;
+
+namespace {
+
+constexpr char BUNDLE_MAGIC[8] = {'T', 'I', 'P', 'S', 'B', 'N', 'D', 'L'};
+constexpr long TRAILER_SIZE = 16;  // u64 size + magic
+
+struct FileCloser {
+  void operator()(FILE* f) const { fclose(f); }
+};
+using File = unique_ptr<FILE, FileCloser>;
+
+File openOrThrow(const char* path, const char* mode) {
+  File f(fopen(path, mode));
+  if (!f) throw runtime_error(string("bundle: cannot open ") + path + ": " + strerror(errno));
+  return f;
+}
+
+// Size of the bundle in `f` (flags + ast), or 0 if it carries none; leaves
+// `f` wherever it pleases. `fileSize` is set either way.
+uint64_t bundleSize(FILE* f, long& fileSize) {
+  if (fseek(f, 0, SEEK_END) != 0 || (fileSize = ftell(f)) < 0)
+    throw runtime_error("bundle: cannot seek in the executable");
+  if (fileSize < TRAILER_SIZE) return 0;
+  unsigned char trailer[TRAILER_SIZE];
+  if (fseek(f, fileSize - TRAILER_SIZE, SEEK_SET) != 0 ||
+      fread(trailer, 1, sizeof trailer, f) != sizeof trailer)
+    throw runtime_error("bundle: cannot read the executable");
+  if (memcmp(trailer + 8, BUNDLE_MAGIC, sizeof BUNDLE_MAGIC) != 0) return 0;
+  uint64_t size = 0;
+  for (int i = 7; i >= 0; --i) size = (size << 8) | trailer[i];
+  if (size > static_cast<uint64_t>(fileSize - TRAILER_SIZE))
+    throw runtime_error("bundle: the appended program is cut short");
+  return size;
+}
+
+void writeOrThrow(FILE* f, const void* data, size_t n, const char* out) {
+  if (fwrite(data, 1, n, f) != n) throw runtime_error(string("bundle: cannot write ") + out);
+}
+
+}  // namespace
+
+string selfExecutable(const char* argv0) {
+#ifdef __APPLE__
+  uint32_t size = 0;
+  _NSGetExecutablePath(nullptr, &size);
+  string path(size, '\0');
+  if (_NSGetExecutablePath(&path[0], &size) == 0) return path.c_str();
+#else
+  if (access("/proc/self/exe", R_OK) == 0) return "/proc/self/exe";
+#endif
+  if (!argv0 || !*argv0) return "";
+  if (strchr(argv0, '/')) return argv0;
+  const char* dirs = getenv("PATH");
+  for (const char* p = dirs ? dirs : ""; *p;) {  // the shell found it there
+    const char* colon = strchr(p, ':');
+    string dir(p, colon ? colon : p + strlen(p));
+    string path = (dir.empty() ? string(".") : dir) + "/" + argv0;
+    if (access(path.c_str(), X_OK) == 0) return path;
+    if (!colon) break;
+    p = colon + 1;
+  }
+  return "";
+}
+
+bool readBundle(const string& exe, Bundle& out) {
+  File f(exe.empty() ? nullptr : fopen(exe.c_str(), "rb"));
+  if (!f) return false;
+  long fileSize = 0;
+  uint64_t size = bundleSize(f.get(), fileSize);
+  if (size == 0) return false;
+
+  string data(size, '\0');
+  if (fseek(f.get(), fileSize - TRAILER_SIZE - static_cast<long>(size), SEEK_SET) != 0 ||
+      fread(&data[0], 1, size, f.get()) != size)
+    throw runtime_error("bundle: cannot read the appended program");
+
+  size_t pos = 0;
+  for (;;) {
+    size_t nul = data.find('\0', pos);
+    if (nul == string::npos) throw runtime_error("bundle: the appended program is cut short");
+    if (nul == pos) break;
+    out.flags.emplace_back(data, pos, nul - pos);
+    pos = nul + 1;
+  }
+  out.ast.assign(data, pos + 1, string::npos);
+  return true;
+}
+
+void writeBundle(const string& exe, const char* out, const vector<string>& flags, const Program& p) {
+  if (exe.empty()) throw runtime_error("bundle: cannot find the interpreter's executable");
+  File in = openOrThrow(exe.c_str(), "rb");
+  long fileSize = 0;
+  uint64_t carried = bundleSize(in.get(), fileSize);
+  long base = carried ? fileSize - TRAILER_SIZE - static_cast<long>(carried) : fileSize;
+
+  string payload;
+  for (const string& f : flags) { payload += f; payload += '\0'; }
+  payload += '\0';
+  ostringstream ast;
+  writeAstBinary(p, ast);
+  payload += ast.str();
+
+  File dst = openOrThrow(out, "wb");
+  if (fseek(in.get(), 0, SEEK_SET) != 0) throw runtime_error("bundle: cannot seek in the executable");
+  char chunk[1 << 16];
+  for (long left = base; left > 0;) {
+    size_t n = fread(chunk, 1, static_cast<size_t>(min<long>(left, sizeof chunk)), in.get());
+    if (n == 0) throw runtime_error("bundle: cannot read the executable");
+    writeOrThrow(dst.get(), chunk, n, out);
+    left -= static_cast<long>(n);
+  }
+  writeOrThrow(dst.get(), payload.data(), payload.size(), out);
+  unsigned char trailer[TRAILER_SIZE];
+  uint64_t size = payload.size();
+  for (int i = 0; i < 8; ++i) trailer[i] = static_cast<unsigned char>(size >> (8 * i));
+  memcpy(trailer + 8, BUNDLE_MAGIC, sizeof BUNDLE_MAGIC);
+  writeOrThrow(dst.get(), trailer, sizeof trailer, out);
+  if (fclose(dst.release()) != 0) throw runtime_error(string("bundle: cannot write ") + out);
+
+  struct stat st;
+  mode_t mode = stat(exe.c_str(), &st) == 0 ? (st.st_mode & 0777) : 0755;
+  chmod(out, mode | 0111);
+}
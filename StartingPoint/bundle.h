@@ -0,0 +1,45 @@
+// =============================================================================
+//   bundle.h — self-contained executables (--bundle OUT)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   `parse [run flags] --bundle OUT prog.tips` parses prog.tips and writes
+//   OUT: a copy of the interpreter with the program appended. Run, OUT
+//   finds the program at the end of its own file, loads the tree and
+//   interprets it; nothing is scanned or parsed. The run flags given with
+//   --bundle (-s, -O, --opt-report, --flat, --threads=N, --max-steps=N,
+//   --timeout=SEC, --max-output=N) are stored with it and apply before any
+//   given to OUT itself.
+//
+//   Appended to the interpreter's bytes:
+//     flags    each stored flag NUL-terminated, then one more NUL
+//     ast      the program as --dump-ast=bin writes it (astdump.h)
+//     u64      little-endian size of flags + ast
+//     "TIPSBNDL"
+//   Bundling from a bundle replaces the program it carries.
+// =============================================================================
+#pragma once
+#include <string>
+#include <vector>
+#include "ast.h"
+
+struct Bundle {
+  std::vector<std::string> flags;  // run flags stored by --bundle
+  std::string ast;                 // --dump-ast=bin bytes, for loadAstBinary()
+};
+
+// The file of the running interpreter: /proc/self/exe on Linux,
+// _NSGetExecutablePath() on macOS, else `argv0` (looked up in PATH if it
+// names no directory). Empty if none of them finds it.
+std::string selfExecutable(const char* argv0);
+
+// Reads the bundle appended to the executable `exe`. False if it carries
+// none or cannot be opened (an empty `exe` included); throws runtime_error
+// if it cannot be read once open or the bundle is cut.
+bool readBundle(const std::string& exe, Bundle& out);
+
+// Writes `out`: `exe` without any bundle of its own, then `flags` and `p`.
+// Throws runtime_error on I/O failure or if `exe` is empty.
+void writeBundle(const std::string& exe, const char* out, const std::vector<std::string>& flags,
+                 const Program& p);
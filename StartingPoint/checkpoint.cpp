@@ -0,0 +1,394 @@
+// =============================================================================
+//   checkpoint.cpp — snapshot files, resuming from a path, counted stdio
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   See checkpoint.h. resumeProgram() mirrors CompoundStmt, WhileStmt and
+//   IfStmt::interpret for the statements on the path only, and catches
+//   CheckpointDue the same way they do, so a snapshot taken while it runs
+//   gets the same path a fresh run would have given it.
+// =============================================================================
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checkpoint.h"
+#include "hashing.h"
+#include "optimize.h"
+using namespace std;
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[4] = {'T', 'I', 'P', 'K'};
+void putVarint(string& out, uint64_t v) {
+  for (; v >= 0x80; v >>= 7) out.push_back(static_cast<char>(v | 0x80));
+  out.push_back(static_cast<char>(v));
+}
+
+// Reads a snapshot's fields in order; any read past the end throws.
+class Reader {
+public:
+  Reader(const string& data, const string& file, size_t start) : data(data), file(file), p(start) {}
+
+  uint8_t u8() {
+    need(1);
+    return static_cast<uint8_t>(data[p++]);
+  }
+  uint64_t u64() {
+    need(8);
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | static_cast<unsigned char>(data[p + i]);
+    p += 8;
+    return v;
+  }
+  uint64_t varint() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t b = u8();
+      v |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if (!(b & 0x80)) return v;
+    }
+    bad();
+  }
+  size_t at() const { return p; }
+  [[noreturn]] void bad() const { throw runtime_error("Snapshot " + file + " is damaged"); }
+
+private:
+  const string& data;
+  const string& file;
+  size_t p;
+
+  void need(size_t n) const {
+    if (data.size() - p < n) bad();
+  }
+};
+
+[[noreturn]] void misfit() {
+  throw runtime_error("Snapshot does not fit this program");
+}
+
+void resumeStmt(const Statement* s, const vector<uint32_t>& path, size_t d, ostream& out);
+
+// The rest of a BEGIN ... END from the statement path[d] names.
+void resumeStmts(const vector<unique_ptr<Statement>>& stmts, const vector<uint32_t>& path, size_t d,
+                 ostream& out) {
+  size_t i = path[d];
+  if (i >= stmts.size()) misfit();
+  try {
+    resumeStmt(stmts[i].get(), path, d + 1, out);
+    for (++i; i < stmts.size(); ++i) {
+      tick();
+      stmts[i]->interpret(out);
+    }
+  } catch (CheckpointDue& c) {
+    c.path.push_back(static_cast<uint32_t>(i));
+    throw;
+  }
+}
+
+void resumeStmt(const Statement* s, const vector<uint32_t>& path, size_t d, ostream& out) {
+  if (d == path.size()) {
+    s->interpret(out);
+    return;
+  }
+  if (auto* c = dynamic_cast<const CountedLoop*>(s)) s = c->loop.get();
+  if (auto* c = dynamic_cast<const CompoundStmt*>(s)) {
+    resumeStmts(c->stmts, path, d, out);
+  } else if (auto* w = dynamic_cast<const WhileStmt*>(s)) {
+    if (path[d] != 0) misfit();
+    try {
+      resumeStmt(w->body.get(), path, d + 1, out);
+      while (isTrueValue(w->condition->eval())) {
+        tick();
+        w->body->interpret(out);
+      }
+    } catch (CheckpointDue& c) {
+      c.path.push_back(0);
+      throw;
+    }
+  } else if (auto* f = dynamic_cast<const IfStmt*>(s)) {
+    if (path[d] > 1 || (path[d] == 1 && !f->elseBranch)) misfit();
+    try {
+      resumeStmt(path[d] == 0 ? f->thenBranch.get() : f->elseBranch.get(), path, d + 1, out);
+    } catch (CheckpointDue& c) {
+      c.path.push_back(path[d]);
+      throw;
+    }
+  } else {
+    misfit();
+  }
+}
+
+void onTerm(int) { budget::checkpointWanted = 1; }
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+// Snapshot files
+// -----------------------------------------------------------------------------
+uint64_t programHash(string_view source, const string& skin, string_view flags) {
+  string format(SNAPSHOT_MAGIC, sizeof SNAPSHOT_MAGIC);
+  format.push_back(static_cast<char>(SNAPSHOT_VERSION));
+  return programKey(format, source, skin, flags);
+}
+
+void saveSnapshot(const string& file, const Snapshot& snap) {
+  string data(SNAPSHOT_MAGIC, sizeof SNAPSHOT_MAGIC);
+  data.push_back(static_cast<char>(SNAPSHOT_VERSION));
+  putU64(data, snap.program);
+  putVarint(data, snap.inputOffset);
+  putU64(data, snap.inputHash);
+  putVarint(data, snap.outputOffset);
+  putVarint(data, snap.path.size());
+  for (uint32_t e : snap.path) putVarint(data, e);
+  putVarint(data, snap.frame.slots.size());
+  for (size_t i = 0; i < snap.frame.slots.size(); ++i) {
+    const ValueVariant& v = snap.frame.slots[i];
+    uint8_t ready = snap.frame.ready[i] ? 2 : 0;
+    if (v.isInt()) {
+      data.push_back(static_cast<char>(0 | ready));
+      uint32_t n = static_cast<uint32_t>(v.intValue());
+      putVarint(data, (n << 1) ^ (0u - (n >> 31)));  // zigzag
+    } else {
+      data.push_back(static_cast<char>(1 | ready));
+      RealType r = v.realValue();
+      uint64_t bits;
+      memcpy(&bits, &r, sizeof bits);
+      putU64(data, bits);
+    }
+  }
+  putU64(data, fnv::hash(data));
+
+  // Written and synced aside, then renamed over FILE: a crash at any point
+  // leaves the previous snapshot or this one.
+  string tmp = file + ".tmp";
+  int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) throw runtime_error("Cannot write snapshot " + tmp + ": " + strerror(errno));
+  bool ok = write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()) && fsync(fd) == 0;
+  int err = errno;
+  if (close(fd) != 0 && ok) { ok = false; err = errno; }
+  if (!ok || rename(tmp.c_str(), file.c_str()) != 0) {
+    if (ok) err = errno;
+    unlink(tmp.c_str());
+    throw runtime_error("Cannot write snapshot " + file + ": " + strerror(err));
+  }
+}
+
+Snapshot loadSnapshot(const string& file) {
+  ifstream f(file, ios::binary);
+  if (!f) throw runtime_error("Cannot open snapshot " + file + ": " + strerror(errno));
+  string data((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
+  if (data.size() < 5 || memcmp(data.data(), SNAPSHOT_MAGIC, 4) != 0)
+    throw runtime_error(file + " is not a snapshot");
+  if (static_cast<uint8_t>(data[4]) != SNAPSHOT_VERSION)
+    throw runtime_error("Snapshot " + file + " has format version " + to_string(static_cast<uint8_t>(data[4])) +
+                        "; this interpreter reads version " + to_string(SNAPSHOT_VERSION));
+  Reader body(data, file, 5);
+  if (data.size() < 13 || Reader(data, file, data.size() - 8).u64() != fnv::hash(string_view(data).substr(0, data.size() - 8)))
+    body.bad();
+  data.resize(data.size() - 8);
+
+  Snapshot s;
+  s.program = body.u64();
+  s.inputOffset = body.varint();
+  s.inputHash = body.u64();
+  s.outputOffset = body.varint();
+  uint64_t n = body.varint();
+  if (n > data.size()) body.bad();
+  for (uint64_t i = 0; i < n; ++i) {
+    uint64_t e = body.varint();
+    if (e > UINT32_MAX) body.bad();
+    s.path.push_back(static_cast<uint32_t>(e));
+  }
+  uint64_t m = body.varint();
+  if (m > data.size()) body.bad();
+  for (uint64_t i = 0; i < m; ++i) {
+    uint8_t tag = body.u8();
+    if (tag > 3) body.bad();
+    ValueVariant v;
+    if (tag & 1) {
+      uint64_t bits = body.u64();
+      RealType r;
+      memcpy(&r, &bits, sizeof r);
+      v = r;
+    } else {
+      uint64_t z = body.varint();
+      if (z > UINT32_MAX) body.bad();
+      uint32_t u = static_cast<uint32_t>(z);
+      v = static_cast<IntType>((u >> 1) ^ (0u - (u & 1)));
+    }
+    s.frame.addSlot(v);
+    s.frame.ready.back() = (tag & 2) != 0;
+  }
+  if (body.at() != data.size()) body.bad();
+  return s;
+}
+
+void resumeProgram(const Program& prog, const vector<uint32_t>& path, ostream& out) {
+  if (path.empty()) {
+    if (prog.block) prog.block->interpret(out);
+    return;
+  }
+  if (!prog.block || !prog.block->body) misfit();
+  resumeStmts(prog.block->body->stmts, path, 0, out);
+}
+
+// -----------------------------------------------------------------------------
+// CountedInput / CountedOutput
+// -----------------------------------------------------------------------------
+CountedInput::CountedInput(int fd) : fd(fd), hashBefore(fnv::BASIS) {
+  setg(buf, buf, buf);
+}
+
+uint64_t CountedInput::hash() const {
+  return fnv::hash(string_view(eback(), static_cast<size_t>(gptr() - eback())), hashBefore);
+}
+
+CountedInput::int_type CountedInput::underflow() {
+  if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+  size_t held = static_cast<size_t>(egptr() - eback());
+  hashBefore = fnv::hash(string_view(eback(), held), hashBefore);
+  before += held;
+  ssize_t got;
+  do got = ::read(fd, buf, sizeof buf);
+  while (got < 0 && errno == EINTR);
+  setg(buf, buf, buf + (got > 0 ? got : 0));
+  if (got <= 0) return traits_type::eof();
+  return traits_type::to_int_type(*gptr());
+}
+
+bool CountedInput::skip(uint64_t n, uint64_t h) {
+  while (offset() < n) {
+    if (gptr() == egptr() && traits_type::eq_int_type(underflow(), traits_type::eof())) return false;
+    uint64_t take = min<uint64_t>(n - offset(), static_cast<uint64_t>(egptr() - gptr()));
+    gbump(static_cast<int>(take));
+  }
+  return hash() == h;
+}
+
+void CountedOutput::flushBuf() {
+  auto n = pptr() - pbase();
+  if (n > 0) target->sputn(pbase(), n);
+  flushed += static_cast<uint64_t>(n);
+  setp(buf, buf + sizeof buf);
+}
+
+CountedOutput::int_type CountedOutput::overflow(int_type c) {
+  flushBuf();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+int CountedOutput::sync() {
+  flushBuf();
+  return target->pubsync();
+}
+
+// -----------------------------------------------------------------------------
+// CheckpointedRun
+// -----------------------------------------------------------------------------
+CheckpointedRun::CheckpointedRun(const CheckpointOptions& opts)
+  : opts(opts), input(0), inputStream(&input), output(cout.rdbuf()), stdoutBuf(cout.rdbuf()) {
+  if (opts.resume) {
+    Snapshot s = loadSnapshot(opts.resume);
+    if (s.program != opts.program)
+      throw runtime_error(string("Snapshot ") + opts.resume + " was taken of another program (or with "
+                          "other -O, -s, --threads, --load-ast or --skin)");
+    if (s.frame.slots.size() != varFrame.slots.size()) misfit();
+    if (!input.skip(s.inputOffset, s.inputHash))
+      throw runtime_error("Input does not match the snapshot: its first " + to_string(s.inputOffset) +
+                          " bytes are not the ones the stopped run read");
+    // A file the stopped run wrote to goes back to what it had written
+    // when the snapshot was taken.
+    struct stat st;
+    cout.flush();
+    if (fstat(1, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+      if (static_cast<uint64_t>(st.st_size) < s.outputOffset)
+        throw runtime_error("stdout holds " + to_string(st.st_size) + " bytes, fewer than the " +
+                            to_string(s.outputOffset) + " the stopped run had written");
+      if (ftruncate(1, static_cast<off_t>(s.outputOffset)) != 0 ||
+          lseek(1, static_cast<off_t>(s.outputOffset), SEEK_SET) < 0)
+        throw runtime_error(string("Cannot cut stdout back to the snapshot: ") + strerror(errno));
+    }
+    varFrame = std::move(s.frame);
+    output.startAt(s.outputOffset);
+    path = std::move(s.path);
+  }
+  cout.rdbuf(&output);
+  activeInput = &inputStream;
+  if (!opts.file.empty()) {
+    struct sigaction sa {};
+    sa.sa_handler = onTerm;
+    sa.sa_flags = SA_RESTART;  // a READ waiting for input goes on waiting
+    sigemptyset(&sa.sa_mask);
+    budget::checkpointWanted = 0;
+    handling = sigaction(SIGTERM, &sa, &oldTerm) == 0;
+  }
+}
+
+CheckpointedRun::~CheckpointedRun() {
+  if (handling) sigaction(SIGTERM, &oldTerm, nullptr);
+  output.pubsync();
+  cout.rdbuf(stdoutBuf);
+  activeInput = &cin;
+}
+
+void CheckpointedRun::snapshot(ostream& out) {
+  out.flush();
+  cout.flush();
+  fsync(1);  // a file's bytes up to the output offset outlast a crash too
+  Snapshot s;
+  s.program = opts.program;
+  s.inputOffset = input.offset();
+  s.inputHash = input.hash();
+  s.outputOffset = output.written();
+  s.path = path;
+  s.frame = *activeFrame;
+  saveSnapshot(opts.file, s);
+}
+
+// A periodic snapshot that cannot be written is reported and skipped (the
+// previous one stays); one on SIGTERM is an error, and FILE is kept.
+bool CheckpointedRun::run(const Program& prog, ostream& out, const Limits& limits) {
+  budget::start(limits);
+  if (!opts.file.empty()) budget::watchCheckpoints(opts.every);
+  for (;;) {
+    try {
+      resumeProgram(prog, path, out);
+      break;
+    } catch (CheckpointDue& c) {
+      path.assign(c.path.rbegin(), c.path.rend());
+      bool stopping = budget::checkpointWanted;
+      try {
+        snapshot(out);
+      } catch (const runtime_error& e) {
+        if (stopping) {
+          budget::stop();
+          throw;
+        }
+        cerr << e.what() << " (going on)\n";
+      }
+      if (stopping) {
+        budget::stop();
+        return false;
+      }
+    } catch (...) {
+      budget::stop();
+      if (!opts.file.empty()) unlink(opts.file.c_str());
+      throw;
+    }
+  }
+  budget::stop();
+  if (!opts.file.empty()) unlink(opts.file.c_str());
+  return true;
+}
@@ -0,0 +1,153 @@
+// =============================================================================
+//   checkpoint.h — snapshots of a running program (--checkpoint, --resume)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   A snapshot is everything a run needs to go on from one of its steps:
+//   the variable frame, where it is in the statement tree, how many input
+//   bytes READ has taken and how many output bytes it has written. With
+//   --checkpoint=FILE a run writes one to FILE when SIGTERM arrives (and
+//   then exits) and, with --checkpoint-every=SEC, every SEC seconds while
+//   it goes on. `--resume FILE` starts the same program from it; its output
+//   continues the stopped run's, so the two together print exactly what an
+//   uninterrupted run prints.
+//
+//   The position is taken by unwinding: at its next step (budget.h) the
+//   run throws CheckpointDue, and each BEGIN ... END, WHILE and IF it
+//   passes adds an entry, read outermost first as
+//     BEGIN ... END  the index of the statement the run was in
+//     WHILE          0: in a trip whose condition held
+//     IF             0: in THEN, 1: in ELSE
+//   A path that ends at a statement means "run it from its start". After a
+//   periodic snapshot the run descends the path again (resumeProgram) and
+//   carries on in the same process. Conditions that were already tested
+//   are never tested again, so ++/-- in them happen once.
+//
+//   A loop -O replaced (CountedLoop) has no entry of its own: a snapshot
+//   inside it was taken in its stepping WHILE, which the path then names.
+//   A READ waiting for input is not interrupted; the snapshot follows it.
+//
+//   The input offset comes with a hash of the bytes before it, and a
+//   resumed run reads its stdin past them, stopping if they differ. If
+//   stdout is a non-empty regular file it is cut back to the output offset
+//   first, which drops what the stopped run wrote after its snapshot.
+//
+//   FILE: "TIPK", u8 version, u64 program hash, varint input offset, u64
+//   input hash, varint output offset, varint n + n varint path entries,
+//   varint m + m slots (u8 tag: 0 INTEGER, 1 REAL, +2 ready temporary; an
+//   INTEGER as a zigzag varint, a REAL as 8 bytes), u64 FNV-1a of all that.
+//   u64s are little endian. The program hash (programKey(), hashing.h)
+//   covers the source, the skin and the flags that shape the tree (-O, -s
+//   with -O, --threads, --load-ast), so a snapshot only resumes the program
+//   that wrote it.
+// =============================================================================
+#pragma once
+#include <csignal>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.h"
+
+constexpr uint8_t SNAPSHOT_VERSION = 2;  // 2: program keys hash field lengths
+constexpr int EXIT_CHECKPOINTED = 128 + SIGTERM;  // stopped by SIGTERM, snapshot written
+
+struct Snapshot {
+  uint64_t program = 0;       // programHash() of the run
+  uint64_t inputOffset = 0;   // bytes READ has taken
+  uint64_t inputHash = 0;     // FNV-1a of those bytes
+  uint64_t outputOffset = 0;  // bytes written to stdout
+  std::vector<uint32_t> path; // outermost first
+  Frame frame;
+};
+
+uint64_t programHash(std::string_view source, const std::string& skin, std::string_view flags);
+
+// Both throw runtime_error naming the file if it cannot be written or read.
+// saveSnapshot() replaces FILE by rename(), so it always holds a whole one.
+void saveSnapshot(const std::string& file, const Snapshot& snap);
+Snapshot loadSnapshot(const std::string& file);
+
+// Goes on with `prog` from `path` (activeFrame already holds the frame).
+// Throws runtime_error if the path does not fit the tree.
+void resumeProgram(const Program& prog, const std::vector<uint32_t>& path, std::ostream& out);
+
+// READ input from a file descriptor that counts and hashes what the stream
+// has taken.
+class CountedInput : public std::streambuf {
+public:
+  explicit CountedInput(int fd);
+  uint64_t offset() const { return before + static_cast<uint64_t>(gptr() - eback()); }
+  uint64_t hash() const;
+  // Takes the first n bytes; false if there are fewer or their hash is not h.
+  bool skip(uint64_t n, uint64_t h);
+
+protected:
+  int_type underflow() override;
+
+private:
+  int fd;
+  uint64_t before = 0;  // bytes taken before buf
+  uint64_t hashBefore;  // and their FNV-1a
+  char buf[1 << 16];
+};
+
+// Output to `target` that counts the bytes written through it.
+class CountedOutput : public std::streambuf {
+public:
+  explicit CountedOutput(std::streambuf* target) : target(target) { setp(buf, buf + sizeof buf); }
+  uint64_t written() const { return flushed + static_cast<uint64_t>(pptr() - pbase()); }
+  void startAt(uint64_t n) { flushed = n; }
+
+protected:
+  int_type overflow(int_type c) override;
+  int sync() override;
+
+private:
+  std::streambuf* target;
+  uint64_t flushed = 0;
+  char buf[8192];
+  void flushBuf();
+};
+
+struct CheckpointOptions {
+  std::string file;              // --checkpoint=FILE; empty: none written
+  double every = 0;              // --checkpoint-every=SEC
+  const char* resume = nullptr;  // --resume SNAPSHOT
+  uint64_t program = 0;          // programHash() of what runs
+};
+
+// One run with checkpoints. While it exists cout writes through a
+// CountedOutput and activeInput reads stdin through a CountedInput.
+class CheckpointedRun {
+public:
+  // With opts.resume: loads the snapshot into varFrame and lines stdin and
+  // stdout up with it. Throws runtime_error if it is not this program's or
+  // the input does not match.
+  explicit CheckpointedRun(const CheckpointOptions& opts);
+  ~CheckpointedRun();
+
+  bool resumed() const { return opts.resume != nullptr; }
+
+  // Interprets `prog` (from the snapshot, if resumed) with WRITE output to
+  // `out`, an ostream writing into cout's buffer. True when the program
+  // ran to its end; false when SIGTERM stopped it and a snapshot was
+  // written. A run that ends, by finishing or by an error, removes FILE.
+  bool run(const Program& prog, std::ostream& out, const Limits& limits);
+
+private:
+  CheckpointOptions opts;
+  CountedInput input;
+  std::istream inputStream;
+  CountedOutput output;
+  std::streambuf* stdoutBuf;
+  std::vector<uint32_t> path;  // where to go on from; empty: the start
+  struct sigaction oldTerm {};
+  bool handling = false;
+
+  void snapshot(std::ostream& out);
+};
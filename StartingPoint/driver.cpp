@@ -10,8 +10,10 @@
 // used in this course project:
 //   (1) Lexing  - optional token dump (-t)
 //   (2) Parsing - optional AST print (-p)
-//   (3) Interpreting the parsed Program
-//   (4) Optional symbol table printing (-s) [Part 2]
+//   (3) Optional optimization of the parsed Program (-O, --threads=N)
+//   (4) Interpreting the parsed Program (once, or once per line of a
+//       --records file; with --checkpoint/--resume, from and to snapshots)
+//   (5) Optional symbol table printing (-s) [Part 2]
 //
 // Note: Flex returns 0 on EOF; we map this to TOK_EOF so token dumps
 // are consistent and easy to interpret.
@@ -22,31 +24,44 @@
 //       name : TYPE = value
 //       counter : INTEGER = 42
 //
-// TODO [Part 4]:
-//   - Validate --skin=NAME against a known list from the scanner (e.g. default,
-//     INITIAL, pirate, cat). If unknown, show suggestions.
-//   - Consider a --list-skins flag that queries the scanner for available skins.
+// Keyword skins (--skin=NAME, --list-skins) live in skins.cpp; the scanner
+// looks every word up in the active skin's keyword table.
 // =============================================================================
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <map>
-#include <variant>
+#include <sstream>
 #include <string>
+#include <vector>
 #include "lexer.h"  // Scanner functions: yylex, yyin, yylineno, yytext, tokName()
 #include "debug.h"  // Debug flag support: dbg::set(bool)
 #include "ast.h"    // Program AST type with interpret() and print_symbols()
+#include "optimize.h" // optimizeProgram() for -O
+#include "batch.h"    // runRecords() for --records=FILE
+#include "flatast.h"  // flatten() for --flat
+#include "skins.h"    // selectSkin()/listSkins() for --skin, --list-skins
+#include "simdscan.h" // simdLex() for --scanner=simd
+#include "pipeline.h" // TokenPipeline for --pipeline
+#include "astdump.h"  // --dump-ast, --dump-tokens=bin, --load-ast
+#include "lazy.h"     // startLazyParse() for --lazy
+#include "bundle.h"   // readBundle(), writeBundle() for --bundle
+#include "resultcache.h" // ResultCache for --result-cache=DIR
+#include "checkpoint.h"  // CheckpointedRun for --checkpoint, --resume
 using namespace std;
 // -----------------------------------------------------------------------------
 // Scanner Skin Bridge
 // -----------------------------------------------------------------------------
-// gSkinC is a global pointer used by the scanner to select a keyword “skin.”
+// gSkinC names the keyword “skin” in effect; selectSkin() loads its table.
 // Example: --skin=pirate switches keywords to their pirate equivalents.
 // gSkinStorage must stay alive so gSkinC remains a valid C-style string.
 // -----------------------------------------------------------------------------
 extern "C" const char* gSkinC;
-extern map<string, ValueVariant> symbolTable;
+extern map<string, size_t> symbolTable;
 string gSkinStorage = "default";
 const char* gSkinC = gSkinStorage.c_str();
 
@@ -57,6 +72,22 @@ unique_ptr<Program> parseProgram();
 // Command-line flags
 // -----------------------------------------------------------------------------
 bool FLAG_TOKENS=false, FLAG_PRINT_AST=false, FLAG_SYMBOLS=false; // -t, -p, -s
+bool FLAG_OPTIMIZE=false, FLAG_OPT_REPORT=false;                  // -O, --opt-report
+bool FLAG_FLAT=false;                                             // --flat
+bool FLAG_LIST_SKINS=false;                                       // --list-skins
+bool FLAG_PIPELINE=false;                                         // --pipeline
+bool FLAG_TOKENS_BIN=false, FLAG_LOAD_AST=false;                  // --dump-tokens=bin, --load-ast
+bool FLAG_LAZY=false, FLAG_STRICT=false;                          // --lazy, --strict
+const char* gDumpAst = nullptr;                                   // --dump-ast=json|bin
+const char* gBundleOut = nullptr;                                 // --bundle OUT
+string gSelfExe;                                                  // this interpreter's file (bundle.h)
+unsigned gThreads = 1;                                            // --threads=N
+const char* gRecordsFile = nullptr;                               // --records=FILE
+const char* gResultCache = nullptr;                               // --result-cache=DIR
+Limits gLimits;                                                   // --max-steps, --timeout, --max-output
+const char* gCheckpoint = nullptr;                                // --checkpoint=FILE
+double gCheckpointEvery = 0;                                      // --checkpoint-every=SEC
+const char* gResume = nullptr;                                    // --resume SNAPSHOT
 
 // -----------------------------------------------------------------------------
 // ANSI color codes for nicer output 
@@ -82,8 +113,48 @@ void usage(const char* prog)
          << "  -p            Print AST after parse\n"
          << "  -t            Tokenize only (dump tokens) and exit\n"
          << "  -s            Print symbol table after interpretation\n"
+         << "  -O            Optimize the AST before interpretation\n"
+         << "  --opt-report  With -O/--threads, report how each loop runs to stderr\n"
+         << "  --threads=N   Run reduction-only loops on N threads (with --records:\n"
+         << "                run records on N threads)\n"
+         << "  --records=FILE  Run once per line of FILE (the line is that run's\n"
+         << "                input); outputs follow in line order\n"
+         << "  --flat        Print (-p) and run from the compact index-based AST\n"
          << "  -d            Enable debug traces to stderr\n"
-         << "  --skin=NAME   Select keyword skin (default, INITIAL, pirate, cat)\n"
+         << "  --skin=NAME   Select keyword skin (default, INITIAL, pirate, cat, or\n"
+         << "                a skin file of KEYWORD SPELLING lines)\n"
+         << "  --list-skins  List the loaded skins and their keywords, then exit\n"
+         << "  --scanner=S   Scan with flex (default) or simd, the hand-written\n"
+         << "                vectorized scanner\n"
+         << "  --pipeline    Scan on a separate thread, feeding the parser through\n"
+         << "                a lock-free token ring\n"
+         << "  --dump-ast=F  Write the parsed AST as F = json or bin to stdout and exit\n"
+         << "  --dump-tokens=bin  Write the token stream in binary to stdout and exit\n"
+         << "  --load-ast    The input is a --dump-ast=bin file instead of source\n"
+         << "  --lazy        Parse nested BEGIN ... END bodies when first run; syntax\n"
+         << "                errors in bodies never run go unreported (plain runs\n"
+         << "                only: no effect with -p, -O, --flat, --threads, --records,\n"
+         << "                the dumps or the checkpoint flags)\n"
+         << "  --strict      Report every syntax error before running, even with\n"
+         << "                --lazy (which then parses the whole program up front)\n"
+         << "  --bundle OUT  Write OUT, this interpreter with the parsed program (and\n"
+         << "                -s, -O, --opt-report, --flat, --threads=N and the limits)\n"
+         << "                built in, then exit; OUT runs it without parsing\n"
+         << "  --max-steps=N  Stop a run after N steps (statements of BEGIN ... END\n"
+         << "                and WHILE trips)\n"
+         << "  --timeout=SEC  Stop a run still interpreting after SEC seconds\n"
+         << "  --max-output=N  Stop a run when it writes more than N bytes\n"
+         << "                (a stopped run exits with code 4; not with --records)\n"
+         << "  --result-cache=DIR  Store each run's output and symbol table in DIR;\n"
+         << "                a later run of the same program file on the same input\n"
+         << "                prints them without running (not with -p, -t, --records,\n"
+         << "                --opt-report, -d, the dumps or the checkpoint flags)\n"
+         << "  --checkpoint=FILE  On SIGTERM, write a snapshot of the run to FILE\n"
+         << "                and exit (code 143); the run removes FILE when it ends\n"
+         << "  --checkpoint-every=SEC  Also write one every SEC seconds and go on\n"
+         << "  --resume SNAPSHOT  Go on from SNAPSHOT with the same program and input;\n"
+         << "                the output continues the stopped run's (stdout, if a file,\n"
+         << "                is first cut back to where the snapshot was taken)\n"
          << "  --help        Show this help\n\n"
          << "Example: " << prog << " --skin=pirate samples/hello.tips -p\n";
 }
@@ -91,7 +162,7 @@ void usage(const char* prog)
 // -----------------------------------------------------------------------------
 // Token dump routine for -t mode
 // -----------------------------------------------------------------------------
-// Repeatedly calls yylex() to get tokens, then prints them with line numbers
+// Repeatedly calls gLex() to get tokens, then prints them with line numbers
 // and lexemes. Only IDENT and STRINGLIT show their lexeme to keep output compact.
 // If UNKNOWN appears, we exit immediately with a nonzero code.
 // -----------------------------------------------------------------------------
@@ -100,7 +171,7 @@ int dumpTokens()
     banner("BEGIN TOKENIZE", C_YBOLD);
     while (true)
     {
-        int t = yylex();
+        int t = gLex();
         if (t == 0) t = TOK_EOF;
         cout << yylineno << " " << tokName(t);
         if (t == IDENT || t == STRINGLIT)
@@ -117,6 +188,56 @@ int dumpTokens()
     return 0;
 }
 
+// -----------------------------------------------------------------------------
+// Program keys for --result-cache and --checkpoint
+// -----------------------------------------------------------------------------
+// readAll() reads the rest of `f`. treeFlags() spells out the flags that
+// decide which tree a run walks: -O, --load-ast, --threads=N and -s where
+// -O keeps symbols for it. Both features put them in their programKey()
+// (hashing.h), so they agree on what counts as the same program.
+// -----------------------------------------------------------------------------
+string readAll(FILE* f)
+{
+    string data;
+    char buf[1 << 16];
+    for (size_t n; (n = fread(buf, 1, sizeof buf, f)) > 0;) data.append(buf, n);
+    return data;
+}
+
+string treeFlags()
+{
+    string key;
+    if (FLAG_OPTIMIZE) key += " -O";
+    if (FLAG_LOAD_AST) key += " --load-ast";
+    if (gThreads > 1) key += " --threads=" + to_string(gThreads);
+    if ((FLAG_OPTIMIZE || gThreads > 1) && FLAG_SYMBOLS) key += " -s";
+    return key;
+}
+
+// -----------------------------------------------------------------------------
+// Replay of a stored run for --result-cache
+// -----------------------------------------------------------------------------
+// Prints what the interpretation phase printed when the run was stored and
+// returns the exit code it ended with.
+// -----------------------------------------------------------------------------
+int replayRun(const CachedRun& run)
+{
+    banner("BEGIN INTERPRETATION", C_YBOLD);
+    cout << run.output;
+    if (run.failed)
+    {
+        cerr << run.error << "\n";
+        return 2;
+    }
+    if (FLAG_SYMBOLS) {
+        banner("SYMBOL TABLE", C_CYAN);
+        cout << run.symbols;
+    }
+    banner("INTERPRETATION COMPLETE", C_YBOLD);
+    banner("Program executed successfully", C_GREEN);
+    return 0;
+}
+
 // -----------------------------------------------------------------------------
 // main()
 // -----------------------------------------------------------------------------
@@ -127,59 +248,398 @@ int main(int argc, char** argv)
 {
     const char* infile = nullptr;
 
+    // A bundle (--bundle) carries its program and run flags; the flags go
+    // ahead of the ones given on this command line.
+    Bundle bundle;
+    bool bundled = false;
+    gSelfExe = selfExecutable(argc > 0 ? argv[0] : nullptr);
+    try { bundled = readBundle(gSelfExe, bundle); }
+    catch (const exception& e) { cerr << e.what() << "\n"; return 1; }
+    vector<char*> args(argv, argv + argc);
+    for (size_t k = 0; k < bundle.flags.size(); ++k)
+        args.insert(args.begin() + 1 + k, &bundle.flags[k][0]);
+    vector<string> bundleFlags;  // the run flags, for --bundle
+
     // Parse command-line args
-    for (int i = 1; i < argc; ++i)
+    for (size_t i = 1; i < args.size(); ++i)
     {
-        const char* a = argv[i];
+        const char* a = args[i];
+        if (!strcmp(a, "-s") || !strcmp(a, "-O") || !strcmp(a, "--opt-report") ||
+            !strcmp(a, "--flat") || !strncmp(a, "--threads=", 10) || !strncmp(a, "--max-steps=", 12) ||
+            !strncmp(a, "--timeout=", 10) || !strncmp(a, "--max-output=", 13))
+            bundleFlags.emplace_back(a);
         if (!strcmp(a, "-p")) FLAG_PRINT_AST = true;
         else if (!strcmp(a, "-t")) FLAG_TOKENS = true;
         else if (!strcmp(a, "-s")) FLAG_SYMBOLS = true;
+        else if (!strcmp(a, "-O")) FLAG_OPTIMIZE = true;
+        else if (!strcmp(a, "--opt-report")) FLAG_OPT_REPORT = true;
+        else if (!strcmp(a, "--flat")) FLAG_FLAT = true;
+        else if (!strncmp(a, "--threads=", 10))
+        {
+            char* end = nullptr;
+            long n = strtol(a + 10, &end, 10);
+            if (end == a + 10 || *end || n < 1 || n > 256)
+            {
+                cerr << "Invalid thread count: " << (a + 10) << "\n";
+                return 1;
+            }
+            gThreads = static_cast<unsigned>(n);
+        }
+        else if (!strncmp(a, "--records=", 10)) gRecordsFile = a + 10;
+        else if (!strncmp(a, "--max-steps=", 12) || !strncmp(a, "--max-output=", 13))
+        {
+            const char* v = strchr(a, '=') + 1;
+            char* end = nullptr;
+            unsigned long long n = strtoull(v, &end, 10);
+            if (end == v || *end || *v == '-' || n == 0)
+            {
+                cerr << "Invalid limit: " << a << "\n";
+                return 1;
+            }
+            (a[6] == 's' ? gLimits.maxSteps : gLimits.maxOutput) = n;
+        }
+        else if (!strncmp(a, "--timeout=", 10))
+        {
+            char* end = nullptr;
+            double t = strtod(a + 10, &end);
+            if (end == a + 10 || *end || !(t > 0) || t > 1e9)
+            {
+                cerr << "Invalid timeout: " << (a + 10) << "\n";
+                return 1;
+            }
+            gLimits.timeout = t;
+        }
+        else if (!strncmp(a, "--result-cache=", 15) && a[15]) gResultCache = a + 15;
+        else if (!strncmp(a, "--checkpoint=", 13) && a[13]) gCheckpoint = a + 13;
+        else if (!strncmp(a, "--checkpoint-every=", 19))
+        {
+            char* end = nullptr;
+            double t = strtod(a + 19, &end);
+            if (end == a + 19 || *end || !(t > 0) || t > 1e9)
+            {
+                cerr << "Invalid checkpoint interval: " << (a + 19) << "\n";
+                return 1;
+            }
+            gCheckpointEvery = t;
+        }
+        else if (!strcmp(a, "--resume"))
+        {
+            if (i + 1 == args.size()) { cerr << "--resume needs a snapshot file\n"; return 1; }
+            gResume = args[++i];
+        }
         else if (!strcmp(a, "-d")) dbg::set(true);
-        else if (!strncmp(a, "--skin=", 8))
+        else if (!strncmp(a, "--skin=", 7))
         {
-            gSkinStorage = string(a + 8);
+            gSkinStorage = string(a + 7);
             gSkinC = gSkinStorage.c_str();
         }
+        else if (!strcmp(a, "--list-skins")) FLAG_LIST_SKINS = true;
+        else if (!strcmp(a, "--scanner=flex")) gLex = yylex;
+        else if (!strcmp(a, "--scanner=simd"))
+        {
+            gLex = simdLex;
+            dbg::line(string("scanner: simd, ") + simdLexWidth() + " blocks");
+        }
+        else if (!strcmp(a, "--pipeline")) FLAG_PIPELINE = true;
+        else if (!strcmp(a, "--dump-ast=json") || !strcmp(a, "--dump-ast=bin")) gDumpAst = a + 11;
+        else if (!strcmp(a, "--dump-tokens=bin")) FLAG_TOKENS_BIN = true;
+        else if (!strcmp(a, "--load-ast")) FLAG_LOAD_AST = true;
+        else if (!strcmp(a, "--lazy")) FLAG_LAZY = true;
+        else if (!strcmp(a, "--strict")) FLAG_STRICT = true;
+        else if (!strcmp(a, "--bundle"))
+        {
+            if (i + 1 == args.size()) { cerr << "--bundle needs an output file\n"; return 1; }
+            gBundleOut = args[++i];
+        }
         else if (!strcmp(a, "--help")) { usage(argv[0]); return 0; }
         else if (a[0] == '-') { cerr << "Unknown option: " << a << "\n"; return 1; }
         else if (!infile) infile = a;
         else { cerr << "Only one input file is supported.\n"; return 1; }
     }
 
+    if (gRecordsFile && gLimits.any())
+    {
+        cerr << "--max-steps, --timeout and --max-output do not apply to --records\n";
+        return 1;
+    }
+    const bool checkpointed = gCheckpoint || gResume;
+    if (gCheckpointEvery && !gCheckpoint)
+    {
+        cerr << "--checkpoint-every needs --checkpoint=FILE\n";
+        return 1;
+    }
+    if (checkpointed && (FLAG_PRINT_AST || FLAG_TOKENS || FLAG_TOKENS_BIN || FLAG_FLAT || gRecordsFile ||
+                         gBundleOut || gDumpAst))
+    {
+        cerr << "--checkpoint and --resume apply to plain runs (not -p, -t, --flat, --records,\n"
+                "--bundle or the dumps)\n";
+        return 1;
+    }
+    if (checkpointed && !infile && !bundled)
+    {
+        cerr << "--checkpoint and --resume need a program file; stdin is the program's input\n";
+        return 1;
+    }
+
+    // Load the keyword skin before anything is scanned
+    try { selectSkin(gSkinStorage); }
+    catch (const exception& e) { cerr << e.what() << "\n"; return 1; }
+    if (FLAG_LIST_SKINS) { listSkins(cout); return 0; }
+
     // Open input file or use stdin
     FILE* in = stdin;
-    if (infile){ in = fopen(infile, "r"); if (!in){ perror("open"); return 1; } }
+    if (bundled)
+    {
+        if (infile || FLAG_TOKENS || FLAG_TOKENS_BIN || FLAG_LOAD_AST)
+        {
+            cerr << args[0] << " runs its built-in program; it takes no input file or -t\n";
+            return 1;
+        }
+        in = nullptr;
+    }
+    else if (infile){ in = fopen(infile, "r"); if (!in){ perror("open"); return 1; } }
     yyin = in; // give FILE* to the scanner
     extern int yylineno; yylineno = 1; // reset line number at start
 
     try
     {
         // Mode: tokenize only
-        if (FLAG_TOKENS)
+        if (FLAG_TOKENS || FLAG_TOKENS_BIN)
         { 
-            int rc = dumpTokens(); 
+            int rc = FLAG_TOKENS_BIN ? writeTokensBinary(cout) : dumpTokens(); 
             if (in && in!=stdin) fclose(in);
             return rc; 
         }
 
-        // Parse
-        if (FLAG_PRINT_AST) banner("BEGIN PARSING", C_MBOLD);
-        unique_ptr<Program> root = parseProgram();
+        // Mode: a stored run of this program on this input (--result-cache)
+        unique_ptr<ResultCache> cache;
+        unique_ptr<RecordedInput> recordedIn;
+        if (gResultCache && infile && !bundled && !checkpointed && !FLAG_PRINT_AST && !FLAG_OPT_REPORT && !gRecordsFile &&
+            !gDumpAst && !gBundleOut && !dbg::enabled().load(memory_order_relaxed))
+        {
+            string source = readAll(in);
+            rewind(in);
+            // Flags that change what the run can print; -O without -s may
+            // leave the final symbol table incomplete.
+            string key = treeFlags();
+            if (FLAG_FLAT) key += " --flat";
+            if (FLAG_LAZY && !FLAG_STRICT) key += " --lazy";
+            if (gLimits.maxSteps) key += " --max-steps=" + to_string(gLimits.maxSteps);
+            if (gLimits.maxOutput) key += " --max-output=" + to_string(gLimits.maxOutput);
+            string stamp = executableStamp(gSelfExe);
+            if (stamp.empty())
+                cerr << "--result-cache is off: cannot find this interpreter's executable\n";
+            else
+            {
+                cache = make_unique<ResultCache>(gResultCache, source, gSkinStorage, key, stamp);
+                recordedIn = make_unique<RecordedInput>(fileno(stdin));
+                if (const CachedRun* hit = cache->find(*recordedIn))
+                {
+                    fclose(in);
+                    return replayRun(*hit);
+                }
+            }
+        }
+
+        // The program a snapshot belongs to: its bytes and the flags that
+        // shape the tree the path runs through.
+        CheckpointOptions copts;
+        if (checkpointed)
+        {
+            string source = bundled ? bundle.ast : readAll(in);
+            if (!bundled) rewind(in);
+            string key = treeFlags();
+            if (bundled) key += " --bundle";
+            copts.program = programHash(source, gSkinStorage, key);
+            if (gCheckpoint) copts.file = gCheckpoint;
+            copts.every = gCheckpointEvery;
+            copts.resume = gResume;
+        }
+
+        // Parse (or load a binary AST dump)
+        if (FLAG_PRINT_AST && !gDumpAst) banner("BEGIN PARSING", C_MBOLD);
+        unique_ptr<Program> root;
+        if (bundled) root = loadAstBinary(bundle.ast);
+        else if (FLAG_LOAD_AST) root = loadAstBinary(in);
+        else if (FLAG_PIPELINE)
+        {
+            TokenPipeline pipe(gLex);
+            gPipeline = &pipe;
+            try { root = parseProgram(); }
+            catch (...) { gPipeline = nullptr; throw; }
+            gPipeline = nullptr;
+        }
+        else
+        {
+            // Modes that walk the whole tree (or share it between threads)
+            // need it built up front; a program on stdin shares it with READ.
+            if (FLAG_LAZY && !FLAG_STRICT && infile && !gBundleOut && !FLAG_PRINT_AST && !FLAG_FLAT && !FLAG_OPTIMIZE &&
+                gThreads == 1 && !gRecordsFile && !gDumpAst && !checkpointed)
+                startLazyParse(readAll(in));
+            root = parseProgram();
+        }
+
+        // Mode: write a self-contained executable
+        if (gBundleOut)
+        {
+            writeBundle(gSelfExe, gBundleOut, bundleFlags, *root);
+            if (in && in!=stdin) fclose(in);
+            return 0;
+        }
+
+        // Mode: machine-readable AST only
+        if (gDumpAst)
+        {
+            if (!strcmp(gDumpAst, "json")) writeAstJson(*root, cout);
+            else writeAstBinary(*root, cout);
+            if (in && in!=stdin) fclose(in);
+            return 0;
+        }
         // operator<<(ostream&, Program*) must be defined in ast.h
-        if (FLAG_PRINT_AST) cout << root;
+        if (FLAG_PRINT_AST && FLAG_FLAT) flatten(*root).print_tree(cout);
+        else if (FLAG_PRINT_AST) cout << root;
         if (FLAG_PRINT_AST) banner("PARSING COMPLETE", C_MBOLD);
 
+        // Optimize (after -p so the printed tree always matches the source)
+        if (FLAG_OPTIMIZE || gThreads > 1)
+        {
+            OptOptions opts;
+            opts.keepSymbols = FLAG_SYMBOLS;
+            opts.report = FLAG_OPT_REPORT;
+            opts.optimize = FLAG_OPTIMIZE;
+            // With --records the threads run whole records instead; the
+            // loop pool is not meant to be entered from several threads.
+            opts.threads = gRecordsFile ? 1 : gThreads;
+            optimizeProgram(*root, opts);
+        }
+
+        // Interpret once per record
+        if (gRecordsFile)
+        {
+            ifstream records(gRecordsFile);
+            if (!records) { cerr << "Cannot open records file: " << gRecordsFile << "\n"; return 1; }
+            banner("BEGIN INTERPRETATION", C_YBOLD);
+            RecordOptions ropts;
+            ropts.symbols = FLAG_SYMBOLS;
+            ropts.threads = gThreads;
+            RecordStats stats = runRecords(*root, records, cout, cerr, ropts);
+            banner("INTERPRETATION COMPLETE", C_YBOLD);
+            if (stats.failed)
+            {
+                cerr << stats.failed << " of " << stats.records << " record(s) failed\n";
+                if (in && in!=stdin) fclose(in);
+                return 2;
+            }
+            banner("Program executed successfully", C_GREEN);
+            if (in && in!=stdin) fclose(in);
+            return 0;
+        }
+
+        // Interpret from and to snapshots. cout counts what it writes from
+        // the banner on, so a resumed run prints none of what the stopped
+        // one did.
+        if (checkpointed)
+        {
+            CheckpointedRun run(copts);
+            if (!run.resumed()) banner("BEGIN INTERPRETATION", C_YBOLD);
+            unique_ptr<OutputLimit> outputLimit;
+            if (gLimits.maxOutput) outputLimit = make_unique<OutputLimit>(cout.rdbuf(), gLimits.maxOutput);
+            ostream out(outputLimit ? static_cast<streambuf*>(outputLimit.get()) : cout.rdbuf());
+            if (outputLimit) out.exceptions(ios::badbit);  // let LimitExceeded through
+            bool finished;
+            try { finished = run.run(*root, out, gLimits); }
+            catch (...) { out.rdbuf()->pubsync(); throw; }
+            out.flush();
+            if (!finished)
+            {
+                cout.flush();
+                cerr << "Stopped by SIGTERM; snapshot written to " << gCheckpoint << "\n";
+                if (in && in!=stdin) fclose(in);
+                return EXIT_CHECKPOINTED;
+            }
+            if (FLAG_SYMBOLS) {
+                banner("SYMBOL TABLE", C_CYAN);
+                printSymbols(cout, varFrame);
+            }
+            banner("INTERPRETATION COMPLETE", C_YBOLD);
+            banner("Program executed successfully", C_GREEN);
+            if (in && in!=stdin) fclose(in);
+            return 0;
+        }
+
         // Interpret
         banner("BEGIN INTERPRETATION", C_YBOLD);
-        // WRITE statements should print to stdout by spec
-        root->interpret(cout);
-        if (FLAG_SYMBOLS) {
-            banner("SYMBOL TABLE", C_CYAN);
-            for (const auto& [name, val] : symbolTable) {
-                const char* type = holds_alternative<IntType>(val) ? "INTEGER" : "REAL";
-                cout << name << " : " << type << " = ";
-                printValue(cout, val);
-                cout << "\n";
+        if (cache || gLimits.any())
+        {
+            // The same run, but with --result-cache READ goes through
+            // recordedIn and the output is kept as it is written, to be
+            // stored with the symbol table; with --max-output the output
+            // passes an OutputLimit; steps and time count against
+            // --max-steps and --timeout.
+            unique_ptr<RecordedOutput> recordedOut;
+            unique_ptr<OutputLimit> outputLimit;
+            streambuf* sink = cout.rdbuf();
+            if (cache) sink = (recordedOut = make_unique<RecordedOutput>(sink)).get();
+            if (gLimits.maxOutput) sink = (outputLimit = make_unique<OutputLimit>(sink, gLimits.maxOutput)).get();
+            ostream out(sink);
+            if (outputLimit) out.exceptions(ios::badbit);  // let LimitExceeded through
+            istream input(recordedIn.get());
+            if (cache) activeInput = &input;
+            exception_ptr failure;
+            string error;
+            bool limited = false;
+            budget::start(gLimits);
+            try
+            {
+                if (FLAG_FLAT) flatten(*root).interpret(out);
+                else root->interpret(out);
+            }
+            catch (const LimitExceeded& e)
+            {
+                failure = current_exception();
+                error = e.what();
+                limited = true;
+            }
+            catch (const exception& e)
+            {
+                failure = current_exception();
+                error = e.what();
+            }
+            budget::stop();
+            activeInput = &cin;
+            sink->pubsync();  // what the buffers hold, even after a throw
+
+            string symbols;
+            if (!failure)
+            {
+                ostringstream table;
+                printSymbols(table, varFrame);
+                symbols = table.str();
+            }
+            if (FLAG_SYMBOLS && !failure) {
+                banner("SYMBOL TABLE", C_CYAN);
+                cout << symbols;
+            }
+            // A run cut short by a limit is not the program's own result.
+            if (cache && recordedOut->complete() && !limited)
+            {
+                CachedRun run;
+                run.failed = failure != nullptr;
+                run.error = error;
+                run.output = recordedOut->take();
+                run.symbols = std::move(symbols);
+                cache->store(*recordedIn, std::move(run));
+            }
+            if (failure) rethrow_exception(failure);
+        }
+        else
+        {
+            // WRITE statements should print to stdout by spec
+            if (FLAG_FLAT) flatten(*root).interpret(cout);
+            else root->interpret(cout);
+            if (FLAG_SYMBOLS) {
+                banner("SYMBOL TABLE", C_CYAN);
+                printSymbols(cout, varFrame);
             }
         }
 
@@ -188,6 +648,12 @@ int main(int argc, char** argv)
         // Display success
         banner("Program executed successfully", C_GREEN);
     }
+    catch (const LimitExceeded& e)
+    {
+        cerr << e.what() << "\n";
+        if (in && in!=stdin) fclose(in);
+        return EXIT_LIMIT;
+    }
     catch (const exception& e)
     {
         // Exceptions may come from parser (syntax errors) or interpreter (runtime errors)
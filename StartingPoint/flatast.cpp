@@ -0,0 +1,513 @@
+// =============================================================================
+//   flatast.cpp — flattening, evaluation and printing of FlatProgram
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Every case below mirrors the eval()/interpret()/print_tree() of the node
+//   class it came from in ast.h, and shares its operator helpers (apply,
+//   bump, assignValue), so the two layouts cannot drift apart semantically.
+// =============================================================================
+#include <unordered_map>
+#include "flatast.h"
+using namespace std;
+
+namespace {
+
+class Flattener {
+public:
+  explicit Flattener(FlatProgram& f) : f(f) {}
+
+  // A whole expression, evaluated from an empty value stack.
+  uint32_t root(const Expr* e) {
+    depth = 0;
+    return expr(e);
+  }
+
+  uint32_t stmt(const Statement* s) {
+    if (auto c = dynamic_cast<const CompoundStmt*>(s)) return compound(*c);
+    if (auto a = dynamic_cast<const AssignStmt*>(s)) {
+      uint32_t rhs = a->rhs ? root(a->rhs.get()) : FlatProgram::NONE;
+      return add(FlatTag::Assign, 0, index(a->slot), str(a->id), rhs);
+    }
+    if (auto i = dynamic_cast<const IfStmt*>(s)) {
+      uint32_t c = root(i->condition.get());
+      uint32_t t = stmt(i->thenBranch.get());
+      uint32_t e = i->elseBranch ? stmt(i->elseBranch.get()) : FlatProgram::NONE;
+      return add(FlatTag::If, 0, c, t, e);
+    }
+    if (auto w = dynamic_cast<const WhileStmt*>(s)) {
+      uint32_t c = root(w->condition.get());
+      uint32_t b = stmt(w->body.get());
+      uint32_t first = index(f.lists.size());
+      for (const HoistedExpr* h : w->hoisted) f.lists.push_back(hoisted.at(h));
+      uint32_t i = add(FlatTag::While, 0, c, b, first);
+      f.nodes[i].n = static_cast<uint16_t>(w->hoisted.size());
+      return i;
+    }
+    if (auto r = dynamic_cast<const ReadStmt*>(s))
+      return add(FlatTag::Read, 0, index(r->slot), str(r->id));
+    if (auto wr = dynamic_cast<const WriteStmt*>(s)) {
+      if (wr->kind == WriteStmt::ArgKind::Str)
+        return add(FlatTag::Write, static_cast<uint8_t>(wr->kind), wr->text.block, wr->text.offset,
+                   wr->text.length);
+      return add(FlatTag::Write, static_cast<uint8_t>(wr->kind), str(wr->id()), index(wr->slot));
+    }
+    if (dynamic_cast<const SenioritisStmt*>(s)) return add(FlatTag::Senioritis, 0);
+    f.opaque.push_back(s);
+    return add(FlatTag::Opaque, 0, index(f.opaque.size() - 1));
+  }
+
+  uint32_t compound(const CompoundStmt& c) {
+    vector<uint32_t> kids;
+    kids.reserve(c.stmts.size());
+    for (auto& k : c.stmts) kids.push_back(stmt(k.get()));
+    uint32_t first = index(f.lists.size());
+    f.lists.insert(f.lists.end(), kids.begin(), kids.end());
+    return add(FlatTag::Compound, 0, first, index(kids.size()));
+  }
+
+private:
+  FlatProgram& f;
+  unordered_map<const HoistedExpr*, uint32_t> hoisted;  // -> its Hoisted record
+  size_t depth = 0;                                      // value stack height so far
+
+  // Emits e's records in post-order; returns the root record.
+  uint32_t expr(const Expr* e) {
+    uint32_t first = index(f.nodes.size());
+    if (auto b = dynamic_cast<const BinaryExpr*>(e)) {
+      uint8_t op = static_cast<uint8_t>(b->op);
+      expr(b->lhs.get());
+      if (b->op == BinaryExpr::Op::And || b->op == BinaryExpr::Op::Or) {
+        uint32_t test = add(FlatTag::ShortCircuit, op);
+        f.nodes[test].c = test;
+        pop();  // the left value, when the right operand runs
+        expr(b->rhs.get());
+        uint32_t i = add(FlatTag::Binary, op, 0, 0, first);
+        f.nodes[test].b = i;
+        return i;
+      }
+      // A VAR or INTEGER literal on the right is folded into the operator
+      // record (it is still read after the left operand ran).
+      if (auto id = dynamic_cast<const IdentExpr*>(b->rhs.get()))
+        return add(FlatTag::BinaryVar, op, index(id->slot), str(id->name), first);
+      if (auto k = dynamic_cast<const IntLiteral*>(b->rhs.get()))
+        return add(FlatTag::BinaryInt, op, static_cast<uint32_t>(k->value), 0, first);
+      expr(b->rhs.get());
+      pop();
+      return add(FlatTag::Binary, op, 0, 0, first);
+    }
+    if (auto id = dynamic_cast<const IdentExpr*>(e))
+      return leaf(FlatTag::Ident, 0, index(id->slot), str(id->name), first);
+    if (auto i = dynamic_cast<const IntLiteral*>(e))
+      return leaf(FlatTag::IntLit, 0, static_cast<uint32_t>(i->value), 0, first);
+    if (auto r = dynamic_cast<const RealLiteral*>(e)) {
+      f.reals.push_back(r->value);
+      return leaf(FlatTag::RealLit, 0, index(f.reals.size() - 1), 0, first);
+    }
+    if (auto pi = dynamic_cast<const PreIncDecExpr*>(e))
+      return leaf(FlatTag::PreIncDec, pi->isInc, index(pi->slot), str(pi->name), first);
+    if (auto u = dynamic_cast<const UnaryExpr*>(e)) {
+      expr(u->child.get());
+      return add(FlatTag::Unary, static_cast<uint8_t>(u->op), 0, 0, first);
+    }
+    if (auto n = dynamic_cast<const NotExpr*>(e)) {
+      expr(n->child.get());
+      return add(FlatTag::Not, 0, 0, 0, first);
+    }
+    if (auto p = dynamic_cast<const PowSmallExpr*>(e)) {
+      expr(p->base.get());
+      return add(FlatTag::PowSmall, 0, 0, static_cast<uint32_t>(p->k), first);
+    }
+    if (auto m = dynamic_cast<const ModPow2Expr*>(e)) {
+      expr(m->lhs.get());
+      return add(FlatTag::ModPow2, 0, 0, static_cast<uint32_t>(m->divisor), first);
+    }
+    if (auto mc = dynamic_cast<const MulConstExpr*>(e)) {
+      expr(mc->operand.get());
+      return add(FlatTag::MulConst, mc->constOnLeft, static_cast<uint32_t>(mc->shift),
+                 static_cast<uint32_t>(mc->k), first);
+    }
+    if (auto h = dynamic_cast<const HoistedExpr*>(e)) {
+      uint32_t check = add(FlatTag::HoistedCheck, 0, index(h->slot), 0, first);
+      expr(h->expr.get());
+      uint32_t i = add(FlatTag::Hoisted, 0, index(h->slot), 0, first);
+      f.nodes[check].b = i;
+      hoisted[h] = i;
+      return i;
+    }
+    throw runtime_error("--flat: unsupported expression node");
+  }
+
+  static uint32_t index(size_t i) {
+    if (i >= FlatProgram::NONE) throw runtime_error("--flat: program too large");
+    return static_cast<uint32_t>(i);
+  }
+
+  uint32_t str(const string& s) {
+    f.strings.push_back(s);
+    return index(f.strings.size() - 1);
+  }
+
+  uint32_t add(FlatTag tag, uint8_t op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0) {
+    f.nodes.push_back(FlatNode{tag, op, flatHandler(tag, op), a, b, c});
+    return index(f.nodes.size() - 1);
+  }
+
+  // A record that pushes one value.
+  uint32_t leaf(FlatTag tag, uint8_t op, uint32_t a, uint32_t b, uint32_t first) {
+    if (++depth > f.maxDepth) f.maxDepth = depth;
+    return add(tag, op, a, b, first);
+  }
+  void pop() { --depth; }
+};
+
+}  // namespace
+
+uint32_t flattenExpr(FlatProgram& f, const Expr* e) { return Flattener(f).root(e); }
+
+FlatProgram flatten(const Program& p) {
+  FlatProgram f;
+  f.name = p.name;
+  if (p.block) {
+    f.hasBlock = true;
+    f.decls = p.block->decls;
+    if (p.block->body) f.body = Flattener(f).compound(*p.block->body);
+  }
+  return f;
+}
+
+// -----------------------------------------------------------------------------
+// Evaluation
+// -----------------------------------------------------------------------------
+ValueVariant FlatProgram::eval(uint32_t root) const {
+  // Threaded dispatch (GNU labels as values): each record's n picks its
+  // handler, and every handler ends in its own indirect jump to the next one,
+  // which the branch predictor tracks separately instead of funnelling all
+  // records through one switch. Binary records get one handler per operator
+  // and operand form, so BinaryExpr::apply is inlined with a constant op.
+#define FORMS(OP) &&Bin##OP, &&Var##OP, &&Int##OP
+  static const void* const handler[] = {
+    &&IntLit, &&RealLit, &&Ident, &&Unary, &&Not, &&PreIncDec, &&Bad, &&Bad,
+    &&Bad, &&ShortCircuit, &&PowSmall, &&ModPow2, &&MulConst, &&HoistedCheck, &&Hoisted,
+    FORMS(Add), FORMS(Sub), FORMS(Mul), FORMS(Div), FORMS(Mod), FORMS(Pow),
+    FORMS(Lt), FORMS(Gt), FORMS(Eq), FORMS(Ne), &&BinLogic, &&Bad, &&Bad, &&BinLogic, &&Bad, &&Bad,
+  };
+#undef FORMS
+  static_assert(sizeof(handler) / sizeof(handler[0]) == FLAT_HANDLERS, "one handler per dispatch index");
+  if (stack.size() < maxDepth) stack.resize(maxDepth);
+  ValueVariant* sp = stack.data();  // next free entry
+  ValueVariant* slots = activeFrame->slots.data();
+  const FlatNode* n = nodes.data() + nodes[root].c;
+  const FlatNode* const end = nodes.data() + root + 1;
+#define NEXT                                    \
+  do {                                          \
+    if (++n == end) return stack[0];            \
+    goto* handler[n->n];                        \
+  } while (0)
+  goto* handler[n->n];
+
+IntLit:
+  *sp++ = static_cast<IntType>(n->a);
+  NEXT;
+RealLit:
+  *sp++ = reals[n->a];
+  NEXT;
+Ident:
+  *sp++ = slots[n->a];
+  NEXT;
+PreIncDec:
+  *sp++ = PreIncDecExpr::bump(slots[n->a], n->op);
+  NEXT;
+Unary:
+  sp[-1] = UnaryExpr::apply(static_cast<UnaryExpr::Op>(n->op), sp[-1]);
+  NEXT;
+Not:
+  sp[-1] = boolToValue(!isTrueValue(sp[-1]));
+  NEXT;
+#define OPERATOR(OP)                                                                       \
+  Bin##OP:                                                                                 \
+    --sp;                                                                                  \
+    sp[-1] = BinaryExpr::apply(BinaryExpr::Op::OP, sp[-1], sp[0]);                         \
+    NEXT;                                                                                  \
+  Var##OP:                                                                                 \
+    sp[-1] = BinaryExpr::apply(BinaryExpr::Op::OP, sp[-1], slots[n->a]);                   \
+    NEXT;                                                                                  \
+  Int##OP:                                                                                 \
+    sp[-1] = BinaryExpr::apply(BinaryExpr::Op::OP, sp[-1], static_cast<IntType>(n->a));    \
+    NEXT;
+  OPERATOR(Add) OPERATOR(Sub) OPERATOR(Mul) OPERATOR(Div) OPERATOR(Mod) OPERATOR(Pow)
+  OPERATOR(Lt) OPERATOR(Gt) OPERATOR(Eq) OPERATOR(Ne)
+#undef OPERATOR
+BinLogic:
+  sp[-1] = boolToValue(isTrueValue(sp[-1]));  // AND/OR: the right operand decides
+  NEXT;
+ShortCircuit: {
+  bool t = isTrueValue(sp[-1]);
+  if (t == (static_cast<BinaryExpr::Op>(n->op) == BinaryExpr::Op::Or)) {
+    sp[-1] = boolToValue(t);
+    n = nodes.data() + n->b;  // skip the right operand and the operator
+  } else {
+    --sp;
+  }
+  NEXT;
+}
+PowSmall:
+  sp[-1] = PowSmallExpr::apply(sp[-1], static_cast<IntType>(n->b));
+  NEXT;
+ModPow2: {
+  IntType d = static_cast<IntType>(n->b);
+  sp[-1] = ModPow2Expr::apply(sp[-1], (d > 0 ? d : -d) - 1);
+  NEXT;
+}
+MulConst:
+  sp[-1] = MulConstExpr::apply(sp[-1], static_cast<IntType>(n->b), static_cast<int>(n->a));
+  NEXT;
+HoistedCheck:
+  if (activeFrame->ready[n->a]) {
+    *sp++ = slots[n->a];
+    n = nodes.data() + n->b;  // skip the original expression
+  }
+  NEXT;
+Hoisted:
+  NEXT;
+#undef NEXT
+Bad:
+  throw runtime_error("--flat: statement evaluated as an expression");
+}
+
+void FlatProgram::exec(uint32_t i, ostream& out) const {
+  const FlatNode& n = nodes[i];
+  switch (n.tag) {
+    case FlatTag::Compound:
+      for (uint32_t k = 0; k < n.b; ++k) {
+        tick();
+        exec(lists[n.a + k], out);
+      }
+      return;
+    case FlatTag::Assign: {
+      ValueVariant rv = eval(n.c);
+      assignValue(activeFrame->slots[n.a], rv);
+      return;
+    }
+    case FlatTag::If:
+      if (isTrueValue(eval(n.a))) exec(n.b, out);
+      else if (n.c != NONE) exec(n.c, out);
+      return;
+    case FlatTag::While:
+      for (uint32_t k = 0; k < n.n; ++k) {  // HoistedExpr::prime
+        uint32_t h = lists[n.c + k];
+        size_t slot = nodes[h].a;
+        activeFrame->ready[slot] = 0;
+        try {
+          activeFrame->slots[slot] = eval(h - 1);  // the original expression
+          activeFrame->ready[slot] = 1;
+        } catch (const runtime_error&) {
+        }
+      }
+      while (isTrueValue(eval(n.a))) {
+        tick();
+        exec(n.b, out);
+      }
+      return;
+    case FlatTag::Read: {
+      out.flush();
+      ValueVariant& cell = activeFrame->slots[n.a];
+      if (cell.isInt()) {
+        IntType v;
+        if (!(*activeInput >> v)) throw runtime_error("Input error: expected INTEGER for " + strings[n.b]);
+        cell = v;
+      } else {
+        RealType v;
+        if (!(*activeInput >> v)) throw runtime_error("Input error: expected REAL for " + strings[n.b]);
+        cell = v;
+      }
+      return;
+    }
+    case FlatTag::Write:
+      if (static_cast<WriteStmt::ArgKind>(n.op) == WriteStmt::ArgKind::Str) {
+        string_view r = activePool->rendered({n.a, n.b, n.c});
+        out.write(r.data(), static_cast<streamsize>(r.size()));
+      } else {
+        printValue(out, activeFrame->slots[n.b]);
+        out << '\n';
+      }
+      return;
+    case FlatTag::Senioritis:
+      out << "SENIORITIS activated: time for a victory nap.\n";
+      return;
+    case FlatTag::Opaque:
+      opaque[n.a]->interpret(out);
+      return;
+    default: break;
+  }
+  throw runtime_error("--flat: expression executed as a statement");
+}
+
+void FlatProgram::interpret(ostream& out) const {
+  if (body == NONE) return;
+  const FlatNode& n = nodes[body];
+  for (uint32_t k = 0; k < n.b; ++k) {
+    tick();
+    exec(lists[n.a + k], out);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Pretty printer (same lines as the print_tree() methods in ast.h)
+// -----------------------------------------------------------------------------
+void FlatProgram::print(uint32_t i, TreePrinter& tp, bool isLast) const {
+  const FlatNode& n = nodes[i];
+  switch (n.tag) {
+    case FlatTag::IntLit: tp.line(isLast, "INT ", static_cast<IntType>(n.a)); return;
+    case FlatTag::RealLit: tp.line(isLast, "REAL ", reals[n.a]); return;
+    case FlatTag::Ident: tp.line(isLast, "IDENT ", strings[n.b]); return;
+    case FlatTag::Unary:
+      tp.line(isLast, "Unary(", n.op == 0 ? '+' : '-', ")");
+      tp.push(isLast);
+      print(i - 1, tp, true);
+      tp.pop();
+      return;
+    case FlatTag::Not:
+      tp.line(isLast, "NOT");
+      tp.push(isLast);
+      print(i - 1, tp, true);
+      tp.pop();
+      return;
+    case FlatTag::PreIncDec:
+      tp.line(isLast, n.op ? "PreInc(" : "PreDec(", strings[n.b], ")");
+      return;
+    case FlatTag::Binary: {
+      uint32_t lhs = nodes[i - 1].c - 1;  // the right operand's subtree starts after it
+      if (nodes[lhs].tag == FlatTag::ShortCircuit) --lhs;
+      tp.line(isLast, "Bin(", BinaryExpr::opName(static_cast<BinaryExpr::Op>(n.op)), ")");
+      tp.push(isLast);
+      print(lhs, tp, false);
+      print(i - 1, tp, true);
+      tp.pop();
+      return;
+    }
+    case FlatTag::BinaryVar:
+    case FlatTag::BinaryInt:
+      tp.line(isLast, "Bin(", BinaryExpr::opName(static_cast<BinaryExpr::Op>(n.op)), ")");
+      tp.push(isLast);
+      print(i - 1, tp, false);
+      if (n.tag == FlatTag::BinaryVar) tp.line(true, "IDENT ", strings[n.b]);
+      else tp.line(true, "INT ", static_cast<IntType>(n.a));
+      tp.pop();
+      return;
+    case FlatTag::PowSmall:
+      tp.line(isLast, "Bin(^^)");
+      tp.push(isLast);
+      print(i - 1, tp, false);
+      tp.line(true, "INT ", static_cast<IntType>(n.b));
+      tp.pop();
+      return;
+    case FlatTag::ModPow2:
+      tp.line(isLast, "Bin(MOD)");
+      tp.push(isLast);
+      print(i - 1, tp, false);
+      tp.line(true, "INT ", static_cast<IntType>(n.b));
+      tp.pop();
+      return;
+    case FlatTag::MulConst:
+      tp.line(isLast, "Bin(*)");
+      tp.push(isLast);
+      if (n.op) tp.line(false, "INT ", static_cast<IntType>(n.b));
+      print(i - 1, tp, n.op);
+      if (!n.op) tp.line(true, "INT ", static_cast<IntType>(n.b));
+      tp.pop();
+      return;
+    case FlatTag::Hoisted: print(i - 1, tp, isLast); return;
+    case FlatTag::ShortCircuit:
+    case FlatTag::HoistedCheck: return;  // never a subtree root
+    case FlatTag::Read: tp.line(isLast, "Read(", strings[n.b], ")"); return;
+    case FlatTag::Write:
+      if (static_cast<WriteStmt::ArgKind>(n.op) == WriteStmt::ArgKind::Str)
+        tp.line(isLast, "Write('", activePool->text({n.a, n.b, n.c}), "')");
+      else
+        tp.line(isLast, "Write(", strings[n.a], ")");
+      return;
+    case FlatTag::Assign:
+      tp.line(isLast, "Assign ", strings[n.b], " :=");
+      if (n.c == NONE) return;
+      tp.push(isLast);
+      print(n.c, tp, true);
+      tp.pop();
+      return;
+    case FlatTag::If: {
+      bool hasElse = (n.c != NONE);
+      tp.line(isLast, "IF");
+      tp.push(isLast);
+      tp.line(false, "COND");
+      tp.push(false);
+      print(n.a, tp, true);
+      tp.pop();
+      tp.line(!hasElse, "THEN");
+      tp.push(!hasElse);
+      print(n.b, tp, true);
+      tp.pop();
+      if (hasElse) {
+        tp.line(true, "ELSE");
+        tp.push(true);
+        print(n.c, tp, true);
+        tp.pop();
+      }
+      tp.pop();
+      return;
+    }
+    case FlatTag::While:
+      tp.line(isLast, "WHILE");
+      tp.push(isLast);
+      tp.line(false, "COND");
+      tp.push(false);
+      print(n.a, tp, true);
+      tp.pop();
+      tp.line(true, "BODY");
+      tp.push(true);
+      print(n.b, tp, true);
+      tp.pop();
+      tp.pop();
+      return;
+    case FlatTag::Senioritis: tp.line(isLast, "SENIORITIS"); return;
+    case FlatTag::Compound:
+      tp.line(isLast, "BEGIN");
+      tp.push(isLast);
+      if (n.b == 0) tp.line(true, "(empty)");
+      for (uint32_t k = 0; k < n.b; ++k) print(lists[n.a + k], tp, k + 1 == n.b);
+      tp.pop();
+      tp.line(true, "END");
+      return;
+    case FlatTag::Opaque: opaque[n.a]->print_tree(tp, isLast); return;
+  }
+}
+
+void FlatProgram::print_tree(ostream& os) const {
+  TreePrinter tp(os);
+  tp.raw("Program\n");
+  tp.line(false, "name: ", name);
+  if (!hasBlock) {
+    tp.line(true, "Block");
+    tp.push(true);
+    tp.line(true, "(empty)");
+    tp.pop();
+    return;
+  }
+  // Block::print_tree
+  tp.line(true, "Block");
+  tp.push(true);
+  bool hasBody = (body != NONE);
+  if (!decls.empty()) {
+    tp.line(!hasBody, "VAR");
+    tp.push(!hasBody);
+    for (size_t i = 0; i < decls.size(); ++i) {
+      const auto& d = decls[i];
+      const char* typ = (d.type == Decl::Type::Int) ? "INTEGER" : "REAL";
+      tp.line((i + 1 == decls.size()) && !hasBody, d.name, " : ", typ, ";");
+    }
+    tp.pop();
+  }
+  if (hasBody) print(body, tp, true);
+  else if (decls.empty()) tp.line(true, "(empty)");
+  tp.pop();
+}
@@ -0,0 +1,107 @@
+// =============================================================================
+//   flatast.h — compact index-based copy of the AST (--flat)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   flatten() turns the pointer tree into fixed-size 16-byte FlatNode records
+//   stored contiguously in one vector. Nodes are laid out children before
+//   parents (post-order), so every expression is one contiguous run of
+//   records ending at its root, and evaluating it is a single forward pass
+//   over that run with a small value stack: leaves push, operators pop their
+//   operands and push the result. A tag switch replaces virtual dispatch and
+//   there are no per-node calls; a right operand that is a VAR or INTEGER
+//   literal is folded into its operator's record. AND/OR and hoisted
+//   temporaries skip ahead with a jump record, so short-circuiting still
+//   skips the right operand.
+//
+//   Statements refer to their children by 32-bit index and run recursively.
+//   print_tree() writes exactly the -p output of the tree it came from.
+//   Loops the optimizer collapsed or parallelized (CountedLoop) and its
+//   precomputed OutputRuns are not flattened: they keep their own tree and
+//   run through interpret().
+// =============================================================================
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ast.h"
+
+enum class FlatTag : uint8_t {
+  // expressions
+  IntLit, RealLit, Ident, Unary, Not, PreIncDec, Binary, BinaryVar, BinaryInt, ShortCircuit,
+  PowSmall, ModPow2, MulConst, HoistedCheck, Hoisted,
+  // statements
+  Read, Write, Assign, If, While, Senioritis, Compound, Opaque,
+};
+
+// Expression records keep the index of the first record of their subtree in
+// c and their evaluator handler in n (see flatHandler); the operands of an
+// operator are the subtrees just before it. Other fields by tag (NONE marks
+// an absent child):
+//   IntLit a=value bits            RealLit a=reals[]      Ident a=slot b=strings[]
+//   Unary op                       Not                    PreIncDec op=inc a=slot b=strings[]
+//   Binary op                      ShortCircuit op=AND/OR b=its Binary record
+//   BinaryVar op a=slot b=strings[] (right operand is that VAR)
+//   BinaryInt op a=value bits       (right operand is that INTEGER literal)
+//   PowSmall b=k                   ModPow2 b=divisor      MulConst op=constOnLeft a=shift b=k
+//   HoistedCheck a=slot b=its Hoisted record              Hoisted a=slot
+//   Read a=slot b=strings[]
+//   Write op=kind; Str: a,b,c = string pool span; Id: a=strings[] b=slot
+//   Assign a=slot b=strings[] c=rhs                       If a=cond b=then c=else
+//   While a=cond b=body, n hoisted temporaries at lists[c..]
+//   Compound b statements at lists[a..]                   Opaque a=opaque[]
+struct FlatNode {
+  FlatTag tag;
+  uint8_t op;
+  uint16_t n;
+  uint32_t a, b, c;
+};
+static_assert(sizeof(FlatNode) == 16, "flat nodes are 16 bytes");
+
+// Evaluator handler of an expression record: its tag, or for the three
+// binary forms one handler per (operator, form) after the plain tags.
+constexpr uint16_t FLAT_EXPR_TAGS = static_cast<uint16_t>(FlatTag::Hoisted) + 1;
+constexpr uint16_t FLAT_HANDLERS = FLAT_EXPR_TAGS + 3 * 12;
+constexpr uint16_t flatHandler(FlatTag tag, uint8_t op) {
+  if (tag == FlatTag::Binary) return FLAT_EXPR_TAGS + 3 * op;
+  if (tag == FlatTag::BinaryVar) return FLAT_EXPR_TAGS + 3 * op + 1;
+  if (tag == FlatTag::BinaryInt) return FLAT_EXPR_TAGS + 3 * op + 2;
+  return static_cast<uint16_t>(tag);
+}
+
+// Runs on one thread at a time (eval() reuses one value stack).
+struct FlatProgram {
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  vector<FlatNode> nodes;
+  vector<uint32_t> lists;               // Compound statements, While temporaries
+  vector<RealType> reals;
+  vector<string> strings;               // identifiers, for errors and -p
+  vector<const Statement*> opaque;      // CountedLoops, owned by the source Program
+  size_t maxDepth = 0;                  // deepest value stack any expression needs
+
+  string name;
+  bool hasBlock = false;
+  vector<Decl> decls;
+  uint32_t body = NONE;                 // Compound node of the main BEGIN ... END
+
+  void print_tree(ostream& os) const;
+  void interpret(ostream& out) const;
+
+  ValueVariant eval(uint32_t root) const;
+  void exec(uint32_t i, ostream& out) const;
+
+private:
+  mutable vector<ValueVariant> stack;
+
+  void print(uint32_t i, TreePrinter& tp, bool isLast) const;
+};
+
+// Copies `p` into flat form; `p` must outlive the result if it holds
+// CountedLoops.
+FlatProgram flatten(const Program& p);
+
+// Appends expression `e` (and its subtree) to `f`; returns its root index.
+uint32_t flattenExpr(FlatProgram& f, const Expr* e);
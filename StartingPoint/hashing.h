@@ -0,0 +1,63 @@
+// =============================================================================
+//   hashing.h — FNV-1a, and the key a program is stored under
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Every hash in the interpreter is 64-bit FNV-1a: the string pool, the
+//   skin tables, tipsd's program cache, --result-cache and --checkpoint.
+//
+//   programKey() is the one definition of "the same program" for stored
+//   runs (resultcache.h) and snapshots (checkpoint.h): the source, the
+//   keyword skin (with a skin file's contents, since its spellings decide
+//   what the source means) and the run flags the caller says shape the
+//   tree. Each format hashes its own magic and version in front, so the
+//   two never share a key.
+// =============================================================================
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+namespace fnv {
+
+constexpr uint64_t BASIS = 1469598103934665603ull;
+constexpr uint64_t PRIME = 1099511628211ull;
+
+// Goes on hashing `s` from `h`.
+inline uint64_t hash(std::string_view s, uint64_t h = BASIS) {
+  for (unsigned char c : s) h = (h ^ c) * PRIME;
+  return h;
+}
+
+// Adds `s` to `h` as one of several fields: its length (8 bytes, little
+// endian) and then its bytes, so no two lists of fields hash the same bytes
+// ("ab","c" and "a","bc" differ, whatever bytes the fields hold).
+inline void field(uint64_t& h, std::string_view s) {
+  for (int i = 0; i < 8; ++i) h = (h ^ static_cast<unsigned char>(s.size() >> (8 * i))) * PRIME;
+  h = hash(s, h);
+}
+
+}  // namespace fnv
+
+// `format` is the file format's magic and version byte.
+inline uint64_t programKey(std::string_view format, std::string_view source, const std::string& skin,
+                           std::string_view flags) {
+  uint64_t h = fnv::BASIS;
+  fnv::field(h, format);
+  fnv::field(h, source);
+  fnv::field(h, skin);
+  if (skin.find_first_of("/.") != std::string::npos) {  // a skin file: its spellings count
+    std::ifstream f(skin, std::ios::binary);
+    fnv::field(h, std::string((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>()));
+  }
+  fnv::field(h, flags);
+  return h;
+}
+
+// Little-endian u64, as the formats that carry these keys store it.
+inline void putU64(std::string& out, uint64_t v) {
+  for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>(v >> (8 * i)));
+}
@@ -0,0 +1,291 @@
+// =============================================================================
+//   incremental.cpp — token splicing and the reparse walk
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   After an edit the changed tokens are [damageFirst, damageEnd) in the new
+//   token list. Ranges that start after the change move with it; ranges that
+//   start before it and end at or after its old end grow with it, so they
+//   cover the change. The walk only descends into statements that cover it.
+//   A range that starts or ends among the replaced tokens (or ends just
+//   before them) has that end pulled to the start of the change and is
+//   marked clipped: it lost tokens to the edit, or never held the ones that
+//   went, so it is only ever reparsed as part of something larger.
+//
+//   The one place two ranges meet without a token between them is an IF's
+//   THEN branch and its ELSE, which is why a piece that ends before an ELSE
+//   is never reparsed on its own. Anywhere else an insertion that touches
+//   the end of one statement is taken to belong to that statement, and the
+//   window it gets reparsed in says whether it does.
+// =============================================================================
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include "incremental.h"
+#include "simdscan.h"
+using namespace std;
+
+TokenReplay* gReplay = nullptr;
+
+unique_ptr<Program> parseProgram();
+
+namespace {
+
+vector<string> splitLines(const string& text) {
+  vector<string> out;
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t nl = text.find('\n', start);
+    if (nl == string::npos) nl = text.size();
+    out.emplace_back(text, start, nl - start);
+    start = nl + 1;
+  }
+  return out;
+}
+
+// Every token of `text` with gLex(), numbering lines from `firstLine`.
+vector<TokenRecord> scan(const string& text, int firstLine) {
+  vector<TokenRecord> out;
+  if (text.empty()) return out;
+  FILE* in = fmemopen(const_cast<char*>(text.data()), text.size(), "r");
+  if (!in) throw runtime_error("incremental parse: cannot scan edit text");
+  restartScanner(in);
+  yylineno = firstLine;
+  for (;;) {
+    Token t = gLex();
+    if (t == 0) break;
+    out.push_back({t, yylineno, t == IDENT ? yyidkey : 0, yytext ? yytext : ""});
+  }
+  fclose(in);
+  return out;
+}
+
+bool sameTokens(const TokenRecord* a, const TokenRecord* b, size_t n) {
+  for (size_t k = 0; k < n; ++k)
+    if (a[k].tok != b[k].tok || a[k].line != b[k].line || a[k].text != b[k].text) return false;
+  return true;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+// Full parse
+// -----------------------------------------------------------------------------
+IncrementalParser::IncrementalParser(const string& source)
+  : lines(splitLines(source)), toks(scan(source, 1)) {
+  reparseAll();
+}
+
+string IncrementalParser::source() const {
+  string out;
+  for (const string& l : lines) { out += l; out += '\n'; }
+  return out;
+}
+
+ReparseStats IncrementalParser::reparseAll() {
+  prog.reset();
+  spans.clear();
+  spanOf.clear();
+  deadSpans = 0;
+  resetParser();
+
+  vector<StmtSpan> all;
+  TokenReplay replay{&toks, 0, toks.size(), &all};
+  gReplay = &replay;
+  try { prog = parseProgram(); }
+  catch (...) { gReplay = nullptr; throw; }
+  gReplay = nullptr;
+  adopt(all);
+
+  ReparseStats s;
+  s.tokensParsed = toks.size();
+  s.statementsBuilt = all.size();
+  s.full = true;
+  return s;
+}
+
+// -----------------------------------------------------------------------------
+// Edits
+// -----------------------------------------------------------------------------
+ReparseStats IncrementalParser::apply(const TextEdit& edit) {
+  if (edit.line < 1 || edit.count < 0 ||
+      static_cast<size_t>(edit.line - 1 + edit.count) > lines.size())
+    throw runtime_error("incremental parse: edit of lines " + to_string(edit.line) + "+" +
+                        to_string(edit.count) + " is outside the source");
+
+  // Old tokens on the replaced lines, and the new ones.
+  auto byLine = [](const TokenRecord& r, int line) { return r.line < line; };
+  size_t i = lower_bound(toks.begin(), toks.end(), edit.line, byLine) - toks.begin();
+  size_t j = lower_bound(toks.begin() + i, toks.end(), edit.line + edit.count, byLine) - toks.begin();
+  vector<TokenRecord> fresh = scan(edit.text, edit.line);
+
+  vector<string> newLines = splitLines(edit.text);
+  int lineDelta = static_cast<int>(newLines.size()) - edit.count;
+  auto at = lines.begin() + (edit.line - 1);
+  at = lines.erase(at, at + edit.count);
+  lines.insert(at, make_move_iterator(newLines.begin()), make_move_iterator(newLines.end()));
+
+  stats = ReparseStats();
+  stats.tokensScanned = fresh.size();
+  bool unchanged = fresh.size() == j - i && sameTokens(fresh.data(), toks.data() + i, fresh.size());
+
+  // Splice the token list and move everything after the edit.
+  ptrdiff_t d = static_cast<ptrdiff_t>(fresh.size()) - static_cast<ptrdiff_t>(j - i);
+  if (d > 0) toks.insert(toks.begin() + j, static_cast<size_t>(d), TokenRecord());
+  else if (d < 0) toks.erase(toks.begin() + (j + d), toks.begin() + j);
+  move(fresh.begin(), fresh.end(), toks.begin() + i);
+  if (lineDelta != 0)
+    for (size_t k = i + fresh.size(); k < toks.size(); ++k) toks[k].line += lineDelta;
+  clipped.clear();
+  if (d != 0 || lineDelta != 0 || (i < j && !unchanged)) {
+    for (StmtSpan& r : spans) {
+      if (!r.stmt) continue;
+      if (r.first >= j) {
+        r.first += static_cast<uint32_t>(d);
+        r.end += static_cast<uint32_t>(d);
+        r.stmt->line += lineDelta;
+        continue;
+      }
+      if (unchanged) continue;
+      bool clip = false;
+      if (r.first > i) { r.first = static_cast<uint32_t>(i); clip = true; }
+      if (r.end >= j) r.end += static_cast<uint32_t>(d);
+      else if (r.end >= i) { r.end = static_cast<uint32_t>(i); clip = true; }
+      if (clip) clipped.insert(r.stmt);
+    }
+  }
+
+  if (!prog) return reparseAll();
+  if (unchanged) return stats;  // whitespace, comments, or the same text
+
+  damageFirst = i;
+  damageEnd = i + fresh.size();
+  CompoundStmt* body = prog->block ? prog->block->body.get() : nullptr;
+  if (body && covers(body) && reparseChildren(*body)) return stats;
+  return reparseAll();
+}
+
+// -----------------------------------------------------------------------------
+// The reparse walk
+// -----------------------------------------------------------------------------
+bool IncrementalParser::covers(Statement* s) const {
+  const StmtSpan& r = range(s);
+  // After a pure deletion a range that now starts where the tokens went may
+  // just have moved there; only one that started before them contains it.
+  bool starts = damageEnd > damageFirst ? r.first <= damageFirst : r.first < damageFirst;
+  return starts && r.end >= damageEnd && !clipped.count(s);
+}
+
+// `slot` covers the change: try the statements inside it, then all of it.
+bool IncrementalParser::reparseIn(unique_ptr<Statement>& slot) {
+  Statement* s = slot.get();
+  if (auto* c = dynamic_cast<CompoundStmt*>(s)) {
+    if (reparseChildren(*c)) return true;
+  } else if (auto* f = dynamic_cast<IfStmt*>(s)) {
+    if (covers(f->thenBranch.get()) && reparseIn(f->thenBranch)) return true;
+    if (f->elseBranch && covers(f->elseBranch.get()) && reparseIn(f->elseBranch)) return true;
+  } else if (auto* w = dynamic_cast<WhileStmt*>(s)) {
+    if (covers(w->body.get()) && reparseIn(w->body)) return true;
+  }
+  return replaceWhole(slot);
+}
+
+// The children of `c` around the change, as one run between BEGIN and END.
+bool IncrementalParser::reparseChildren(CompoundStmt& c) {
+  const StmtSpan& self = range(&c);
+  if (damageFirst <= self.first || damageEnd >= self.end) return false;  // BEGIN or END
+  auto& kids = c.stmts;
+  size_t n = kids.size();
+  if (n == 0) return false;
+
+  auto firstOf = [&](size_t x) { return range(kids[x].get()).first; };
+  auto endOf = [&](size_t x) { return range(kids[x].get()).end; };
+  size_t lo = 0, hi = n;  // k: first child ending at or after the change
+  while (lo < hi) { size_t mid = (lo + hi) / 2; if (endOf(mid) < damageFirst) lo = mid + 1; else hi = mid; }
+  size_t k = min(lo, n - 1);
+  lo = 0; hi = n;         // m: last child starting at or before its end
+  while (lo < hi) { size_t mid = (lo + hi) / 2; if (firstOf(mid) <= damageEnd) lo = mid + 1; else hi = mid; }
+  size_t m = lo == 0 ? 0 : lo - 1;
+  if (k > m) swap(k, m);
+
+  if (k == m && covers(kids[k].get()) && reparseIn(kids[k])) return true;
+
+  // A change that starts or ends between children takes in the neighbour,
+  // so the run starts and ends on a statement rather than a ';'.
+  if (firstOf(k) > damageFirst && k > 0) --k;
+  if (endOf(m) < damageEnd && m + 1 < n) ++m;
+  size_t first = min<size_t>(firstOf(k), damageFirst);
+  size_t end = max<size_t>(endOf(m), damageEnd);
+
+  vector<unique_ptr<Statement>> run;
+  vector<StmtSpan> newSpans;
+  if (!parseWindow(first, end, true, run, newSpans)) return false;
+  for (size_t x = k; x <= m; ++x) forget(kids[x].get());
+  auto at = kids.erase(kids.begin() + k, kids.begin() + m + 1);
+  kids.insert(at, make_move_iterator(run.begin()), make_move_iterator(run.end()));
+  adopt(newSpans);
+  return true;
+}
+
+bool IncrementalParser::replaceWhole(unique_ptr<Statement>& slot) {
+  StmtSpan r = range(slot.get());
+  if (r.end < toks.size() && toks[r.end].tok == ELSE) return false;
+  vector<unique_ptr<Statement>> one;
+  vector<StmtSpan> newSpans;
+  if (!parseWindow(r.first, r.end, false, one, newSpans)) return false;
+  forget(slot.get());
+  slot = std::move(one.front());
+  adopt(newSpans);
+  return true;
+}
+
+bool IncrementalParser::parseWindow(size_t first, size_t end, bool run,
+                                    vector<unique_ptr<Statement>>& out,
+                                    vector<StmtSpan>& newSpans) {
+  stats.tokensParsed += end - first;
+  TokenReplay replay{&toks, first, end, &newSpans};
+  gReplay = &replay;
+  try {
+    if (run) out = parseStatementRunWindow();
+    else out.push_back(parseStatementWindow());
+  } catch (const exception&) {
+    gReplay = nullptr;
+    out.clear();
+    return false;
+  }
+  gReplay = nullptr;
+  stats.statementsBuilt += newSpans.size();
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Range bookkeeping
+// -----------------------------------------------------------------------------
+void IncrementalParser::forget(Statement* s) {
+  auto it = spanOf.find(s);
+  spans[it->second].stmt = nullptr;
+  spanOf.erase(it);
+  ++deadSpans;
+  if (auto* c = dynamic_cast<CompoundStmt*>(s)) {
+    for (auto& k : c->stmts) forget(k.get());
+  } else if (auto* f = dynamic_cast<IfStmt*>(s)) {
+    forget(f->thenBranch.get());
+    if (f->elseBranch) forget(f->elseBranch.get());
+  } else if (auto* w = dynamic_cast<WhileStmt*>(s)) {
+    forget(w->body.get());
+  }
+}
+
+void IncrementalParser::adopt(const vector<StmtSpan>& newSpans) {
+  if (deadSpans > spans.size() / 2) {  // compact
+    spans.erase(remove_if(spans.begin(), spans.end(), [](const StmtSpan& r) { return !r.stmt; }),
+                spans.end());
+    for (size_t k = 0; k < spans.size(); ++k) spanOf[spans[k].stmt] = static_cast<uint32_t>(k);
+    deadSpans = 0;
+  }
+  for (const StmtSpan& s : newSpans) {
+    spanOf[s.stmt] = static_cast<uint32_t>(spans.size());
+    spans.push_back(s);
+  }
+}
@@ -0,0 +1,128 @@
+// =============================================================================
+//   incremental.h — reparse only what a text edit touched
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   An IncrementalParser owns a program's source (as lines), its token list
+//   (every token with its line, in order) and the token range [first, end)
+//   of every statement in the tree. TIPS tokens never span lines and the
+//   scanner carries no state from one line to the next, so an edit that
+//   replaces whole lines is re-lexed on its own and spliced into the token
+//   list; tokens after it move by the change in token and line counts.
+//
+//   The parser then reads from the token list (gReplay below) instead of
+//   the scanner. Starting at the program's body it walks down to the
+//   innermost statement whose range covers the changed tokens and reparses
+//   the smallest piece there: the statement itself, or the run of
+//   CompoundStmt children next to the change (which may come back as more
+//   or fewer statements). Everything outside that piece keeps its nodes. A
+//   piece must parse to exactly its range, or the walk backs out one level
+//   and tries the enclosing statement; an edit outside the body (the
+//   header or VAR section), or one the body itself cannot absorb, falls
+//   back to a full parse of the token list.
+//
+//   A piece never ends just before an ELSE: the full parser would hand that
+//   ELSE to an IF the new text left open, so the enclosing IF is reparsed.
+// =============================================================================
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+#include "pipeline.h"
+
+// -----------------------------------------------------------------------------
+// Parser hook: read tokens from a list instead of gLex()
+// -----------------------------------------------------------------------------
+struct StmtSpan {
+  Statement* stmt;
+  uint32_t first, end;  // token indices: first token, one past the last
+};
+
+struct TokenReplay {
+  const std::vector<TokenRecord>* toks = nullptr;
+  size_t pos = 0;                         // next token peek() returns
+  size_t end = 0;                         // peek() returns EOF from here on
+  std::vector<StmtSpan>* spans = nullptr; // if set, every statement parsed
+};
+
+// The list peek() reads from, or nullptr for gPipeline / gLex().
+extern TokenReplay* gReplay;
+
+// Parser entry points for the window gReplay describes (parser.cpp). Both
+// throw runtime_error unless the window parses to its very end.
+std::unique_ptr<Statement> parseStatementWindow();               // statement
+std::vector<std::unique_ptr<Statement>> parseStatementRunWindow(); // stmt {; stmt}
+
+// Forgets the declarations and lookahead of the last parse, so
+// parseProgram() can run again in the same process.
+void resetParser();
+
+// -----------------------------------------------------------------------------
+// Incremental parsing session
+// -----------------------------------------------------------------------------
+struct TextEdit {
+  int line = 1;          // first line replaced, 1-based
+  int count = 0;         // lines replaced; 0 inserts before `line`
+  std::string text;      // replacement: zero or more '\n'-terminated lines
+};
+
+struct ReparseStats {
+  size_t tokensScanned = 0;   // tokens lexed from the edit's text
+  size_t tokensParsed = 0;    // tokens the parser read again
+  size_t statementsBuilt = 0; // statements in the reparsed piece
+  bool full = false;          // fell back to parsing the whole token list
+};
+
+class IncrementalParser {
+public:
+  // Scans and parses `source` in full. Throws runtime_error as parseProgram()
+  // does. Uses the global symbol table, so one session at a time.
+  explicit IncrementalParser(const std::string& source);
+
+  // Applies `edit` to the source and brings program() up to date. Throws
+  // runtime_error (with the full parser's message) if the edited source
+  // does not parse; the edit is kept and the next apply() parses in full.
+  ReparseStats apply(const TextEdit& edit);
+
+  // The tree for the current source, or nullptr while it does not parse.
+  Program* program() { return prog.get(); }
+  std::string source() const;
+  size_t lineCount() const { return lines.size(); }
+  const std::string& line(int n) const { return lines[static_cast<size_t>(n - 1)]; }
+
+  // Parses the token list from scratch; what apply() falls back to.
+  ReparseStats reparseAll();
+
+private:
+  std::vector<std::string> lines;         // without their '\n'
+  std::vector<TokenRecord> toks;          // no EOF record
+  std::unique_ptr<Program> prog;
+
+  // Every statement's range, kept flat so an edit can shift them all in one
+  // pass; forgotten statements leave a null entry until the next compaction.
+  std::vector<StmtSpan> spans;
+  std::unordered_map<Statement*, uint32_t> spanOf;  // index into spans
+  size_t deadSpans = 0;
+
+  // The changed tokens of the edit being applied, in new indices.
+  size_t damageFirst = 0, damageEnd = 0;
+  std::unordered_set<Statement*> clipped;  // ranges that end inside the change
+  ReparseStats stats;
+
+  const StmtSpan& range(Statement* s) const { return spans[spanOf.at(s)]; }
+  bool covers(Statement* s) const;
+  bool reparseIn(std::unique_ptr<Statement>& slot);
+  bool reparseChildren(CompoundStmt& c);
+  bool replaceWhole(std::unique_ptr<Statement>& slot);
+  bool parseWindow(size_t first, size_t end, bool run,
+                   std::vector<std::unique_ptr<Statement>>& out,
+                   std::vector<StmtSpan>& newSpans);
+  void forget(Statement* s);
+  void adopt(const std::vector<StmtSpan>& newSpans);
+};
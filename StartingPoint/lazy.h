@@ -0,0 +1,55 @@
+// =============================================================================
+//   lazy.h — BEGIN ... END bodies parsed on first use (--lazy, --strict)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   After startLazyParse() the parser does not build nested compound
+//   statements. It matches BEGIN against END straight off the scanner and
+//   leaves a LazyStmt holding the lines they span. The first time the
+//   statement is interpreted (or printed) those lines are scanned again and
+//   parsed into the CompoundStmt the eager parser would have built, with
+//   the compounds nested inside it deferred the same way. TIPS tokens never
+//   span lines, so a body is found again by its lines and the number of
+//   tokens ahead of its BEGIN on the first one.
+//
+//   The program's own body is always parsed, so everything up to the first
+//   nested BEGIN runs without further parsing. A syntax error inside a
+//   deferred body is thrown, with the eager parser's message, when that
+//   body is first entered, and never if it is not. --strict, which must
+//   report every syntax error before the program runs, parses eagerly: a
+//   pre-scan followed by parsing every body would only scan them twice.
+//
+//   Only plain runs of a program file defer: -p, -O, --flat, --threads,
+//   --records and the dumps walk the whole tree (some of them on several
+//   threads), so the driver parses eagerly for those.
+// =============================================================================
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "ast.h"
+
+extern bool gLazyParse;  // parser.cpp: defer nested BEGIN ... END bodies
+
+// Keeps `source` for the deferred bodies, points the scanner at it and sets
+// gLazyParse; parseProgram() then reads the program from it.
+void startLazyParse(std::string source);
+
+struct LazyStmt : Statement {
+  // `line` (Statement) holds the BEGIN, `endLine` its END.
+  int endLine = 0;
+  uint32_t skip = 0;                        // tokens before BEGIN on `line`
+  mutable std::unique_ptr<Statement> body;  // set on first use
+
+  const Statement& parsed() const {
+    if (!body) parseBody();
+    return *body;
+  }
+
+  void print_tree(TreePrinter& tp, bool isLast = true) const override { parsed().print_tree(tp, isLast); }
+  void interpret(ostream& out) const override { parsed().interpret(out); }
+
+private:
+  void parseBody() const;  // parser.cpp; throws runtime_error on a syntax error
+};
@@ -5,6 +5,7 @@
 // Author: Derek Willis
 // *****************************************************************************
 #pragma once
+#include <cstdint>
 #include <cstdio>
 // ---------------------------------------------------------------------------
 // Keywords
@@ -69,9 +70,22 @@ using Token = int;
 
 // Flex globals
 int yylex(void);
+void yyrestart(FILE* in);  // scan `in` from its start, dropping buffered input
+extern int (*gLex)(void);   // scanner in use: yylex, or simdLex (--scanner=simd)
 extern FILE* yyin;
 extern char* yytext;        // the string contents of a TOKEN
 extern int   yylineno;
+extern uint64_t yyidkey;    // IDENT only: packIdent(yytext), set by the scanner
+
+// Identifiers are [A-Z][A-Z0-9]{0,7}, so a name fits in 8 bytes: packed with
+// its first character in the top byte and zero-padded, keys are never 0 and
+// order like the names they spell.
+inline uint64_t packIdent(const char* s) {
+  uint64_t key = 0;
+  int n = 0;
+  for (; n < 8 && s[n]; ++n) key = (key << 8) | static_cast<unsigned char>(s[n]);
+  return n == 8 ? key : key << (8 * (8 - n));
+}
 
 // Optional “current token” symbol (defined in parser.cpp)
 extern int token;
@@ -0,0 +1,1107 @@
+// =============================================================================
+//   optimize.cpp — AST optimization passes for the TIPS interpreter (-O)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Pass order:
+//     1. fold      : literal-only subexpressions become IntLiteral/RealLiteral
+//     2. prune     : IF/WHILE whose condition folded to a constant lose the
+//                    branch that can never run
+//     3. liveness  : backward dataflow; assignments whose target is dead and
+//                    whose RHS is pure (no ++/--, cannot throw) are dropped
+//     4. decls     : VARs no statement mentions anymore leave the symbol table
+//     5. idioms    : counting/accumulating WHILEs become ClosedFormLoops
+//     6. parallel  : reduction-only WHILEs become ParallelLoops
+//     7. licm      : WHILE-invariant subexpressions move to frame temporaries
+//                    primed once before the loop
+//     8. strength  : ^^ by a small literal, MOD by a power of two and * by an
+//                    integer literal become the dedicated nodes in ast.h
+//     9. output    : runs of WRITEs with output known up front become one
+//                    OutputRun
+//
+//   -O runs every pass but 6; --threads=N (N > 1) runs pass 6, with or
+//   without -O. With -s every VAR is printed at the end, so all of them are
+//   live at exit and step 4 is skipped; the dump matches an unoptimized run
+//   exactly.
+// =============================================================================
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "optimize.h"
+#include "threadpool.h"
+#include "debug.h"
+using namespace std;
+
+using LiveSet = set<string>;
+
+// -----------------------------------------------------------------------------
+// Expression facts
+// -----------------------------------------------------------------------------
+enum class SType { Int, Real, Unknown };
+
+static SType declaredType(size_t slot) {
+  return varFrame.slots[slot].isInt() ? SType::Int : SType::Real;
+}
+
+// Result type of an expression when it can be decided without running it.
+static SType staticType(const Expr* e) {
+  if (dynamic_cast<const IntLiteral*>(e))  return SType::Int;
+  if (dynamic_cast<const RealLiteral*>(e)) return SType::Real;
+  if (auto id = dynamic_cast<const IdentExpr*>(e))     return declaredType(id->slot);
+  if (auto pi = dynamic_cast<const PreIncDecExpr*>(e)) return declaredType(pi->slot);
+  if (auto u = dynamic_cast<const UnaryExpr*>(e))      return staticType(u->child.get());
+  if (dynamic_cast<const NotExpr*>(e)) return SType::Int;
+  if (auto b = dynamic_cast<const BinaryExpr*>(e)) {
+    using Op = BinaryExpr::Op;
+    SType L = staticType(b->lhs.get()), R = staticType(b->rhs.get());
+    switch (b->op) {
+      case Op::Div: return SType::Real;
+      case Op::Mod: case Op::Lt: case Op::Gt: case Op::Eq: case Op::Ne:
+      case Op::And: case Op::Or:
+        return SType::Int;
+      case Op::Pow:
+        if (L == SType::Real || R == SType::Real) return SType::Real;
+        if (L == SType::Int) {
+          auto k = dynamic_cast<const IntLiteral*>(b->rhs.get());
+          if (k && k->value >= 0) return SType::Int;
+        }
+        return SType::Unknown;
+      default:
+        if (L == SType::Real || R == SType::Real) return SType::Real;
+        if (L == SType::Int && R == SType::Int) return SType::Int;
+        return SType::Unknown;
+    }
+  }
+  return SType::Unknown;
+}
+
+static bool isNonZeroLiteral(const Expr* e) {
+  if (auto i = dynamic_cast<const IntLiteral*>(e))  return i->value != 0;
+  if (auto r = dynamic_cast<const RealLiteral*>(e)) return r->value != 0.0;
+  return false;
+}
+
+// Pure = evaluating it neither writes a variable nor can raise a runtime error,
+// so skipping the evaluation is unobservable.
+static bool isPure(const Expr* e) {
+  if (dynamic_cast<const IntLiteral*>(e) || dynamic_cast<const RealLiteral*>(e) ||
+      dynamic_cast<const IdentExpr*>(e))
+    return true;
+  if (dynamic_cast<const PreIncDecExpr*>(e)) return false;
+  if (auto u = dynamic_cast<const UnaryExpr*>(e)) return isPure(u->child.get());
+  if (auto n = dynamic_cast<const NotExpr*>(e))   return isPure(n->child.get());
+  if (auto b = dynamic_cast<const BinaryExpr*>(e)) {
+    if (b->op == BinaryExpr::Op::Div && !isNonZeroLiteral(b->rhs.get())) return false;
+    if (b->op == BinaryExpr::Op::Mod) {
+      auto k = dynamic_cast<const IntLiteral*>(b->rhs.get());
+      if (!k || k->value == 0 || staticType(b->lhs.get()) != SType::Int) return false;
+    }
+    return isPure(b->lhs.get()) && isPure(b->rhs.get());
+  }
+  return false;
+}
+
+// Every variable an expression reads (++/-- count as a read of their target).
+static void exprUses(const Expr* e, LiveSet& out) {
+  if (auto id = dynamic_cast<const IdentExpr*>(e))          out.insert(id->name);
+  else if (auto pi = dynamic_cast<const PreIncDecExpr*>(e)) out.insert(pi->name);
+  else if (auto u = dynamic_cast<const UnaryExpr*>(e))      exprUses(u->child.get(), out);
+  else if (auto n = dynamic_cast<const NotExpr*>(e))        exprUses(n->child.get(), out);
+  else if (auto b = dynamic_cast<const BinaryExpr*>(e)) {
+    exprUses(b->lhs.get(), out);
+    exprUses(b->rhs.get(), out);
+  }
+}
+
+static bool isLiteral(const Expr* e) {
+  return dynamic_cast<const IntLiteral*>(e) || dynamic_cast<const RealLiteral*>(e);
+}
+
+static unique_ptr<Expr> makeLiteral(const ValueVariant& v) {
+  if (v.isInt()) return make_unique<IntLiteral>(v.intValue());
+  return make_unique<RealLiteral>(v.realValue());
+}
+
+// -----------------------------------------------------------------------------
+// Pass 1: constant folding
+// -----------------------------------------------------------------------------
+static void fold(unique_ptr<Expr>& e) {
+  if (auto u = dynamic_cast<UnaryExpr*>(e.get())) {
+    fold(u->child);
+    if (!isLiteral(u->child.get())) return;
+  } else if (auto n = dynamic_cast<NotExpr*>(e.get())) {
+    fold(n->child);
+    if (!isLiteral(n->child.get())) return;
+  } else if (auto b = dynamic_cast<BinaryExpr*>(e.get())) {
+    fold(b->lhs);
+    fold(b->rhs);
+    bool lhsConst = isLiteral(b->lhs.get());
+    // AND/OR short-circuit: a constant LHS that decides the result makes the
+    // RHS unreachable, so it need not be constant.
+    if (lhsConst && (b->op == BinaryExpr::Op::And || b->op == BinaryExpr::Op::Or)) {
+      bool l = isTrueValue(b->lhs->eval());
+      if (l == (b->op == BinaryExpr::Op::Or)) {
+        e = makeLiteral(boolToValue(l));
+        return;
+      }
+    }
+    if (!lhsConst || !isLiteral(b->rhs.get())) return;
+  } else {
+    return;
+  }
+  // Constant operands: evaluating now is exactly what the interpreter would do.
+  // Anything that would throw (e.g. 1 MOD 0) is left for runtime to report.
+  try {
+    e = makeLiteral(e->eval());
+  } catch (const runtime_error&) {
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Pass 2: unreachable branch pruning
+// -----------------------------------------------------------------------------
+static void pruneAll(vector<unique_ptr<Statement>>& stmts);
+
+static unique_ptr<Statement> orEmpty(unique_ptr<Statement> s) {
+  if (s) return s;
+  return make_unique<CompoundStmt>();
+}
+
+static void prune(unique_ptr<Statement>& s) {
+  if (auto c = dynamic_cast<CompoundStmt*>(s.get())) {
+    pruneAll(c->stmts);
+  } else if (auto a = dynamic_cast<AssignStmt*>(s.get())) {
+    fold(a->rhs);
+  } else if (auto i = dynamic_cast<IfStmt*>(s.get())) {
+    fold(i->condition);
+    prune(i->thenBranch);
+    if (i->elseBranch) prune(i->elseBranch);
+    if (isLiteral(i->condition.get())) {
+      bool taken = isTrueValue(i->condition->eval());
+      dbg::line(string("opt: IF condition is constant, keeping ") + (taken ? "THEN" : "ELSE"));
+      s = taken ? std::move(i->thenBranch) : std::move(i->elseBranch);
+      return;
+    }
+    i->thenBranch = orEmpty(std::move(i->thenBranch));
+  } else if (auto w = dynamic_cast<WhileStmt*>(s.get())) {
+    fold(w->condition);
+    prune(w->body);
+    if (isLiteral(w->condition.get()) && !isTrueValue(w->condition->eval())) {
+      dbg::line("opt: WHILE condition is constant false, loop removed");
+      s.reset();
+      return;
+    }
+    w->body = orEmpty(std::move(w->body));
+  }
+}
+
+// Prunes each statement, dropping removed ones and splicing nested BEGIN/END
+// blocks into the enclosing sequence (a CompoundStmt has no runtime effect).
+static void pruneAll(vector<unique_ptr<Statement>>& stmts) {
+  vector<unique_ptr<Statement>> kept;
+  kept.reserve(stmts.size());
+  for (auto& s : stmts) {
+    prune(s);
+    if (!s) continue;
+    if (auto c = dynamic_cast<CompoundStmt*>(s.get())) {
+      for (auto& inner : c->stmts) kept.push_back(std::move(inner));
+    } else {
+      kept.push_back(std::move(s));
+    }
+  }
+  stmts = std::move(kept);
+}
+
+// -----------------------------------------------------------------------------
+// Pass 3: liveness and dead store elimination
+// -----------------------------------------------------------------------------
+// `live` enters holding the variables live after the statement and leaves
+// holding those live before it.
+static void transfer(const Statement* s, LiveSet& live);
+
+static LiveSet whileLiveIn(const WhileStmt* w, const LiveSet& liveOut) {
+  LiveSet in = liveOut;
+  exprUses(w->condition.get(), in);
+  while (true) {
+    LiveSet body = in;
+    transfer(w->body.get(), body);
+    LiveSet next = liveOut;
+    exprUses(w->condition.get(), next);
+    next.insert(body.begin(), body.end());
+    if (next == in) return in;
+    in = std::move(next);
+  }
+}
+
+static void transfer(const Statement* s, LiveSet& live) {
+  if (auto c = dynamic_cast<const CompoundStmt*>(s)) {
+    for (auto it = c->stmts.rbegin(); it != c->stmts.rend(); ++it) transfer(it->get(), live);
+  } else if (auto a = dynamic_cast<const AssignStmt*>(s)) {
+    live.erase(a->id);
+    exprUses(a->rhs.get(), live);
+  } else if (auto r = dynamic_cast<const ReadStmt*>(s)) {
+    live.erase(r->id);
+  } else if (auto w = dynamic_cast<const WriteStmt*>(s)) {
+    if (w->kind == WriteStmt::ArgKind::Id) live.insert(w->id());
+  } else if (auto i = dynamic_cast<const IfStmt*>(s)) {
+    LiveSet t = live;
+    transfer(i->thenBranch.get(), t);
+    if (i->elseBranch) transfer(i->elseBranch.get(), live);
+    live.insert(t.begin(), t.end());
+    exprUses(i->condition.get(), live);
+  } else if (auto wh = dynamic_cast<const WhileStmt*>(s)) {
+    live = whileLiveIn(wh, live);
+  }
+}
+
+static int deadStores = 0;
+
+static void eliminate(unique_ptr<Statement>& s, LiveSet& live);
+
+static void eliminateAll(vector<unique_ptr<Statement>>& stmts, LiveSet& live) {
+  for (size_t i = stmts.size(); i-- > 0;) eliminate(stmts[i], live);
+  vector<unique_ptr<Statement>> kept;
+  kept.reserve(stmts.size());
+  for (auto& s : stmts) if (s) kept.push_back(std::move(s));
+  stmts = std::move(kept);
+}
+
+static void eliminate(unique_ptr<Statement>& s, LiveSet& live) {
+  if (auto c = dynamic_cast<CompoundStmt*>(s.get())) {
+    eliminateAll(c->stmts, live);
+  } else if (auto a = dynamic_cast<AssignStmt*>(s.get())) {
+    if (!live.count(a->id) && isPure(a->rhs.get())) {
+      dbg::line("opt: dead store to " + a->id + " removed");
+      ++deadStores;
+      s.reset();
+      return;
+    }
+    transfer(a, live);
+  } else if (auto i = dynamic_cast<IfStmt*>(s.get())) {
+    LiveSet t = live;
+    eliminate(i->thenBranch, t);
+    i->thenBranch = orEmpty(std::move(i->thenBranch));
+    if (i->elseBranch) eliminate(i->elseBranch, live);
+    live.insert(t.begin(), t.end());
+    exprUses(i->condition.get(), live);
+  } else if (auto w = dynamic_cast<WhileStmt*>(s.get())) {
+    // Removing stores only shrinks the uses the fixpoint saw, so the live set
+    // computed on the original body stays a safe over-approximation.
+    LiveSet in = whileLiveIn(w, live);
+    LiveSet body = in;
+    eliminate(w->body, body);
+    w->body = orEmpty(std::move(w->body));
+    live = std::move(in);
+  } else {
+    transfer(s.get(), live);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Pass 4: unused declarations
+// -----------------------------------------------------------------------------
+static void stmtMentions(const Statement* s, LiveSet& out) {
+  if (auto c = dynamic_cast<const CompoundStmt*>(s)) {
+    for (auto& k : c->stmts) stmtMentions(k.get(), out);
+  } else if (auto a = dynamic_cast<const AssignStmt*>(s)) {
+    out.insert(a->id);
+    exprUses(a->rhs.get(), out);
+  } else if (auto r = dynamic_cast<const ReadStmt*>(s)) {
+    out.insert(r->id);
+  } else if (auto w = dynamic_cast<const WriteStmt*>(s)) {
+    if (w->kind == WriteStmt::ArgKind::Id) out.insert(w->id());
+  } else if (auto i = dynamic_cast<const IfStmt*>(s)) {
+    exprUses(i->condition.get(), out);
+    stmtMentions(i->thenBranch.get(), out);
+    if (i->elseBranch) stmtMentions(i->elseBranch.get(), out);
+  } else if (auto w = dynamic_cast<const WhileStmt*>(s)) {
+    exprUses(w->condition.get(), out);
+    stmtMentions(w->body.get(), out);
+  }
+}
+
+// Renumbers every slot reference after dropped VARs leave the frame.
+static void remapExpr(Expr* e, const vector<size_t>& to) {
+  if (auto id = dynamic_cast<IdentExpr*>(e))          id->slot = to[id->slot];
+  else if (auto pi = dynamic_cast<PreIncDecExpr*>(e)) pi->slot = to[pi->slot];
+  else if (auto u = dynamic_cast<UnaryExpr*>(e))      remapExpr(u->child.get(), to);
+  else if (auto n = dynamic_cast<NotExpr*>(e))        remapExpr(n->child.get(), to);
+  else if (auto b = dynamic_cast<BinaryExpr*>(e)) {
+    remapExpr(b->lhs.get(), to);
+    remapExpr(b->rhs.get(), to);
+  }
+}
+
+static void remapStmt(Statement* s, const vector<size_t>& to) {
+  if (auto c = dynamic_cast<CompoundStmt*>(s)) {
+    for (auto& k : c->stmts) remapStmt(k.get(), to);
+  } else if (auto a = dynamic_cast<AssignStmt*>(s)) {
+    a->slot = to[a->slot];
+    remapExpr(a->rhs.get(), to);
+  } else if (auto r = dynamic_cast<ReadStmt*>(s)) {
+    r->slot = to[r->slot];
+  } else if (auto w = dynamic_cast<WriteStmt*>(s)) {
+    if (w->kind == WriteStmt::ArgKind::Id) w->slot = to[w->slot];
+  } else if (auto i = dynamic_cast<IfStmt*>(s)) {
+    remapExpr(i->condition.get(), to);
+    remapStmt(i->thenBranch.get(), to);
+    if (i->elseBranch) remapStmt(i->elseBranch.get(), to);
+  } else if (auto w = dynamic_cast<WhileStmt*>(s)) {
+    remapExpr(w->condition.get(), to);
+    remapStmt(w->body.get(), to);
+  }
+}
+
+static void dropUnusedDecls(Block& b) {
+  LiveSet used;
+  stmtMentions(b.body.get(), used);
+  vector<Decl> kept;
+  for (auto& d : b.decls) {
+    if (used.count(d.name)) {
+      kept.push_back(std::move(d));
+    } else {
+      dbg::line("opt: unused VAR " + d.name + " dropped");
+      symbolTable.erase(d.name);
+    }
+  }
+  b.decls = std::move(kept);
+
+  // Compact the frame so dropped VARs cost no storage at run time.
+  vector<size_t> to(varFrame.slots.size());
+  Frame compact;
+  for (auto& entry : symbolTable) {
+    size_t old = entry.second;
+    to[old] = compact.addSlot(varFrame.slots[old]);
+    entry.second = to[old];
+  }
+  remapStmt(b.body.get(), to);
+  varFrame = std::move(compact);
+}
+
+// -----------------------------------------------------------------------------
+// Loop facts
+// -----------------------------------------------------------------------------
+// Slots a statement can write: ASSIGN and READ targets plus ++/-- operands.
+using SlotSet = set<size_t>;
+
+static void exprWrites(const Expr* e, SlotSet& out) {
+  if (auto pi = dynamic_cast<const PreIncDecExpr*>(e)) out.insert(pi->slot);
+  else if (auto u = dynamic_cast<const UnaryExpr*>(e)) exprWrites(u->child.get(), out);
+  else if (auto n = dynamic_cast<const NotExpr*>(e))   exprWrites(n->child.get(), out);
+  else if (auto b = dynamic_cast<const BinaryExpr*>(e)) {
+    exprWrites(b->lhs.get(), out);
+    exprWrites(b->rhs.get(), out);
+  }
+}
+
+static void stmtWrites(const Statement* s, SlotSet& out) {
+  if (auto c = dynamic_cast<const CompoundStmt*>(s)) {
+    for (auto& k : c->stmts) stmtWrites(k.get(), out);
+  } else if (auto a = dynamic_cast<const AssignStmt*>(s)) {
+    out.insert(a->slot);
+    exprWrites(a->rhs.get(), out);
+  } else if (auto r = dynamic_cast<const ReadStmt*>(s)) {
+    out.insert(r->slot);
+  } else if (auto i = dynamic_cast<const IfStmt*>(s)) {
+    exprWrites(i->condition.get(), out);
+    stmtWrites(i->thenBranch.get(), out);
+    if (i->elseBranch) stmtWrites(i->elseBranch.get(), out);
+  } else if (auto w = dynamic_cast<const WhileStmt*>(s)) {
+    exprWrites(w->condition.get(), out);
+    stmtWrites(w->body.get(), out);
+  } else if (auto cl = dynamic_cast<const CountedLoop*>(s)) {
+    stmtWrites(cl->loop.get(), out);
+  }
+}
+
+// Invariant = reads only slots outside `written` (no ++/-- anywhere inside).
+static bool isInvariant(const Expr* e, const SlotSet& written) {
+  if (isLiteral(e) || dynamic_cast<const HoistedExpr*>(e)) return true;
+  if (auto id = dynamic_cast<const IdentExpr*>(e)) return !written.count(id->slot);
+  if (auto u = dynamic_cast<const UnaryExpr*>(e)) return isInvariant(u->child.get(), written);
+  if (auto n = dynamic_cast<const NotExpr*>(e))   return isInvariant(n->child.get(), written);
+  if (auto b = dynamic_cast<const BinaryExpr*>(e))
+    return isInvariant(b->lhs.get(), written) && isInvariant(b->rhs.get(), written);
+  return false;
+}
+
+// --- counted loops -------------------------------------------------------------
+static bool reportLoops = false;
+
+static void loopReport(const WhileStmt& w, const string& what) {
+  dbg::line("opt: WHILE at line " + to_string(w.line) + " " + what);
+  if (reportLoops) cerr << "opt-report: WHILE at line " << w.line << " " << what << "\n";
+}
+
+static const IdentExpr* asIdent(const Expr* e, size_t slot) {
+  auto id = dynamic_cast<const IdentExpr*>(e);
+  return (id && id->slot == slot) ? id : nullptr;
+}
+
+static vector<Statement*> bodyStmts(WhileStmt& w) {
+  vector<Statement*> body;
+  if (auto c = dynamic_cast<CompoundStmt*>(w.body.get())) {
+    for (auto& k : c->stmts) body.push_back(k.get());
+  } else {
+    body.push_back(w.body.get());
+  }
+  return body;
+}
+
+// For S := S op e, or S := e op S when op commutes, returns e and sets `op`.
+static const Expr* selfUpdate(const AssignStmt* a, BinaryExpr::Op& op) {
+  auto b = dynamic_cast<const BinaryExpr*>(a->rhs.get());
+  if (!b) return nullptr;
+  op = b->op;
+  if (asIdent(b->lhs.get(), a->slot)) return b->rhs.get();
+  bool commutes = op == BinaryExpr::Op::Add || op == BinaryExpr::Op::Mul ||
+                  op == BinaryExpr::Op::And || op == BinaryExpr::Op::Or;
+  if (commutes && asIdent(b->rhs.get(), a->slot)) return b->lhs.get();
+  return nullptr;
+}
+
+// Matches the condition I < N / I > N (either operand order) against an
+// invariant pure bound; returns the reason on failure.
+static string matchCounter(const WhileStmt& w, const SlotSet& written, CountedLoop& cl) {
+  auto invariantPure = [&](const Expr* e) {
+    return isPure(e) && isInvariant(e, written);
+  };
+  auto cond = dynamic_cast<const BinaryExpr*>(w.condition.get());
+  if (!cond || (cond->op != BinaryExpr::Op::Lt && cond->op != BinaryExpr::Op::Gt))
+    return "condition is not I < N or I > N";
+  auto li = dynamic_cast<const IdentExpr*>(cond->lhs.get());
+  auto ri = dynamic_cast<const IdentExpr*>(cond->rhs.get());
+  if (li && written.count(li->slot) && invariantPure(cond->rhs.get())) {
+    cl.ivar = li->slot;
+    cl.less = (cond->op == BinaryExpr::Op::Lt);
+    cl.bound = cond->rhs.get();
+  } else if (ri && written.count(ri->slot) && invariantPure(cond->lhs.get())) {
+    cl.ivar = ri->slot;
+    cl.less = (cond->op == BinaryExpr::Op::Gt);
+    cl.bound = cond->lhs.get();
+  } else {
+    return "condition does not compare a loop variable with an invariant bound";
+  }
+  if (declaredType(cl.ivar) != SType::Int) return "loop variable is REAL";
+  return "";
+}
+
+// I := I + c / I := c + I / I := I - c for a non-zero literal c.
+static string matchStep(const AssignStmt* a, CountedLoop& cl) {
+  BinaryExpr::Op op;
+  const Expr* other = selfUpdate(a, op);
+  auto c = other ? dynamic_cast<const IntLiteral*>(other) : nullptr;
+  if (!c || c->value == 0 || (op != BinaryExpr::Op::Add && op != BinaryExpr::Op::Sub))
+    return "loop variable is not stepped by a constant";
+  cl.step = (op == BinaryExpr::Op::Sub) ? -c->value : c->value;
+  return "";
+}
+
+// Trips of `WHILE I < N` stepping by c > 0 from i0; false if the answer is not
+// a finite count.
+static bool tripCount(int64_t i0, int64_t c, const ValueVariant& n, int64_t& k) {
+  if (n.isInt()) {
+    int64_t nv = n.intValue();
+    k = (i0 >= nv) ? 0 : (nv - i0 + c - 1) / c;
+    return true;
+  }
+  RealType nv = n.realValue();
+  if (isnan(nv) || !(static_cast<RealType>(i0) < nv)) { k = 0; return true; }
+  if (!isfinite(nv) || nv > 1e10) return false;
+  // Estimate, then settle on the first j whose I no longer passes the test.
+  int64_t j = max<int64_t>(1, static_cast<int64_t>(ceil((nv - i0) / c)));
+  while (j > 1 && static_cast<RealType>(i0 + (j - 1) * c) >= nv) --j;
+  while (static_cast<RealType>(i0 + j * c) < nv) ++j;
+  k = j;
+  return true;
+}
+
+// What tick() counts for one trip of `w`: the trip, plus each statement of
+// a BEGIN ... END body. Collapsed bodies hold no nested blocks or loops.
+static int64_t stepsPerTrip(const WhileStmt& w) {
+  auto* c = dynamic_cast<const CompoundStmt*>(w.body.get());
+  return 1 + (c ? static_cast<int64_t>(c->stmts.size()) : 0);
+}
+
+bool CountedLoop::trips(int64_t& i0, int64_t& k) const {
+  i0 = activeFrame->slots[ivar].intValue();
+  ValueVariant n = bound->eval();
+
+  // I > N stepping down is I' < N' stepping up after negating everything
+  // (the negated INTEGER bound is carried as a REAL: -INT32_MIN overflows).
+  bool ok;
+  if (less) {
+    ok = tripCount(i0, step, n, k);
+  } else {
+    ValueVariant negN = -asReal(n);
+    ok = tripCount(-i0, -static_cast<int64_t>(step), negN, k);
+  }
+  int64_t iFinal = i0 + k * step;
+  return ok && iFinal <= INT32_MAX && iFinal >= INT32_MIN;
+}
+
+// -----------------------------------------------------------------------------
+// Pass 5: closed-form loops
+// -----------------------------------------------------------------------------
+static int collapsed = 0;
+
+// Fills `cf` for a loop of the documented shape; otherwise returns the reason
+// the loop has to keep stepping.
+static string recognize(WhileStmt& w, ClosedFormLoop& cf) {
+  SlotSet written;
+  stmtWrites(&w, written);
+  auto invariantPure = [&](const Expr* e) {
+    return isPure(e) && isInvariant(e, written);
+  };
+  string why = matchCounter(w, written, cf);
+  if (!why.empty()) return why;
+
+  bool stepSeen = false;
+  SlotSet targets;
+  for (Statement* s : bodyStmts(w)) {
+    if (auto wr = dynamic_cast<const WriteStmt*>(s)) {
+      if (wr->kind == WriteStmt::ArgKind::Id && written.count(wr->slot))
+        return "WRITE of a variable the loop changes";
+      cf.writes.push_back(wr);
+      continue;
+    }
+    auto a = dynamic_cast<const AssignStmt*>(s);
+    if (!a) return "body has a statement other than ASSIGN or WRITE";
+    SlotSet sideEffects;
+    exprWrites(a->rhs.get(), sideEffects);
+    if (!sideEffects.empty()) return "body uses ++/--";
+    if (!targets.insert(a->slot).second) return a->id + " is assigned twice";
+
+    BinaryExpr::Op op;
+    const Expr* other = selfUpdate(a, op);
+    if (other && op != BinaryExpr::Op::Add && op != BinaryExpr::Op::Sub) other = nullptr;
+    bool negate = other && op == BinaryExpr::Op::Sub;
+
+    if (a->slot == cf.ivar) {
+      why = matchStep(a, cf);
+      if (!why.empty()) return why;
+      stepSeen = true;
+    } else if (other && asIdent(other, cf.ivar)) {
+      if (declaredType(a->slot) != SType::Int) return "REAL sum of the loop variable";
+      cf.accs.push_back({a->slot, nullptr, negate, stepSeen});
+    } else if (other && invariantPure(other)) {
+      SType inc = staticType(other);
+      if (declaredType(a->slot) == SType::Int ? inc != SType::Int : inc == SType::Unknown)
+        return "increment of " + a->id + " changes type";
+      cf.accs.push_back({a->slot, other, negate, stepSeen});
+    } else if (invariantPure(a->rhs.get())) {
+      cf.stores.push_back({a->slot, a->rhs.get()});
+    } else {
+      return "assignment to " + a->id + " is not linear";
+    }
+  }
+  if (!stepSeen) return "loop variable is never stepped";
+  if ((cf.step > 0) != cf.less) return "step moves away from the bound";
+  return "";
+}
+
+static void collapseLoops(unique_ptr<Statement>& s) {
+  if (auto c = dynamic_cast<CompoundStmt*>(s.get())) {
+    for (auto& k : c->stmts) collapseLoops(k);
+  } else if (auto i = dynamic_cast<IfStmt*>(s.get())) {
+    collapseLoops(i->thenBranch);
+    if (i->elseBranch) collapseLoops(i->elseBranch);
+  } else if (auto w = dynamic_cast<WhileStmt*>(s.get())) {
+    collapseLoops(w->body);
+    auto cf = make_unique<ClosedFormLoop>();
+    string why = recognize(*w, *cf);
+    if (!why.empty()) {
+      loopReport(*w, "kept: " + why);
+      return;
+    }
+    loopReport(*w, "collapsed: " + to_string(cf->accs.size()) + " accumulator(s), " +
+                   to_string(cf->stores.size()) + " store(s), " +
+                   to_string(cf->writes.size()) + " WRITE(s) per trip");
+    ++collapsed;
+    cf->loop.reset(static_cast<WhileStmt*>(s.release()));
+    cf->tripSteps = stepsPerTrip(*cf->loop);
+    s = std::move(cf);
+  }
+}
+
+// --- runtime side --------------------------------------------------------------
+
+// x = mant * 2^exp2 with mant odd (x finite, non-zero).
+static void decompose(RealType x, int64_t& mant, int& exp2) {
+  int e;
+  RealType f = frexp(x, &e);
+  mant = static_cast<int64_t>(ldexp(f, 53));
+  exp2 = e - 53;
+  while ((mant & 1) == 0) { mant /= 2; ++exp2; }
+}
+
+// k additions of e to s0 agree with s0 + k*e exactly when every partial sum
+// is representable: on the common binary grid 2^m of s0 and e, all of them
+// (which lie between the first and the last) must stay below 2^53.
+static bool exactRealSum(RealType s0, RealType e, int64_t k, RealType& result) {
+  if (!isfinite(s0) || !isfinite(e)) return false;
+  if (e == 0.0) { result = s0 + e; return true; }  // keeps -0.0 + -0.0 == -0.0
+  int64_t me, ms = 0; int xe, xs;
+  decompose(e, me, xe);
+  xs = xe;
+  if (s0 != 0.0) decompose(s0, ms, xs);
+  int m = min(xe, xs);
+  if (xe - m >= 53 || xs - m >= 53) return false;
+  const __int128 LIMIT = static_cast<__int128>(1) << 53;
+  __int128 A = static_cast<__int128>(ms) << (xs - m);
+  __int128 E = static_cast<__int128>(me) << (xe - m);
+  if (A >= LIMIT || -A >= LIMIT || E >= LIMIT || -E >= LIMIT) return false;
+  __int128 F = A + E * k;
+  if (F >= LIMIT || -F >= LIMIT) return false;
+  result = ldexp(static_cast<RealType>(static_cast<int64_t>(F)), m);
+  return isfinite(result);
+}
+
+void ClosedFormLoop::interpret(ostream& out) const {
+  auto& slots = activeFrame->slots;
+  int64_t i0, k;
+  if (!trips(i0, k)) {
+    loop->interpret(out);
+    return;
+  }
+  if (k == 0) return;
+
+  // Work out every new value before touching the frame, so a REAL sum that
+  // would round can still hand the whole loop back to the stepping path.
+  vector<pair<size_t, ValueVariant>> updates;
+  for (const Acc& a : accs) {
+    const ValueVariant& s0 = slots[a.slot];
+    if (!a.inc) {
+      // S +/- sum of I over the trips: k*B + c*k*(k-1)/2, modulo 2^32.
+      __int128 first = i0 + (a.afterStep ? step : 0);
+      __int128 sum = first * k + static_cast<__int128>(step) * k * (k - 1) / 2;
+      uint32_t d = static_cast<uint32_t>(static_cast<uint64_t>(sum));
+      uint32_t r = static_cast<uint32_t>(s0.intValue()) + (a.negate ? 0u - d : d);
+      updates.push_back({a.slot, static_cast<IntType>(r)});
+    } else if (s0.isInt()) {
+      uint32_t d = static_cast<uint32_t>(a.inc->eval().intValue());
+      if (a.negate) d = 0u - d;
+      uint32_t r = static_cast<uint32_t>(s0.intValue()) +
+                   static_cast<uint32_t>(static_cast<uint64_t>(d) * static_cast<uint32_t>(k));
+      updates.push_back({a.slot, static_cast<IntType>(r)});
+    } else {
+      RealType e = asReal(a.inc->eval());
+      RealType r;
+      if (!exactRealSum(s0.realValue(), a.negate ? -e : e, k, r)) {
+        loop->interpret(out);
+        return;
+      }
+      updates.push_back({a.slot, r});
+    }
+  }
+  chargeSteps(k * tripSteps);
+
+  if (!writes.empty()) {
+    ostringstream trip;
+    for (const WriteStmt* w : writes) w->interpret(trip);
+    string text = trip.str();
+    for (int64_t j = 0; j < k; ++j) out << text;
+  }
+  for (auto& [slot, e] : stores) assignValue(slots[slot], e->eval());
+  for (auto& [slot, v] : updates) slots[slot] = v;
+  slots[ivar] = static_cast<IntType>(i0 + k * step);
+}
+
+// -----------------------------------------------------------------------------
+// Pass 6: parallel reductions (--threads=N)
+// -----------------------------------------------------------------------------
+static int parallelized = 0;
+
+// Fills `pl` for a counted loop whose trips only feed INTEGER reductions;
+// otherwise returns the reason it must run sequentially.
+static string recognizeParallel(WhileStmt& w, ParallelLoop& pl) {
+  SlotSet written;
+  stmtWrites(&w, written);
+  string why = matchCounter(w, written, pl);
+  if (!why.empty()) return why;
+
+  // Terms may read I (set per trip in each worker's frame) and anything the
+  // loop leaves alone; reading another reduction would tie trips together.
+  SlotSet others = written;
+  others.erase(pl.ivar);
+
+  bool stepSeen = false;
+  SlotSet targets;
+  for (Statement* s : bodyStmts(w)) {
+    if (dynamic_cast<const WriteStmt*>(s)) return "body WRITEs";
+    if (dynamic_cast<const ReadStmt*>(s)) return "body READs";
+    auto a = dynamic_cast<const AssignStmt*>(s);
+    if (!a) return "body has a statement other than ASSIGN";
+    SlotSet sideEffects;
+    exprWrites(a->rhs.get(), sideEffects);
+    if (!sideEffects.empty()) return "body uses ++/--";
+    if (!targets.insert(a->slot).second) return a->id + " is assigned twice";
+
+    if (a->slot == pl.ivar) {
+      why = matchStep(a, pl);
+      if (!why.empty()) return why;
+      stepSeen = true;
+      continue;
+    }
+    BinaryExpr::Op op;
+    const Expr* term = selfUpdate(a, op);
+    bool arith = op == BinaryExpr::Op::Add || op == BinaryExpr::Op::Sub ||
+                 op == BinaryExpr::Op::Mul;
+    if (!term || !(arith || op == BinaryExpr::Op::And || op == BinaryExpr::Op::Or))
+      return "assignment to " + a->id + " is not a reduction";
+    if (declaredType(a->slot) != SType::Int)
+      return "REAL accumulation into " + a->id + " is not associative";
+    if (arith && staticType(term) != SType::Int)
+      return "term added to " + a->id + " is not INTEGER";
+    if (!isPure(term) || !isInvariant(term, others))
+      return "term of " + a->id + " depends on other trips or can fail";
+    pl.reds.push_back({a->slot, op, term, stepSeen});
+  }
+  if (!stepSeen) return "loop variable is never stepped";
+  if ((pl.step > 0) != pl.less) return "step moves away from the bound";
+  if (pl.reds.empty()) return "no reductions";
+  return "";
+}
+
+static void parallelizeLoops(unique_ptr<Statement>& s, unsigned threads) {
+  if (auto c = dynamic_cast<CompoundStmt*>(s.get())) {
+    for (auto& k : c->stmts) parallelizeLoops(k, threads);
+  } else if (auto i = dynamic_cast<IfStmt*>(s.get())) {
+    parallelizeLoops(i->thenBranch, threads);
+    if (i->elseBranch) parallelizeLoops(i->elseBranch, threads);
+  } else if (auto w = dynamic_cast<WhileStmt*>(s.get())) {
+    parallelizeLoops(w->body, threads);
+    auto pl = make_unique<ParallelLoop>();
+    string why = recognizeParallel(*w, *pl);
+    if (!why.empty()) {
+      loopReport(*w, "sequential: " + why);
+      return;
+    }
+    loopReport(*w, "parallel: " + to_string(pl->reds.size()) + " reduction(s) on " +
+                   to_string(threads) + " threads");
+    ++parallelized;
+    pl->threads = threads;
+    pl->loop.reset(static_cast<WhileStmt*>(s.release()));
+    pl->tripSteps = stepsPerTrip(*pl->loop);
+    s = std::move(pl);
+  }
+}
+
+// --- runtime side --------------------------------------------------------------
+
+// Below this many trips the pool hand-off costs more than it saves.
+static constexpr int64_t MIN_PARALLEL_TRIPS = 1 << 14;
+
+void ParallelLoop::interpret(ostream& out) const {
+  int64_t i0, k;
+  if (threads < 2 || !trips(i0, k) || k < MIN_PARALLEL_TRIPS) {
+    loop->interpret(out);
+    return;
+  }
+
+  chargeSteps(k * tripSteps);
+
+  // A few chunks per thread keep the split even when trips cost differently.
+  ThreadPool& pool = ThreadPool::shared(threads);
+  size_t chunks = static_cast<size_t>(min<int64_t>(k, int64_t{pool.size()} * 4));
+  const size_t R = reds.size();
+  vector<uint32_t> partial(chunks * R);
+  const Frame& home = *activeFrame;
+
+  pool.run(chunks, [&](size_t c) {
+    Frame local = home;
+    Frame* saved = activeFrame;
+    activeFrame = &local;
+    uint32_t* acc = &partial[c * R];
+    for (size_t r = 0; r < R; ++r) {
+      BinaryExpr::Op op = reds[r].op;
+      acc[r] = (op == BinaryExpr::Op::Mul || op == BinaryExpr::Op::And) ? 1u : 0u;
+    }
+    int64_t lo = k * static_cast<int64_t>(c) / static_cast<int64_t>(chunks);
+    int64_t hi = k * static_cast<int64_t>(c + 1) / static_cast<int64_t>(chunks);
+    ValueVariant& iv = local.slots[ivar];
+    for (int64_t j = lo; j < hi; ++j) {
+      int64_t before = i0 + j * step;
+      for (size_t r = 0; r < R; ++r) {
+        const Reduction& red = reds[r];
+        iv = static_cast<IntType>(red.afterStep ? before + step : before);
+        ValueVariant v = red.term->eval();
+        switch (red.op) {
+          case BinaryExpr::Op::Add:
+          case BinaryExpr::Op::Sub: acc[r] += static_cast<uint32_t>(v.intValue()); break;
+          case BinaryExpr::Op::Mul: acc[r] *= static_cast<uint32_t>(v.intValue()); break;
+          case BinaryExpr::Op::And: acc[r] &= isTrueValue(v) ? 1u : 0u; break;
+          default:                  acc[r] |= isTrueValue(v) ? 1u : 0u; break;
+        }
+      }
+    }
+    activeFrame = saved;
+  });
+
+  // Combine in chunk order: S - e1 - e2 - ... is S - (e1 + e2 + ...) mod 2^32,
+  // and after at least one trip AND/OR leave 0 or 1 behind.
+  auto& slots = activeFrame->slots;
+  for (size_t r = 0; r < R; ++r) {
+    const Reduction& red = reds[r];
+    ValueVariant& cell = slots[red.slot];
+    uint32_t s0 = static_cast<uint32_t>(cell.intValue());
+    uint32_t total = (red.op == BinaryExpr::Op::Mul || red.op == BinaryExpr::Op::And) ? 1u : 0u;
+    for (size_t c = 0; c < chunks; ++c) {
+      uint32_t p = partial[c * R + r];
+      switch (red.op) {
+        case BinaryExpr::Op::Mul: total *= p; break;
+        case BinaryExpr::Op::And: total &= p; break;
+        case BinaryExpr::Op::Or:  total |= p; break;
+        default:                  total += p; break;
+      }
+    }
+    switch (red.op) {
+      case BinaryExpr::Op::Add: cell = static_cast<IntType>(s0 + total); break;
+      case BinaryExpr::Op::Sub: cell = static_cast<IntType>(s0 - total); break;
+      case BinaryExpr::Op::Mul: cell = static_cast<IntType>(s0 * total); break;
+      case BinaryExpr::Op::And: cell = boolToValue(s0 != 0 && total != 0); break;
+      default:                  cell = boolToValue(s0 != 0 || total != 0); break;
+    }
+  }
+  slots[ivar] = static_cast<IntType>(i0 + k * step);
+}
+
+// -----------------------------------------------------------------------------
+// Pass 7: loop-invariant code motion
+// -----------------------------------------------------------------------------
+// A subexpression of a WHILE condition or body is invariant when it reads no
+// slot the loop writes (ASSIGN, READ, ++/--). Maximal invariant operator trees
+// become HoistedExprs primed once per loop entry; see ast.h for the guard
+// that keeps runtime errors where the original program raised them.
+static int hoists = 0;
+
+static void hoistExpr(unique_ptr<Expr>& e, const SlotSet& written, WhileStmt& loop) {
+  bool isOp = dynamic_cast<UnaryExpr*>(e.get()) || dynamic_cast<NotExpr*>(e.get()) ||
+              dynamic_cast<BinaryExpr*>(e.get());
+  if (!isOp) return;
+  if (isInvariant(e.get(), written)) {
+    auto h = make_unique<HoistedExpr>(std::move(e), varFrame.addSlot(IntType{0}));
+    loop.hoisted.push_back(h.get());
+    e = std::move(h);
+    ++hoists;
+    return;
+  }
+  if (auto u = dynamic_cast<UnaryExpr*>(e.get()))     hoistExpr(u->child, written, loop);
+  else if (auto n = dynamic_cast<NotExpr*>(e.get()))  hoistExpr(n->child, written, loop);
+  else if (auto b = dynamic_cast<BinaryExpr*>(e.get())) {
+    hoistExpr(b->lhs, written, loop);
+    hoistExpr(b->rhs, written, loop);
+  }
+}
+
+static void hoistStmt(Statement* s, const SlotSet& written, WhileStmt& loop) {
+  if (auto c = dynamic_cast<CompoundStmt*>(s)) {
+    for (auto& k : c->stmts) hoistStmt(k.get(), written, loop);
+  } else if (auto a = dynamic_cast<AssignStmt*>(s)) {
+    hoistExpr(a->rhs, written, loop);
+  } else if (auto i = dynamic_cast<IfStmt*>(s)) {
+    hoistExpr(i->condition, written, loop);
+    hoistStmt(i->thenBranch.get(), written, loop);
+    if (i->elseBranch) hoistStmt(i->elseBranch.get(), written, loop);
+  } else if (auto w = dynamic_cast<WhileStmt*>(s)) {
+    hoistExpr(w->condition, written, loop);
+    hoistStmt(w->body.get(), written, loop);
+  }
+}
+
+// Outer loops first: whatever is invariant in an outer loop is primed once per
+// outer entry, and inner loops only pick up what the outer one had to leave.
+static void licm(Statement* s) {
+  if (auto c = dynamic_cast<CompoundStmt*>(s)) {
+    for (auto& k : c->stmts) licm(k.get());
+  } else if (auto i = dynamic_cast<IfStmt*>(s)) {
+    licm(i->thenBranch.get());
+    if (i->elseBranch) licm(i->elseBranch.get());
+  } else if (auto w = dynamic_cast<WhileStmt*>(s)) {
+    SlotSet written;
+    stmtWrites(w, written);
+    hoistExpr(w->condition, written, *w);
+    hoistStmt(w->body.get(), written, *w);
+    licm(w->body.get());
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Pass 8: strength reduction
+// -----------------------------------------------------------------------------
+// Runs after the analyses above: the nodes it introduces are opaque to them.
+static int reductions = 0;
+
+static bool isPowerOfTwo(IntType v) {
+  // INT32_MIN is excluded: BinaryExpr negates the divisor, which overflows.
+  IntType m = v > 0 ? v : (v == INT32_MIN ? 0 : -v);
+  return m > 0 && (m & (m - 1)) == 0;
+}
+
+static void reduce(unique_ptr<Expr>& e) {
+  if (auto h = dynamic_cast<HoistedExpr*>(e.get())) { reduce(h->expr); return; }
+  if (auto u = dynamic_cast<UnaryExpr*>(e.get())) { reduce(u->child); return; }
+  if (auto n = dynamic_cast<NotExpr*>(e.get()))   { reduce(n->child); return; }
+  auto b = dynamic_cast<BinaryExpr*>(e.get());
+  if (!b) return;
+  reduce(b->lhs);
+  reduce(b->rhs);
+
+  auto kr = dynamic_cast<const IntLiteral*>(b->rhs.get());
+  auto kl = dynamic_cast<const IntLiteral*>(b->lhs.get());
+  if (b->op == BinaryExpr::Op::Pow && kr && kr->value >= 0 && kr->value <= 4) {
+    e = make_unique<PowSmallExpr>(std::move(b->lhs), kr->value);
+  } else if (b->op == BinaryExpr::Op::Mod && kr && isPowerOfTwo(kr->value)) {
+    e = make_unique<ModPow2Expr>(std::move(b->lhs), kr->value);
+  } else if (b->op == BinaryExpr::Op::Mul && kr) {
+    e = make_unique<MulConstExpr>(std::move(b->lhs), kr->value, false);
+  } else if (b->op == BinaryExpr::Op::Mul && kl) {
+    e = make_unique<MulConstExpr>(std::move(b->rhs), kl->value, true);
+  } else {
+    return;
+  }
+  ++reductions;
+}
+
+static void reduceStmt(Statement* s) {
+  if (auto c = dynamic_cast<CompoundStmt*>(s)) {
+    for (auto& k : c->stmts) reduceStmt(k.get());
+  } else if (auto a = dynamic_cast<AssignStmt*>(s)) {
+    reduce(a->rhs);
+  } else if (auto i = dynamic_cast<IfStmt*>(s)) {
+    reduce(i->condition);
+    reduceStmt(i->thenBranch.get());
+    if (i->elseBranch) reduceStmt(i->elseBranch.get());
+  } else if (auto w = dynamic_cast<WhileStmt*>(s)) {
+    reduce(w->condition);
+    reduceStmt(w->body.get());
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Pass 9: output coalescing
+// -----------------------------------------------------------------------------
+// Runs last and only looks inside BEGIN ... END lists. A run is cut back to
+// end at its last output and is kept only if it has two outputs or more.
+static int outputRuns = 0;
+
+// Adds `s` to the run rendered so far; false if `s` cannot be precomputed.
+static bool renderInto(const Statement* s, ostringstream& text, map<size_t, ValueVariant>& known,
+                       bool& isOutput) {
+  isOutput = true;
+  if (auto w = dynamic_cast<const WriteStmt*>(s)) {
+    if (w->kind == WriteStmt::ArgKind::Str) {
+      text << activePool->rendered(w->text);
+      return true;
+    }
+    auto k = known.find(w->slot);
+    if (k == known.end()) return false;
+    printValue(text, k->second);
+    text << '\n';
+    return true;
+  }
+  if (dynamic_cast<const SenioritisStmt*>(s)) {
+    text << "SENIORITIS activated: time for a victory nap.\n";
+    return true;
+  }
+  auto a = dynamic_cast<const AssignStmt*>(s);
+  if (!a || !isLiteral(a->rhs.get())) return false;
+  isOutput = false;
+  auto k = known.try_emplace(a->slot, varFrame.slots[a->slot]).first;  // typed zero
+  assignValue(k->second, a->rhs->eval());
+  return true;
+}
+
+static void coalesce(Statement* s);
+
+static void coalesceAll(vector<unique_ptr<Statement>>& stmts) {
+  for (auto& st : stmts) coalesce(st.get());
+
+  vector<unique_ptr<Statement>> kept;
+  for (size_t i = 0; i < stmts.size();) {
+    ostringstream text, cut;  // cut: text up to the last output so far
+    map<size_t, ValueVariant> known, knownAtCut;
+    size_t end = i, outputs = 0;
+    bool isOutput = false;
+    for (size_t j = i; j < stmts.size() && renderInto(stmts[j].get(), text, known, isOutput); ++j) {
+      if (!isOutput) continue;
+      ++outputs;
+      end = j + 1;
+      cut.str(text.str());
+      knownAtCut = known;
+    }
+    if (outputs < 2) {
+      kept.push_back(std::move(stmts[i++]));
+      continue;
+    }
+    auto run = make_unique<OutputRun>();
+    for (; i < end; ++i) run->stmts.push_back(std::move(stmts[i]));
+    run->text = cut.str();
+    run->stores.assign(knownAtCut.begin(), knownAtCut.end());
+    kept.push_back(std::move(run));
+    ++outputRuns;
+  }
+  stmts = std::move(kept);
+}
+
+static void coalesce(Statement* s) {
+  if (auto c = dynamic_cast<CompoundStmt*>(s)) {
+    coalesceAll(c->stmts);
+  } else if (auto i = dynamic_cast<IfStmt*>(s)) {
+    coalesce(i->thenBranch.get());
+    if (i->elseBranch) coalesce(i->elseBranch.get());
+  } else if (auto w = dynamic_cast<WhileStmt*>(s)) {
+    coalesce(w->body.get());
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Entry point
+// -----------------------------------------------------------------------------
+void optimizeProgram(Program& p, const OptOptions& opts) {
+  if (!p.block || !p.block->body) return;
+  Block& b = *p.block;
+
+  reportLoops = opts.report;
+  if (opts.optimize) {
+    pruneAll(b.body->stmts);
+
+    LiveSet live;
+    if (opts.keepSymbols) {
+      for (const auto& entry : symbolTable) live.insert(entry.first);
+    }
+    deadStores = 0;
+    eliminateAll(b.body->stmts, live);
+    dbg::line("opt: " + to_string(deadStores) + " dead store(s) removed");
+
+    if (!opts.keepSymbols) dropUnusedDecls(b);
+
+    collapsed = 0;
+    for (auto& st : b.body->stmts) collapseLoops(st);
+    dbg::line("opt: " + to_string(collapsed) + " loop(s) collapsed to closed form");
+  }
+
+  if (opts.threads > 1) {
+    parallelized = 0;
+    for (auto& st : b.body->stmts) parallelizeLoops(st, opts.threads);
+    dbg::line("opt: " + to_string(parallelized) + " loop(s) split across threads");
+  }
+  if (!opts.optimize) return;
+
+  hoists = 0;
+  licm(b.body.get());
+  dbg::line("opt: " + to_string(hoists) + " loop-invariant expression(s) hoisted");
+
+  reductions = 0;
+  reduceStmt(b.body.get());
+  dbg::line("opt: " + to_string(reductions) + " strength reduction(s)");
+
+  outputRuns = 0;
+  coalesce(b.body.get());
+  dbg::line("opt: " + to_string(outputRuns) + " output run(s) precomputed");
+}
@@ -0,0 +1,117 @@
+// =============================================================================
+//   optimize.h — AST-to-AST optimization passes run between parse and interpret
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   The optimizer rewrites the tree that Program::interpret() walks. It runs
+//   after `-p` has printed the parse tree, so the printed AST always reflects
+//   the source program, and every pass must leave WRITE output, READ
+//   consumption, runtime errors and (with -s) the symbol table dump unchanged.
+// =============================================================================
+#pragma once
+#include "ast.h"
+
+struct OptOptions {
+  bool keepSymbols = false;  // -s given: every VAR is observed at program end
+  bool report = false;       // --opt-report: say which loops were collapsed
+  bool optimize = true;      // -O passes (off when only --threads asked for work)
+  unsigned threads = 1;      // --threads=N: run reduction loops on N threads
+};
+
+// -----------------------------------------------------------------------------
+// Counted loop: WHILE I < N (or I > N) stepping an INTEGER I by a constant
+// -----------------------------------------------------------------------------
+// Common part of the loop nodes below. Expression pointers point into `loop`,
+// which stays the printed tree and the fallback that simply steps.
+struct CountedLoop : Statement {
+  unique_ptr<WhileStmt> loop;
+  size_t ivar;           // induction variable slot (INTEGER)
+  IntType step;
+  bool less;             // condition is I < bound (else I > bound)
+  const Expr* bound;
+  int64_t tripSteps = 1; // steps one trip of `loop` takes: the trip and its body's statements
+
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    loop->print_tree(tp, isLast);
+  }
+  // Trip count k from the current I and bound; false when it is not finite or
+  // I would leave int32 on the way (the caller must then run `loop`).
+  bool trips(int64_t& i0, int64_t& k) const;
+};
+
+// -----------------------------------------------------------------------------
+// Closed-form loop (built by the loop idiom pass)
+// -----------------------------------------------------------------------------
+// Stands in for a WHILE of the shape
+//     WHILE I < N  (or I > N)  BEGIN ... ; I := I + c ; ... END
+// whose other statements are accumulators S := S +/- e, invariant stores
+// X := e and WRITEs of invariant values. The trip count k is computed from
+// I, c and N, and every variable jumps straight to its value after k trips.
+// When the closed form could differ from stepping (int32 overflow of I, REAL
+// sums that would round, an infinite bound) interpret() runs the original
+// loop instead.
+struct ClosedFormLoop : CountedLoop {
+  struct Acc {
+    size_t slot;
+    const Expr* inc;     // invariant increment; nullptr = adds the induction var
+    bool negate;         // S := S - e
+    bool afterStep;      // induction update precedes this statement
+  };
+  vector<Acc> accs;
+  vector<pair<size_t, const Expr*>> stores;
+  vector<const WriteStmt*> writes;
+
+  void interpret(ostream& out) const override;
+};
+
+// -----------------------------------------------------------------------------
+// Parallel reduction loop (built by the --threads pass)
+// -----------------------------------------------------------------------------
+// Stands in for a counted WHILE whose other statements are all INTEGER
+// reductions S := S op e with op one of + - * AND OR, where e is pure and
+// reads no variable the loop writes except I. Trips are split into chunks
+// that run on the shared ThreadPool, each against a private copy of the frame
+// with I set per trip; the per-chunk partials are combined in chunk order.
+// + - * wrap modulo 2^32 (BinaryExpr::addWrap, subWrap, mulWrap) and AND/OR
+// only look at truth values, so the result is the one stepping would produce.
+// Short loops, and loops whose I would overflow, just run `loop`.
+struct ParallelLoop : CountedLoop {
+  struct Reduction {
+    size_t slot;
+    BinaryExpr::Op op;   // Add, Sub, Mul, And or Or
+    const Expr* term;
+    bool afterStep;      // induction update precedes this statement
+  };
+  vector<Reduction> reds;
+  unsigned threads;
+
+  void interpret(ostream& out) const override;
+};
+
+// -----------------------------------------------------------------------------
+// Output run (built by the output coalescing pass)
+// -----------------------------------------------------------------------------
+// Stands in for consecutive statements whose output is known before the
+// program runs: WRITE('...'), SENIORITIS, stores X := c of a literal and
+// WRITE(X) of a VAR stored earlier in the run. Their output is rendered once
+// by the optimizer; interpret() writes it with one call and then stores the
+// last value each VAR got. A run never holds a READ, and READ flushes the
+// output first, so prompts still appear before the input they ask for.
+struct OutputRun : Statement {
+  vector<unique_ptr<Statement>> stmts;        // the original run
+  string text;                                // everything the run writes
+  vector<pair<size_t, ValueVariant>> stores;  // slot -> final value
+
+  void print_tree(TreePrinter& tp, bool isLast = true) const override {
+    for (size_t i = 0; i < stmts.size(); ++i)
+      stmts[i]->print_tree(tp, isLast && i + 1 == stmts.size());
+  }
+  void interpret(ostream& out) const override {
+    out.write(text.data(), static_cast<streamsize>(text.size()));
+    for (const auto& [slot, v] : stores) activeFrame->slots[slot] = v;
+  }
+};
+
+// Runs all passes over `p` in place.
+void optimizeProgram(Program& p, const OptOptions& opts);
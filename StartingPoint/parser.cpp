@@ -5,23 +5,89 @@
 // Author: Derek Willis
 // ============================================================================
 
+#include <cstdint>
+#include <cstdio>
 #include <memory>
 #include <stdexcept>
 #include <sstream>
 #include <string>
 #include <set>
 #include <map>
-#include <variant>
+#include <vector>
 #include <cmath>
 #include "lexer.h"
 #include "ast.h"
 #include "debug.h"
+#include "pipeline.h"
+#include "incremental.h"
+#include "lazy.h"
+#include "simdscan.h"
 using namespace std;
 
 // -----------------------------------------------------------------------------
 // Global Variable
 // -----------------------------------------------------------------------------
-map<string, ValueVariant> symbolTable; 
+map<string, size_t> symbolTable; 
+Frame varFrame;
+StringPool stringPool;
+
+// -----------------------------------------------------------------------------
+// Declaration lookup
+// -----------------------------------------------------------------------------
+// Every identifier use is checked against the VAR section. Lookups go
+// through this open-addressing table keyed by the scanner's packed name
+// (yyidkey) instead of symbolTable, which stays the name-ordered view the
+// -s dump and the optimizer use. Key 0 marks an empty bucket.
+class DeclTable {
+public:
+  static constexpr size_t NONE = SIZE_MAX;
+
+  size_t find(uint64_t key) const {
+    if (keys.empty()) return NONE;
+    for (size_t i = bucket(key);; i = (i + 1) & mask) {
+      if (keys[i] == key) return slots[i];
+      if (keys[i] == 0) return NONE;
+    }
+  }
+
+  // False if `key` is already declared.
+  bool insert(uint64_t key, size_t slot) {
+    if (2 * (count + 1) > keys.size()) grow();
+    size_t i = bucket(key);
+    for (; keys[i] != 0; i = (i + 1) & mask)
+      if (keys[i] == key) return false;
+    keys[i] = key;
+    slots[i] = static_cast<uint32_t>(slot);
+    ++count;
+    return true;
+  }
+
+private:
+  vector<uint64_t> keys;   // power-of-two size, at most half full
+  vector<uint32_t> slots;
+  size_t mask = 0, count = 0;
+
+  size_t bucket(uint64_t key) const {  // Fibonacci hashing
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+  }
+
+  void grow() {
+    vector<uint64_t> oldKeys = std::move(keys);
+    vector<uint32_t> oldSlots = std::move(slots);
+    keys.assign(oldKeys.empty() ? 64 : 2 * oldKeys.size(), 0);
+    slots.assign(keys.size(), 0);
+    mask = keys.size() - 1;
+    for (size_t j = 0; j < oldKeys.size(); ++j) {
+      if (oldKeys[j] == 0) continue;
+      size_t i = bucket(oldKeys[j]);
+      while (keys[i] != 0) i = (i + 1) & mask;
+      keys[i] = oldKeys[j];
+      slots[i] = oldSlots[j];
+    }
+  }
+};
+
+static DeclTable declared;
 
 // -----------------------------------------------------------------------------
 // One-token lookahead
@@ -29,17 +95,52 @@ map<string, ValueVariant> symbolTable;
 bool   havePeek = false;
 Token  peekTok  = 0;
 string peekLex;
+uint64_t peekKey = 0;  // packed name when peekTok is IDENT
+int peekLine = 1;      // yylineno as of the last token scanned
+static uint32_t peekInLine = 0;  // tokens before peekTok on its line (--lazy)
+static int countedLine = 0;
+
+static inline void countInLine(int line) {
+  if (line == countedLine) ++peekInLine;
+  else { countedLine = line; peekInLine = 0; }
+}
+
+// With --pipeline the scanner runs ahead on its own thread, so the lexeme,
+// key and line come from its record rather than yytext/yyidkey/yylineno.
+static TokenRecord piped;
 
 inline const char* tname(Token t) { return tokName(t); }
 
 Token peek() 
 {
   if (!havePeek) {
-    peekTok = yylex();
+    if (gReplay) {
+      if (gReplay->pos < gReplay->end) {
+        const TokenRecord& r = (*gReplay->toks)[gReplay->pos];
+        peekTok = r.tok;
+        peekLex = r.text;
+        peekKey = r.key;
+        peekLine = r.line;
+      } else {
+        peekTok = 0;
+      }
+    } else if (gPipeline) {
+      gPipeline->next(piped);
+      peekTok = piped.tok;
+      peekLex.swap(piped.text);
+      peekKey = piped.key;
+      peekLine = piped.line;
+    } else {
+      peekTok = gLex();
+      if (peekTok != 0) peekLex = yytext ? string(yytext) : string();
+      if (peekTok == IDENT) peekKey = yyidkey;
+      peekLine = yylineno;
+    }
     if (peekTok == 0) { peekTok = TOK_EOF; peekLex.clear(); }
-    else              { peekLex = yytext ? string(yytext) : string(); }
-    dbg::line(string("peek: ") + tname(peekTok) + (peekLex.empty() ? "" : " ["+peekLex+"]")
-              + " @ line " + to_string(yylineno));
+    countInLine(peekLine);
+    if (dbg::enabled().load(memory_order_relaxed))  // skip building the trace when off
+      dbg::line(string("peek: ") + tname(peekTok) + (peekLex.empty() ? "" : " ["+peekLex+"]")
+                + " @ line " + to_string(peekLine));
     havePeek = true;
   }
   return peekTok;
@@ -47,8 +148,9 @@ Token peek()
 Token nextTok() 
 {
   Token t = peek();
-  dbg::line(string("consume: ") + tname(t));
+  if (dbg::enabled().load(memory_order_relaxed)) dbg::line(string("consume: ") + tname(t));
   havePeek = false;
+  if (gReplay && t != TOK_EOF) ++gReplay->pos;
   return t;
 }
 Token expect(Token want, const char* msg) 
@@ -57,9 +159,9 @@ Token expect(Token want, const char* msg)
   if (got != want) {
     dbg::line(string("expect FAIL: wanted ") + tname(want) + ", got " + tname(got));
     ostringstream oss;
-    oss << "Parse error (line " << yylineno << "): expected "
+    oss << "Parse error (line " << peekLine << "): expected "
         << tname(want) << " — " << msg << ", got " << tname(got)
-        << " [" << (yytext ? yytext : "") << "]";
+        << " [" << peekLex << "]";
     throw runtime_error(oss.str());
   }
   return got;
@@ -71,6 +173,7 @@ Token expect(Token want, const char* msg)
 static inline bool accept(Token t) { if (peek() == t) { nextTok(); return true; } return false; }
 static unique_ptr<Statement> parseStatement();
 static unique_ptr<Statement> parseCompound();
+static unique_ptr<Statement> skipCompound();
 static unique_ptr<Statement> parseIfStmt();
 static unique_ptr<Statement> parseWhileStmt();
 static unique_ptr<Statement> parseSenioritisStmt();
@@ -102,19 +205,23 @@ static void parseDeclarations(vector<Decl>& outDecls) {
   while (peek() == IDENT) {
     Decl d;
     d.name = peekLex;
+    uint64_t key = peekKey;
     expect(IDENT, "declaration name");
     expect(COLON, "':' after identifier in declaration");
     d.type = parseType();
-    if (symbolTable.count(d.name)) {
+    if (declared.find(key) != DeclTable::NONE) {
       throw runtime_error("Parse error: duplicate declaration of " + d.name);
     }
 
+    size_t slot;
     if (d.type == Decl::Type::Int)  { 
-      symbolTable[d.name] = IntType{0};
+      slot = varFrame.addSlot(IntType{0});
     }
     else {
-      symbolTable[d.name] = RealType{0.0};
+      slot = varFrame.addSlot(RealType{0.0});
     }
+    declared.insert(key, slot);
+    symbolTable.emplace(d.name, slot);
 
     expect(SEMICOLON, "';' after declaration");
     outDecls.push_back(std::move(d));
@@ -139,10 +246,11 @@ static unique_ptr<Expr> parsePrimary() {
   }
   if (peek() == IDENT) {
     string name = peekLex;
-    if (!symbolTable.count(name))
+    size_t slot = declared.find(peekKey);
+    if (slot == DeclTable::NONE)
       throw runtime_error("Parse error: use of undeclared identifier " + name);
     nextTok();
-    return unique_ptr<Expr>(static_cast<Expr*>(new IdentExpr(name)));
+    return unique_ptr<Expr>(static_cast<Expr*>(new IdentExpr(name, slot)));
   }
   throw runtime_error(string("Parse error: expected primary, got ") + tname(peek()));
 }
@@ -154,17 +262,19 @@ static unique_ptr<Expr> parseUnary() {
     nextTok();
     if (peek() != IDENT) throw runtime_error("Parse error: ++ must be followed by IDENT");
     string name = peekLex;
-    if (!symbolTable.count(name)) throw runtime_error("Parse error: ++ of undeclared identifier " + name);
+    size_t slot = declared.find(peekKey);
+    if (slot == DeclTable::NONE) throw runtime_error("Parse error: ++ of undeclared identifier " + name);
     nextTok();
-    return unique_ptr<Expr>(static_cast<Expr*>(new PreIncDecExpr(true, name)));
+    return unique_ptr<Expr>(static_cast<Expr*>(new PreIncDecExpr(true, name, slot)));
   }
   if (peek() == DECREMENT) {
     nextTok();
     if (peek() != IDENT) throw runtime_error("Parse error: -- must be followed by IDENT");
     string name = peekLex;
-    if (!symbolTable.count(name)) throw runtime_error("Parse error: -- of undeclared identifier " + name);
+    size_t slot = declared.find(peekKey);
+    if (slot == DeclTable::NONE) throw runtime_error("Parse error: -- of undeclared identifier " + name);
     nextTok();
-    return unique_ptr<Expr>(static_cast<Expr*>(new PreIncDecExpr(false, name)));
+    return unique_ptr<Expr>(static_cast<Expr*>(new PreIncDecExpr(false, name, slot)));
   }
   return parsePrimary();
 }
@@ -274,12 +384,13 @@ static unique_ptr<Statement> parseWriteStmt() {
     stmt = std::move(w);
   } else if (peek() == IDENT) {
     string id = peekLex;
-    if (!symbolTable.count(id)){
+    size_t slot = declared.find(peekKey);
+    if (slot == DeclTable::NONE){
       throw runtime_error("Parse error: WRITE of undeclared identifier " + id);
     }
     expect(IDENT, "identifier in WRITE(...)");
     expect(CLOSEPAREN, "expected ')' after identifier");
-    auto w = make_unique<WriteStmt>(WriteStmt::ArgKind::Id, id);
+    auto w = make_unique<WriteStmt>(WriteStmt::ArgKind::Id, id, slot);
     stmt = std::move(w);
   } else {
     throw runtime_error("Parse error: expected STRINGLIT or IDENT inside WRITE(...)");
@@ -292,27 +403,29 @@ static unique_ptr<Statement> parseReadStmt() {
   expect(OPENPAREN, "expected '(' after READ");
   if (peek() != IDENT) throw runtime_error("Parse error: expected IDENT inside READ(...)");
   string id = peekLex;
-  if (!symbolTable.count(id))
+  size_t slot = declared.find(peekKey);
+  if (slot == DeclTable::NONE)
     throw runtime_error("Parse error: READ of undeclared identifier " + id);
   expect(IDENT, "identifier to READ into");
   expect(CLOSEPAREN, "expected ')' after identifier");
-  return make_unique<ReadStmt>(id);
+  return make_unique<ReadStmt>(id, slot);
 }
 
 
-static unique_ptr<Statement> parseAssignStmtWithLeadingIdent(const string& firstIdent) {
+static unique_ptr<Statement> parseAssignStmtWithLeadingIdent(const string& firstIdent, size_t slot) {
   expect(ASSIGN, "expected ':=' after identifier");
   auto rhs = parseExpression();
-  return make_unique<AssignStmt>(firstIdent, std::move(rhs));
+  return make_unique<AssignStmt>(firstIdent, slot, std::move(rhs));
 }
 
 static unique_ptr<Statement> parseAssignOrError() {
   if (peek() != IDENT) throw runtime_error("Parse error: expected IDENT to start assignment");
   string id = peekLex;
-  if (!symbolTable.count(id))
+  size_t slot = declared.find(peekKey);
+  if (slot == DeclTable::NONE)
     throw runtime_error("Parse error: ASSIGN to undeclared identifier " + id);
   nextTok();
-  return parseAssignStmtWithLeadingIdent(id);
+  return parseAssignStmtWithLeadingIdent(id, slot);
 }
 
 static unique_ptr<Statement> parseSenioritisStmt() {
@@ -343,23 +456,41 @@ static unique_ptr<Statement> parseIfStmt() {
 
 
 
+// With gReplay->spans set, each statement is recorded with its token range.
+static size_t replayPos() { return gReplay ? gReplay->pos : 0; }
+static void noteSpan(Statement* s, size_t first) {
+  if (gReplay && gReplay->spans)
+    gReplay->spans->push_back({s, static_cast<uint32_t>(first), static_cast<uint32_t>(gReplay->pos)});
+}
+
 static unique_ptr<Statement> parseStatement() {
-  switch (peek()) {
-    case READ:       return parseReadStmt();
-    case WRITE:      return parseWriteStmt();
-    case TOK_BEGIN:  return parseCompound();
-    case IF:         return parseIfStmt();
-    case WHILE:      return parseWhileStmt();
-    case SENIORITIS: return parseSenioritisStmt();
-    case IDENT:      return parseAssignOrError();
+  Token t = peek();
+  int line = peekLine;
+  size_t first = replayPos();
+  unique_ptr<Statement> s;
+  switch (t) {
+    case READ:       s = parseReadStmt(); break;
+    case WRITE:      s = parseWriteStmt(); break;
+    case TOK_BEGIN:  return gLazyParse ? skipCompound() : parseCompound();
+    case IF:         s = parseIfStmt(); break;
+    case WHILE:      s = parseWhileStmt(); break;
+    case SENIORITIS: s = parseSenioritisStmt(); break;
+    case IDENT:      s = parseAssignOrError(); break;
     default:
       throw runtime_error(string("Parse error: unexpected token in statement: ") + tname(peek()));
   }
+  s->line = line;
+  noteSpan(s.get(), first);
+  return s;
 }
 
 static unique_ptr<Statement> parseCompound() {
+  peek();
+  int line = peekLine;
+  size_t first = replayPos();
   expect(TOK_BEGIN, "expected BEGIN to start a compound statement");
   auto comp = make_unique<CompoundStmt>();
+  comp->line = line;
 
   if (peek() != END) {
     comp->stmts.push_back(parseStatement());
@@ -370,10 +501,82 @@ static unique_ptr<Statement> parseCompound() {
   }
 
   expect(END, "expected END to close compound statement");
+  noteSpan(comp.get(), first);
   return comp;
 }
 
 
+// -----------------------------------------------------------------------------
+// Deferred compound statements (--lazy, see lazy.h)
+// -----------------------------------------------------------------------------
+bool gLazyParse = false;
+
+static string lazySource;         // the whole program, scanned through lazyFile
+static FILE* lazyFile = nullptr;
+static vector<size_t> lineStart;  // offset of each line in lazySource, on first use
+
+void startLazyParse(string source) {
+  lazySource = std::move(source);
+  lineStart.clear();
+  if (lazyFile) fclose(lazyFile);
+  lazyFile = fmemopen(const_cast<char*>(lazySource.data()), lazySource.size(), "r");
+  if (!lazyFile) throw runtime_error("--lazy: cannot scan the program text");
+  restartScanner(lazyFile);
+  yylineno = 1;
+  havePeek = false;
+  countedLine = 0;
+  gLazyParse = true;
+}
+
+// BEGIN ... its END, scanned without building anything: only the nesting is
+// tracked, straight off gLex() so no lexeme is copied.
+static unique_ptr<Statement> skipCompound() {
+  auto lazy = make_unique<LazyStmt>();
+  lazy->line = peekLine;
+  lazy->skip = peekInLine;
+  nextTok();
+  for (int depth = 1; depth > 0;) {
+    Token t = gLex();
+    countInLine(yylineno);
+    if (t == 0) {  // report it as the eager parser does
+      peekTok = TOK_EOF;
+      peekLex.clear();
+      peekLine = yylineno;
+      havePeek = true;
+      expect(END, "expected END to close compound statement");
+    }
+    if (t == TOK_BEGIN) ++depth;
+    else if (t == END) --depth;
+  }
+  lazy->endLine = yylineno;
+  return lazy;
+}
+
+void LazyStmt::parseBody() const {
+  if (lineStart.empty()) {
+    lineStart.push_back(0);
+    for (size_t i = 0; i < lazySource.size(); ++i)
+      if (lazySource[i] == '\n') lineStart.push_back(i + 1);
+  }
+  size_t from = lineStart[static_cast<size_t>(line - 1)];
+  size_t to = static_cast<size_t>(endLine) < lineStart.size() ? lineStart[static_cast<size_t>(endLine)]
+                                                             : lazySource.size();
+  FILE* in = fmemopen(const_cast<char*>(lazySource.data() + from), to - from, "r");
+  if (!in) throw runtime_error("--lazy: cannot scan the program text");
+  restartScanner(in);
+  yylineno = line;
+  havePeek = false;
+  countedLine = 0;
+  try {
+    for (uint32_t k = 0; k < skip; ++k) nextTok();  // what precedes BEGIN on its line
+    body = parseCompound();
+  } catch (...) {
+    fclose(in);
+    throw;
+  }
+  fclose(in);
+}
+
 // block → BEGIN write END
 unique_ptr<Block> parseBlock() {
   auto b = make_unique<Block>();
@@ -401,3 +604,30 @@ unique_ptr<Program> parseProgram() {
   expect(TOK_EOF, "at end of file (no trailing tokens after program)");
   return p;
 }
+
+// -----------------------------------------------------------------------------
+// Incremental reparsing (incremental.cpp): one statement, or a run of them,
+// filling gReplay's window exactly
+// -----------------------------------------------------------------------------
+unique_ptr<Statement> parseStatementWindow() {
+  havePeek = false;
+  auto s = parseStatement();
+  expect(TOK_EOF, "at end of reparsed statement");
+  return s;
+}
+
+vector<unique_ptr<Statement>> parseStatementRunWindow() {
+  havePeek = false;
+  vector<unique_ptr<Statement>> run;
+  run.push_back(parseStatement());
+  while (accept(SEMICOLON)) run.push_back(parseStatement());
+  expect(TOK_EOF, "at end of reparsed statements");
+  return run;
+}
+
+void resetParser() {
+  havePeek = false;
+  declared = DeclTable();
+  symbolTable.clear();
+  varFrame = Frame();
+}
@@ -0,0 +1,99 @@
+// =============================================================================
+//   pipeline.cpp — SPSC token ring between the scanner thread and the parser
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   head and tail count tokens from the start of the input; a token lives in
+//   slots[index % CAPACITY]. The scanner publishes tail every BATCH tokens
+//   (and before it waits, and at EOF) so the parser's core is not pulling
+//   the tail cache line across on every token. Slot strings keep their
+//   buffers from lap to lap: the parser swaps a slot's text with its own
+//   record, and the scanner assigns into whatever buffer it gets back.
+// =============================================================================
+#include <thread>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "pipeline.h"
+using namespace std;
+
+TokenPipeline* gPipeline = nullptr;
+
+namespace {
+
+// Spin briefly, then give the core away: on one core the other side can
+// only make progress once we yield.
+struct Backoff {
+  unsigned spins = 0;
+  void wait() {
+    if (spins < 64) {
+      ++spins;
+#if defined(__SSE2__)
+      _mm_pause();
+#endif
+    } else {
+      this_thread::yield();
+    }
+  }
+};
+
+}  // namespace
+
+TokenPipeline::TokenPipeline(int (*lex)(void)) : slots(CAPACITY) {
+  scanner = thread([this, lex] { scan(lex); });
+}
+
+TokenPipeline::~TokenPipeline() {
+  stopping.store(true, memory_order_relaxed);
+  if (scanner.joinable()) scanner.join();
+}
+
+// -----------------------------------------------------------------------------
+// Producer: the scanner thread
+// -----------------------------------------------------------------------------
+void TokenPipeline::scan(int (*lex)(void)) {
+  size_t t = 0;          // next slot to fill
+  size_t published = 0;  // tail as the parser last saw it
+  for (;;) {
+    Token tok = lex();
+
+    if (t - head.load(memory_order_acquire) == CAPACITY) {
+      tail.store(published = t, memory_order_release);
+      Backoff b;
+      while (t - head.load(memory_order_acquire) == CAPACITY) {
+        if (stopping.load(memory_order_relaxed)) return;
+        b.wait();
+      }
+    }
+
+    TokenRecord& r = slots[t % CAPACITY];
+    r.tok = tok;
+    r.line = yylineno;
+    r.key = tok == IDENT ? yyidkey : 0;
+    r.text.assign(yytext && tok != 0 ? yytext : "");
+    ++t;
+
+    if (tok == 0) { tail.store(t, memory_order_release); return; }
+    if (t - published >= BATCH) tail.store(published = t, memory_order_release);
+    if (stopping.load(memory_order_relaxed)) return;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Consumer: the parser
+// -----------------------------------------------------------------------------
+void TokenPipeline::next(TokenRecord& out) {
+  if (atEof) { out.tok = 0; out.text.clear(); out.key = 0; return; }
+  size_t h = head.load(memory_order_relaxed);
+  Backoff b;
+  while (tail.load(memory_order_acquire) == h) b.wait();
+
+  TokenRecord& r = slots[h % CAPACITY];
+  out.tok = r.tok;
+  out.line = r.line;
+  out.key = r.key;
+  out.text.swap(r.text);
+  head.store(h + 1, memory_order_release);
+  atEof = out.tok == 0;
+}
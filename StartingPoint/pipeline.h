@@ -0,0 +1,65 @@
+// =============================================================================
+//   pipeline.h — scanner on its own thread, feeding the parser (--pipeline)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   A TokenPipeline starts a thread that calls gLex() until EOF and pushes
+//   one TokenRecord per token into a fixed single-producer/single-consumer
+//   ring; the parser's peek() pops them instead of calling gLex() itself.
+//   The ring's two indices are the only shared state (release on push,
+//   acquire on pop), so neither side takes a lock. A full ring parks the
+//   scanner and an empty one the parser, each spinning briefly and then
+//   yielding.
+//
+//   The scanner thread owns yytext, yylineno and yyidkey while it runs, so
+//   the parser must read a token's text, line and key from its record, not
+//   from those globals.
+// =============================================================================
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lexer.h"
+
+struct TokenRecord {
+  Token tok = 0;            // 0 at EOF, as gLex() returns it
+  int line = 0;             // yylineno after the token was scanned
+  uint64_t key = 0;         // yyidkey when tok is IDENT
+  std::string text;         // yytext
+};
+
+class TokenPipeline {
+public:
+  // Starts scanning yyin with `lex` on a new thread.
+  explicit TokenPipeline(int (*lex)(void));
+
+  // Stops the scanner if the parser gave up early, then joins it.
+  ~TokenPipeline();
+
+  TokenPipeline(const TokenPipeline&) = delete;
+  TokenPipeline& operator=(const TokenPipeline&) = delete;
+
+  // Moves the next token into `out`, waiting for the scanner if needed.
+  // Once EOF has been returned, every later call returns EOF again.
+  void next(TokenRecord& out);
+
+private:
+  static constexpr size_t CAPACITY = 1024;  // power of two; 48 KiB of records
+  static constexpr size_t BATCH = 64;       // tokens per publish of `tail`
+
+  void scan(int (*lex)(void));
+
+  std::vector<TokenRecord> slots;
+  alignas(64) std::atomic<size_t> head{0};  // next slot the parser pops
+  alignas(64) std::atomic<size_t> tail{0};  // one past the last slot pushed
+  alignas(64) std::atomic<bool> stopping{false};
+  bool atEof = false;                       // parser side only
+  std::thread scanner;
+};
+
+// The pipeline peek() reads from, or nullptr to call gLex() directly.
+extern TokenPipeline* gPipeline;
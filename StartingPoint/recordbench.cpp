@@ -0,0 +1,121 @@
+// =============================================================================
+//   recordbench.cpp — --records lanes against sequential runs in one process
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Parses FILE once, then runs it once per line of RECORDS two ways in the
+//   same process:
+//     sequential  the ordinary interpreter, one record after another, each
+//                 on a fresh copy of the frame with its line as input
+//     lanes       runRecords() (batch.h) on one thread
+//   Both render what --records prints (-s: with symbol tables) and must
+//   agree byte for byte; the bench exits 1 if they do not. Times are the
+//   best of REPS runs, so the comparison leaves out process start-up and
+//   parsing, which one --records process saves over many plain ones anyway.
+//
+//   Build/run:  make recordbench && ./recordbench FILE RECORDS [-s] [reps]
+// =============================================================================
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "batch.h"
+#include "incremental.h"
+#include "lexer.h"
+#include "simdscan.h"
+using namespace std;
+
+unique_ptr<Program> parseProgram();
+
+using Clock = chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+  return chrono::duration<double, milli>(Clock::now() - t0).count();
+}
+
+// What runRecords() writes for `lines`, one plain run at a time.
+static void sequential(const Program& prog, const vector<string>& lines, bool symbols,
+                       string& text, string& errors) {
+  ostringstream out, err;
+  for (size_t r = 0; r < lines.size(); ++r) {
+    Frame frame = varFrame;
+    istringstream in(lines[r]);
+    activeFrame = &frame;
+    activeInput = &in;
+    try {
+      if (prog.block) prog.block->interpret(out);
+      if (symbols) printSymbols(out, frame);
+    } catch (const runtime_error& e) {
+      err << "record " << r + 1 << ": " << e.what() << "\n";
+    }
+  }
+  activeFrame = &varFrame;
+  activeInput = &cin;
+  text = out.str();
+  errors = err.str();
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s FILE RECORDS [-s] [reps]\n", argv[0]);
+    return 1;
+  }
+  bool symbols = argc > 3 && !strcmp(argv[3], "-s");
+  int reps = argc > 3 + symbols ? atoi(argv[3 + symbols]) : 3;
+  if (reps < 1) reps = 1;
+
+  FILE* src = fopen(argv[1], "r");
+  if (!src) { perror(argv[1]); return 1; }
+  unique_ptr<Program> prog;
+  try {
+    resetParser();
+    restartScanner(src);
+    yylineno = 1;
+    prog = parseProgram();
+  } catch (const exception& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  fclose(src);
+
+  ifstream rf(argv[2]);
+  if (!rf) { perror(argv[2]); return 1; }
+  vector<string> lines;
+  string all;
+  for (string line; getline(rf, line);) {
+    lines.push_back(line);
+    all += line + "\n";
+  }
+
+  string seqText, seqErr, laneText, laneErr;
+  double seqMs = 1e300, laneMs = 1e300;
+  for (int k = 0; k < reps; ++k) {
+    auto t0 = Clock::now();
+    sequential(*prog, lines, symbols, seqText, seqErr);
+    seqMs = min(seqMs, msSince(t0));
+
+    istringstream records(all);
+    ostringstream out, err;
+    RecordOptions opts;
+    opts.symbols = symbols;
+    t0 = Clock::now();
+    runRecords(*prog, records, out, err, opts);
+    laneMs = min(laneMs, msSince(t0));
+    laneText = out.str();
+    laneErr = err.str();
+  }
+
+  if (seqText != laneText || seqErr != laneErr) {
+    fprintf(stderr, "--records output differs from the sequential runs\n");
+    return 1;
+  }
+  printf("%zu records: sequential %.1f ms, lanes %.1f ms (%.2fx)\n", lines.size(), seqMs, laneMs,
+         seqMs / laneMs);
+  return 0;
+}
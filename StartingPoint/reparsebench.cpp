@@ -0,0 +1,165 @@
+// =============================================================================
+//   reparsebench.cpp — single-line edit latency: incremental vs full parse
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Loads a TIPS program into an IncrementalParser (incremental.h) and then
+//   applies random one-line edits to its assignment lines, timing each
+//   apply(). The edits, in equal shares:
+//     tweak   change one number on the line (same tokens, new lexeme)
+//     grow    append " + 1" to the right-hand side
+//     insert  add "X := X + 1;" above the line, for its target X
+//     delete  remove the line
+//   Insertions and deletions only go where a compound's statement starts
+//   (after a line ending in ';' or BEGIN), so every edit leaves a valid
+//   program.
+//   A full parse is timed for comparison: scan + parse of the whole source,
+//   and parse alone from the token list (what apply() falls back to).
+//
+//   Every `check` edits the tree is written with writeAstBinary (which keeps
+//   statement lines) and compared with a fresh full parse of the edited
+//   source; the run fails on the first difference.
+//
+//   Build/run:  make reparsebench && ./reparsebench FILE [edits] [check]
+// =============================================================================
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "astdump.h"
+#include "incremental.h"
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+  return chrono::duration<double, milli>(Clock::now() - t0).count();
+}
+
+static string dumpOf(IncrementalParser& s) {
+  ostringstream os;
+  writeAstBinary(*s.program(), os);
+  return os.str();
+}
+
+// "  NAME := ...;" or without the ';' — the assignment target, or "".
+static string assignTarget(const string& line) {
+  size_t p = line.find_first_not_of(' ');
+  if (p == string::npos || line[p] < 'A' || line[p] > 'Z') return "";
+  size_t e = line.find(" := ", p);
+  if (e == string::npos) return "";
+  for (size_t k = p; k < e; ++k)
+    if (!((line[k] >= 'A' && line[k] <= 'Z') || (line[k] >= '0' && line[k] <= '9'))) return "";
+  return line.substr(p, e - p);
+}
+
+// Line n starts a statement of a compound: the line before ends in ';' or
+// BEGIN, so inserting or deleting a "...;" line there keeps the program valid.
+static bool afterSeparator(IncrementalParser& s, int n) {
+  if (n < 2) return false;
+  const string& prev = s.line(n - 1);
+  return !prev.empty() && (prev.back() == ';' ||
+                           (prev.size() >= 5 && prev.compare(prev.size() - 5, 5, "BEGIN") == 0));
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s FILE [edits] [check]\n", argv[0]);
+    return 1;
+  }
+  ifstream in(argv[1], ios::binary);
+  if (!in) { perror(argv[1]); return 1; }
+  string src((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  int edits = argc > 2 ? atoi(argv[2]) : 1000;
+  int check = argc > 3 ? atoi(argv[3]) : 100;
+
+  try {
+    auto t0 = Clock::now();
+    auto session = make_unique<IncrementalParser>(src);
+    double scanParse = msSince(t0);
+    t0 = Clock::now();
+    session->reparseAll();
+    double parseOnly = msSince(t0);
+    printf("%zu lines; full parse: %.1f ms scan+parse, %.1f ms parse from tokens\n",
+           session->lineCount(), scanParse, parseOnly);
+
+    mt19937 rng(4714);
+    vector<double> ms;
+    size_t fulls = 0, parsed = 0, checks = 0;
+    const char* kinds[] = {"tweak", "grow", "insert", "delete"};
+    size_t perKind[4] = {0, 0, 0, 0};
+    double msKind[4] = {0, 0, 0, 0};
+    while (static_cast<int>(ms.size()) < edits) {
+      int n = static_cast<int>(uniform_int_distribution<size_t>(1, session->lineCount())(rng));
+      const string& line = session->line(n);
+      string target = assignTarget(line);
+      if (target.empty()) continue;
+      bool semi = line.back() == ';';
+      string body = semi ? line.substr(0, line.size() - 1) : line;
+      int kind = static_cast<int>(ms.size() % 4);
+
+      TextEdit e;
+      e.line = n;
+      e.count = 1;
+      if (kind == 0) {
+        size_t d = body.find_last_of("0123456789");
+        if (d == string::npos || d < body.find(":=")) continue;
+        string edited = line;
+        edited[d] = static_cast<char>('0' + (edited[d] - '0' + 1) % 10);
+        e.text = edited + "\n";
+      } else if (kind == 1) {
+        e.text = body + " + 1" + (semi ? ";" : "") + "\n";
+      } else if (kind == 2) {
+        if (!afterSeparator(*session, n)) continue;
+        e.count = 0;
+        e.text = "  " + target + " := " + target + " + 1;\n";
+      } else {
+        if (!semi || !afterSeparator(*session, n)) continue;
+        e.text.clear();
+      }
+
+      auto t = Clock::now();
+      ReparseStats st = session->apply(e);
+      double dt = msSince(t);
+      ms.push_back(dt);
+      perKind[kind]++;
+      msKind[kind] += dt;
+      fulls += st.full;
+      parsed += st.tokensParsed;
+
+      if (check > 0 && ms.size() % static_cast<size_t>(check) == 0) {
+        string incremental = dumpOf(*session);
+        session = make_unique<IncrementalParser>(session->source());
+        if (dumpOf(*session) != incremental) {
+          fprintf(stderr, "MISMATCH after edit %zu (%s at line %d)\n", ms.size(), kinds[kind], n);
+          return 1;
+        }
+        ++checks;
+      }
+    }
+
+    sort(ms.begin(), ms.end());
+    double sum = 0;
+    for (double v : ms) sum += v;
+    auto pct = [&](double p) { return ms[min(ms.size() - 1, static_cast<size_t>(p * ms.size()))]; };
+    printf("%zu edits: mean %.3f ms, median %.3f ms, p99 %.3f ms, max %.3f ms\n", ms.size(),
+           sum / ms.size(), pct(0.5), pct(0.99), ms.back());
+    for (int k = 0; k < 4; ++k)
+      if (perKind[k]) printf("  %-7s %5zu edits, mean %.3f ms\n", kinds[k], perKind[k], msKind[k] / perKind[k]);
+    printf("tokens reparsed per edit: %.1f; full-parse fallbacks: %zu\n",
+           static_cast<double>(parsed) / ms.size(), fulls);
+    printf("speedup vs scan+parse: %.0fx (median)\n", scanParse / pct(0.5));
+    printf("checked against a full parse: %zu times, all identical\n", checks);
+  } catch (const exception& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
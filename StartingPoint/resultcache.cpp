@@ -0,0 +1,186 @@
+// =============================================================================
+//   resultcache.cpp — run records, their files and lookup by input
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   See resultcache.h for what is stored and why a lookup is sound.
+//   RecordedInput hands the stream one byte at a time, so every byte `>>`
+//   looks at, including the one it only peeks at, passes through
+//   underflow() and is counted.
+// =============================================================================
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "hashing.h"
+#include "resultcache.h"
+using namespace std;
+
+namespace {
+
+constexpr char RESULT_MAGIC[4] = {'T', 'I', 'P', 'R'};
+constexpr size_t MAX_RUNS = 16;             // per program, newest kept
+constexpr size_t MAX_KEPT = 64u << 20;      // longest output stored
+
+void putField(string& out, const string& s) {
+  putU64(out, s.size());
+  out += s;
+}
+
+// Reads a field at `p`; false if the file ends first.
+bool getField(const string& data, size_t& p, string& out) {
+  if (data.size() - p < 8) return false;
+  uint64_t n = 0;
+  for (int i = 7; i >= 0; --i) n = (n << 8) | static_cast<unsigned char>(data[p + i]);
+  p += 8;
+  if (data.size() - p < n) return false;
+  out.assign(data, p, n);
+  p += n;
+  return true;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+// RecordedInput
+// -----------------------------------------------------------------------------
+bool RecordedInput::fill(size_t n) {
+  char buf[1 << 16];
+  while (data.size() < n && !eof) {
+    ssize_t got = ::read(fd, buf, sizeof buf);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) eof = true;
+    else data.append(buf, static_cast<size_t>(got));
+  }
+  return data.size() >= n;
+}
+
+RecordedInput::int_type RecordedInput::underflow() {
+  if (!fill(next + 1)) {
+    atEnd = true;
+    return traits_type::eof();
+  }
+  char* b = &data[0];
+  setg(b + next, b + next, b + next + 1);
+  hi = max(hi, ++next);
+  return traits_type::to_int_type(data[next - 1]);
+}
+
+// -----------------------------------------------------------------------------
+// RecordedOutput
+// -----------------------------------------------------------------------------
+void RecordedOutput::flushBuf() {
+  size_t n = static_cast<size_t>(pptr() - pbase());
+  if (n == 0) return;
+  if (!dropped && kept.size() + n > MAX_KEPT) {
+    dropped = true;
+    string().swap(kept);
+  }
+  if (!dropped) kept.append(pbase(), n);
+  target->sputn(pbase(), static_cast<streamsize>(n));
+  setp(buf, buf + sizeof buf);
+}
+
+RecordedOutput::int_type RecordedOutput::overflow(int_type c) {
+  flushBuf();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+int RecordedOutput::sync() {
+  flushBuf();
+  return target->pubsync();
+}
+
+// -----------------------------------------------------------------------------
+// ResultCache
+// -----------------------------------------------------------------------------
+string executableStamp(const string& exe) {
+  struct stat st;
+  if (exe.empty() || stat(exe.c_str(), &st) != 0) return "";
+#ifdef __APPLE__
+  const timespec& mtime = st.st_mtimespec;
+#else
+  const timespec& mtime = st.st_mtim;
+#endif
+  ostringstream stamp;
+  stamp << st.st_size << ' ' << mtime.tv_sec << '.' << mtime.tv_nsec;
+  return stamp.str();
+}
+
+ResultCache::ResultCache(const string& dir, string_view source, const string& skin, string_view flags,
+                         const string& stamp) {
+  if (mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST)
+    throw runtime_error("result cache: cannot create " + dir + ": " + strerror(errno));
+
+  string format(RESULT_MAGIC, sizeof RESULT_MAGIC);
+  format.push_back(static_cast<char>(RESULT_FORMAT_VERSION));
+  uint64_t h = programKey(format, source, skin, flags);
+  fnv::field(h, stamp);
+  char name[24];
+  snprintf(name, sizeof name, "%016llx.run", static_cast<unsigned long long>(h));
+  path = dir + "/" + name;
+  load();
+}
+
+void ResultCache::load() {
+  ifstream f(path, ios::binary);
+  if (!f) return;
+  string data((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
+  if (data.size() < 5 || memcmp(data.data(), RESULT_MAGIC, 4) != 0 ||
+      static_cast<uint8_t>(data[4]) != RESULT_FORMAT_VERSION)
+    return;  // another format: replaced by the next store
+  size_t p = 5;
+  while (p < data.size() && runs.size() < MAX_RUNS) {
+    CachedRun r;
+    uint8_t flags = static_cast<uint8_t>(data[p++]);
+    r.sawEnd = flags & 1;
+    r.failed = flags & 2;
+    if (!getField(data, p, r.consumed) || !getField(data, p, r.output) ||
+        !getField(data, p, r.error) || !getField(data, p, r.symbols))
+      break;  // cut short: keep the runs before it
+    runs.push_back(std::move(r));
+  }
+}
+
+const CachedRun* ResultCache::find(RecordedInput& in) {
+  for (const CachedRun& r : runs) {
+    size_t n = r.consumed.size();
+    if (!in.fill(n) || in.bytes().compare(0, n, r.consumed) != 0) continue;
+    if (r.sawEnd && in.fill(n + 1)) continue;  // this input goes on
+    return &r;
+  }
+  return nullptr;
+}
+
+void ResultCache::store(const RecordedInput& in, CachedRun run) {
+  run.consumed.assign(in.bytes(), 0, in.examined());
+  run.sawEnd = in.sawEnd();
+  runs.insert(runs.begin(), std::move(run));
+  if (runs.size() > MAX_RUNS) runs.pop_back();
+
+  string data(RESULT_MAGIC, sizeof RESULT_MAGIC);
+  data.push_back(static_cast<char>(RESULT_FORMAT_VERSION));
+  for (const CachedRun& r : runs) {
+    data.push_back(static_cast<char>((r.sawEnd ? 1 : 0) | (r.failed ? 2 : 0)));
+    putField(data, r.consumed);
+    putField(data, r.output);
+    putField(data, r.error);
+    putField(data, r.symbols);
+  }
+  string tmp = path + ".tmp." + to_string(getpid());
+  FILE* f = fopen(tmp.c_str(), "wb");
+  if (!f) return;
+  bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+  if (fclose(f) != 0) ok = false;
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) unlink(tmp.c_str());
+}
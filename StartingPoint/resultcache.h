@@ -0,0 +1,124 @@
+// =============================================================================
+//   resultcache.h — stored results of earlier runs (--result-cache=DIR)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Grading runs the same program on the same input again and again. With
+//   --result-cache=DIR, a plain run of a program file stores what it wrote,
+//   how it ended and its final symbol table; a later run of the same program
+//   that is given the same input prints the stored result without parsing
+//   or running anything.
+//
+//   "Same program" is the key: a hash of the source, the keyword skin (the
+//   file's contents for a skin file), the flags that change how the tree is
+//   built or run (-O, --flat, --threads) and the interpreter executable's
+//   size and modification time, so a rebuilt interpreter starts afresh. An
+//   interpreter that cannot find its own file runs without the cache.
+//   "Same input" cannot be decided up front, since how much of it READ
+//   takes depends on the run. A run therefore reads its input through a
+//   RecordedInput, which notes every byte the READs looked at (`>>` looks
+//   one byte past each number) and whether they ran into the end of the
+//   input. Any input that starts with exactly those bytes, and, if the run
+//   saw the end, has nothing after them, makes the run behave the same. A
+//   lookup reads stdin only as far as the stored runs need to tell.
+//
+//   DIR holds one file per key, KEY.run: "TIPR", u8 version, then up to
+//   MAX_RUNS runs, newest first, each
+//     u8 flags (1: the input ended after `consumed`, 2: the run failed)
+//     u64 n, n bytes consumed input      u64 n, n bytes output
+//     u64 n, n bytes error message       u64 n, n bytes symbol table
+//   with u64s little endian. Files are replaced by rename(), so processes
+//   sharing DIR never see half a file; two storing at once may lose one of
+//   the runs, which just means a later miss.
+// =============================================================================
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint8_t RESULT_FORMAT_VERSION = 2;  // 2: program keys hash field lengths
+
+struct CachedRun {
+  std::string consumed;  // input bytes the READs looked at
+  bool sawEnd = false;   // they looked past the last byte of the input
+  bool failed = false;   // stopped on a runtime error: `error`
+  std::string output;    // WRITE output
+  std::string error;
+  std::string symbols;   // printSymbols() of the final frame (if not failed)
+};
+
+// READ input from a file descriptor that keeps every byte it has read and
+// notes how far reading has looked.
+class RecordedInput : public std::streambuf {
+public:
+  explicit RecordedInput(int fd) : fd(fd) {}
+
+  // Reads until n bytes are held or the input ends; true if n are held.
+  bool fill(size_t n);
+  const std::string& bytes() const { return data; }
+  size_t examined() const { return hi; }   // bytes looked at through the stream
+  bool sawEnd() const { return atEnd; }
+
+protected:
+  int_type underflow() override;
+
+private:
+  int fd;
+  std::string data;
+  size_t next = 0;     // index of the next byte to hand out
+  size_t hi = 0;
+  bool atEnd = false;  // the stream asked past the last byte
+  bool eof = false;    // fd has no more
+};
+
+// Output that goes to `target` and is also kept, up to a limit, for storing.
+// Buffered; flush the stream before take().
+class RecordedOutput : public std::streambuf {
+public:
+  explicit RecordedOutput(std::streambuf* target) : target(target) { setp(buf, buf + sizeof buf); }
+  std::string take() { return std::move(kept); }  // what was kept, once
+  bool complete() const { return !dropped; }  // false: too long to store
+
+protected:
+  int_type overflow(int_type c) override;
+  int sync() override;
+
+private:
+  std::streambuf* target;
+  std::string kept;
+  bool dropped = false;
+  char buf[8192];
+  void flushBuf();
+};
+
+// Size and modification time of the executable `exe` (bundle.h's
+// selfExecutable()), for the key; empty if it cannot be stat()ed.
+std::string executableStamp(const std::string& exe);
+
+class ResultCache {
+public:
+  // `flags` describes the run options that are part of the key, `stamp` is
+  // executableStamp() of the interpreter. Throws runtime_error if DIR
+  // cannot be created.
+  ResultCache(const std::string& dir, std::string_view source, const std::string& skin,
+              std::string_view flags, const std::string& stamp);
+
+  // The stored run that `in` makes happen again, or null. Reads `in` only
+  // as far as needed to decide.
+  const CachedRun* find(RecordedInput& in);
+
+  // Adds `run` (of the input `in` recorded) in front of the stored ones.
+  // Failing to write is not an error: the run is then just not cached.
+  void store(const RecordedInput& in, CachedRun run);
+
+private:
+  std::string path;
+  std::vector<CachedRun> runs;
+
+  void load();
+};
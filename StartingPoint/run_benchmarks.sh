@@ -0,0 +1,1145 @@
+#!/usr/bin/env bash
+# =============================================================================
+# run_benchmarks.sh — timing + differential checks for interpreter options
+# -----------------------------------------------------------------------------
+# Each section generates a TIPS workload, runs it once with the reference
+# interpreter and once per option under test, fails if stdout differs (the
+# symbol table is dumped with -s, so final variable values are compared too),
+# and prints the wall time of each run. The `optimize` section diffs `-s`
+# against `-O -s` on every test program, whether or not it runs to the end;
+# the `values` section instead runs the exprbench microbenchmark (see
+# exprbench.cpp); the `records` section compares one process per input line
+# against a single --records run, times the lanes against in-process
+# sequential runs (recordbench.cpp), then times
+# --records sharded over 1 .. all cores; the `strings` section reports time
+# and peak memory of WRITE-literal-heavy programs, `skins` times the token
+# dump of one program spelled in every built-in keyword skin, `scanner`
+# compares the flex and hand-written scanners token for token (these two are
+# skipped unless lex.yy.c was generated by flex), `pipeline`
+# times parsing with the scanner on its own thread (--pipeline), `printer`
+# times -p on a very deep tree, `dumps` compares the text dumps with the
+# machine-readable ones and runs a program from its binary AST, `reparse`
+# times single-line edits through the incremental parser (reparsebench.cpp),
+# `lazy` measures time to first output with deferred body parsing,
+# `bundle` times --bundle executables against parsing the same program,
+# `daemon` load-tests tipsd against one parse process per run and checks that
+# clients hanging up on silent runs do not keep its workers,
+# `sessions` holds 10k runs suspended on READ on one thread (sessionbench.cpp),
+# `resultcache` times runs stored by --result-cache against fresh ones,
+# `limits` times runs under --max-steps/--timeout/--max-output limits they
+# stay within, checks that loops -O collapses or threads count the same steps,
+# then checks that runaway programs are stopped, and
+# `checkpoint` stops a long run with SIGTERM over and over, resuming it from
+# its snapshot each time, and compares the pieces with an unbroken run.
+#
+# Usage: ./run_benchmarks.sh [section]     (default: all sections)
+# =============================================================================
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+cd "$ROOT"
+
+TARGET="./parse"
+SECTION="${1:-all}"
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+if [[ ! -x "$TARGET" ]]; then
+  echo "[build] parser binary not found, running make..."
+  make
+fi
+
+# run_timed OUT INPUT CMD... : runs CMD with INPUT on stdin, stdout to OUT,
+# and echoes elapsed seconds.
+run_timed() {
+  local out="$1" input="$2"; shift 2
+  local t0 t1
+  t0=$(date +%s%N)
+  printf "%s" "$input" | "$@" > "$out" 2>&1 || true
+  t1=$(date +%s%N)
+  awk -v ns=$(( t1 - t0 )) 'BEGIN { printf "%.3f", ns / 1e9 }'
+}
+
+# flex_built NAME : true if lex.yy.c came from flex. The flex scanner is the
+# reference the `scanner` and `skins` sections measure against, so without
+# it they report nothing rather than a differential against a stand-in.
+flex_built() {
+  if grep -q '^#define FLEX_SCANNER' lex.yy.c 2> /dev/null; then return 0; fi
+  printf "  %-28s NOT RUN: lex.yy.c is not flex output; install flex and rebuild\n" "$1"
+  return 1
+}
+
+# compare NAME FILE INPUT FLAGS... : reference run vs. run with FLAGS.
+compare() {
+  local name="$1" file="$2" input="$3"; shift 3
+  local ref="$WORK/$name.ref" opt="$WORK/$name.opt"
+  local tr to
+  tr=$(run_timed "$ref" "$input" "$TARGET" -s "$file")
+  to=$(run_timed "$opt" "$input" "$TARGET" -s "$@" "$file")
+  if ! grep -q "executed successfully" "$ref"; then
+    printf "  %-28s REFERENCE RUN FAILED\n" "$name"
+    tail -5 "$ref"
+    exit 1
+  fi
+  if diff -q "$ref" "$opt" > /dev/null; then
+    printf "  %-28s ref %7ss   %-14s %7ss   identical\n" "$name" "$tr" "$*" "$to"
+  else
+    printf "  %-28s OUTPUT DIFFERS with %s\n" "$name" "$*"
+    diff "$ref" "$opt" | head -20
+    exit 1
+  fi
+}
+
+want() { [[ "$SECTION" == "all" || "$SECTION" == "$1" ]]; }
+
+# run_peak OUT CMD... : runs CMD (stdin from /dev/null, stdout to OUT) and
+# echoes "<seconds> <peak RSS in kB>", polling /proc for the high-water mark.
+run_peak() {
+  local out="$1"; shift
+  local t0 t1 pid hwm=0 h
+  t0=$(date +%s%N)
+  "$@" < /dev/null > "$out" 2>&1 &
+  pid=$!
+  while kill -0 "$pid" 2> /dev/null; do
+    h=$(awk '/^VmHWM:/ { print $2 }' "/proc/$pid/status" 2> /dev/null || true)
+    [[ -n "$h" ]] && (( h > hwm )) && hwm=$h
+    sleep 0.01
+  done
+  wait "$pid" || true
+  t1=$(date +%s%N)
+  awk -v ns=$(( t1 - t0 )) -v kb="$hwm" 'BEGIN { printf "%.3f %d\n", ns / 1e9, kb }'
+}
+
+# -----------------------------------------------------------------------------
+# -O as a whole: the symbol table and output of every test program, and of
+# programs built around what -O removes (dead stores to variables -s dumps,
+# constant-false IF/WHILE, VARs nothing mentions), must not change
+# -----------------------------------------------------------------------------
+if want optimize; then
+  echo "== -O against the unoptimized run =="
+  cat > "$WORK/dead.tips" <<'EOF'
+PROGRAM DEADCODE;
+VAR A : INTEGER; B : INTEGER; C : REAL; U : INTEGER; Z : INTEGER; N : INTEGER;
+BEGIN
+  READ(N);
+  A := 5; A := N * 2;
+  B := 1;
+  IF 1 = 0 THEN B := 99;
+  IF 0 > 1 THEN WRITE('never') ELSE B := B + N;
+  WHILE 1 = 2 BEGIN B := 0; WRITE('never') END;
+  WHILE NOT (N = N) BEGIN WRITE('never') END;
+  C := 1.5; C := C * 2.0;
+  IF NOT (1 = 1) THEN C := 0.0;
+  U := 7; U := 8;
+  WRITE(A); WRITE(B); WRITE(C)
+END
+EOF
+  cat > "$WORK/deadloop.tips" <<'EOF'
+PROGRAM DEADLOOP;
+VAR I : INTEGER; N : INTEGER; T : INTEGER; L : INTEGER;
+BEGIN
+  READ(N); I := 0; T := 0;
+  WHILE I < N
+    BEGIN
+      L := I * 3;
+      IF 2 < 1 THEN T := T - 1000;
+      L := I;
+      T := T + L;
+      I := I + 1
+    END;
+  L := 0
+END
+EOF
+  inputs=("3 4 2 1 5 6 7 8 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20"
+          "12 18 3 2 90 80 70 60 50 40 30 20 10 5 6 7 8 9 1 2 3 4 5 6 7 8"
+          "1 85.5 1 77.25 2 91 92 0 1 1 1 1 1 1 1 1 1 1")
+  checked=0
+  for f in TestCasesPart2/*.tips TestCasesPart3/*.tips TestCasesPart4/*.tips "$WORK/dead.tips" "$WORK/deadloop.tips"; do
+    for k in 0 1 2; do
+      printf "%s" "${inputs[$k]}" | "$TARGET" -s "$f" > "$WORK/opt.ref" 2>&1 || true
+      printf "%s" "${inputs[$k]}" | "$TARGET" -O -s "$f" > "$WORK/opt.out" 2>&1 || true
+      if ! diff -q "$WORK/opt.ref" "$WORK/opt.out" > /dev/null; then
+        printf "  %-28s OUTPUT DIFFERS with -O (input %d)\n" "$(basename "$f")" "$k"
+        diff "$WORK/opt.ref" "$WORK/opt.out" | head -20
+        exit 1
+      fi
+      checked=$(( checked + 1 ))
+    done
+  done
+  printf "  %-28s %d runs, -O -s identical to -s\n" "test programs" "$checked"
+  compare "dead-stores" "$WORK/deadloop.tips" "3000000" -O
+fi
+
+# -----------------------------------------------------------------------------
+# Strength reduction (-O): one loop per rewrite, values chosen to wrap int32
+# -----------------------------------------------------------------------------
+if want strength; then
+  echo "== strength reduction =="
+  cat > "$WORK/pow.tips" <<'EOF'
+PROGRAM POWBENCH;
+VAR I : INTEGER; N : INTEGER; X : INTEGER; Y : INTEGER; R : REAL; Q : REAL;
+BEGIN
+  READ(N); I := 0; R := 0.5;
+  WHILE I < N
+    BEGIN
+      X := I ^^ 2; Y := I ^^ 3 + I ^^ 4; Q := R ^^ 1 + R ^^ 0;
+      I := I + 1
+    END
+END
+EOF
+  cat > "$WORK/mod.tips" <<'EOF'
+PROGRAM MODBENCH;
+VAR I : INTEGER; N : INTEGER; K : INTEGER; J : INTEGER;
+BEGIN
+  READ(N); I := 0 - N;
+  WHILE I < N
+    BEGIN
+      K := I MOD 1024; J := I MOD -8;
+      I := I + 1
+    END
+END
+EOF
+  cat > "$WORK/mul.tips" <<'EOF'
+PROGRAM MULBENCH;
+VAR I : INTEGER; N : INTEGER; M : INTEGER; P : INTEGER; R : REAL;
+BEGIN
+  READ(N); I := 0; R := 1.5;
+  WHILE I < N
+    BEGIN
+      M := I * 8 + 3 * I; P := (I * 65536) * 4096; R := R * 3;
+      I := I + 1
+    END
+END
+EOF
+  for w in pow mod mul; do
+    compare "$w" "$WORK/$w.tips" "1000000" -O
+  done
+fi
+
+# -----------------------------------------------------------------------------
+# Loop-invariant code motion (-O): invariant arithmetic in the condition and
+# body, plus a guarded division that must not fault when Z = 0
+# -----------------------------------------------------------------------------
+if want licm; then
+  echo "== loop-invariant code motion =="
+  cat > "$WORK/licm.tips" <<'EOF'
+PROGRAM LICMB;
+VAR I : INTEGER; N : INTEGER; A : INTEGER; B : INTEGER; Z : INTEGER;
+    S : INTEGER; R : REAL;
+BEGIN
+  READ(N); READ(Z); A := 7; B := 13; I := 0; S := 0; R := 0.0;
+  WHILE I < N * (A + B) / (A + B)
+    BEGIN
+      S := S + (A * B + A ^^ 3) MOD 97 + I;
+      IF Z <> 0 THEN R := R + 100.0 / Z;
+      I := I + 1
+    END
+END
+EOF
+  compare "licm" "$WORK/licm.tips" "1000000 4" -O
+  compare "licm-zero-divisor" "$WORK/licm.tips" "1000000 0" -O
+fi
+
+# -----------------------------------------------------------------------------
+# Closed-form loops (-O): counting, int32-wrapping and exact REAL accumulators
+# collapse; the 0.1 sum must fall back to stepping (it rounds every trip)
+# -----------------------------------------------------------------------------
+if want idioms; then
+  echo "== closed-form loops =="
+  cat > "$WORK/idiom.tips" <<'EOF'
+PROGRAM IDIOMB;
+VAR I : INTEGER; N : INTEGER; S : INTEGER; T : INTEGER; R : REAL; C : INTEGER;
+BEGIN
+  READ(N); I := 0; S := 0; T := 0; R := 0.0;
+  WHILE I < N BEGIN S := S + 7919; T := T + I; R := R + 0.25; I := I + 1 END;
+  C := 0;
+  WHILE C < 20 BEGIN WRITE('banner line'); C := C + 1 END
+END
+EOF
+  cat > "$WORK/idiomfb.tips" <<'EOF'
+PROGRAM IDIOMFB;
+VAR I : INTEGER; N : INTEGER; R : REAL;
+BEGIN
+  READ(N); I := 0; R := 0.0;
+  WHILE I < N BEGIN R := R + 0.1; I := I + 1 END
+END
+EOF
+  compare "idiom" "$WORK/idiom.tips" "10000000" -O
+  compare "idiom-real-fallback" "$WORK/idiomfb.tips" "1000000" -O
+fi
+
+# -----------------------------------------------------------------------------
+# Parallel reductions (--threads=N): the same reduction loop at growing thread
+# counts, then a loop that WRITEs and must stay sequential
+# -----------------------------------------------------------------------------
+if want threads; then
+  echo "== parallel reductions ($(nproc) cores) =="
+  cat > "$WORK/par.tips" <<'EOF'
+PROGRAM PARB;
+VAR I : INTEGER; N : INTEGER; S : INTEGER; P : INTEGER; C : INTEGER; A : INTEGER;
+    D : INTEGER;
+BEGIN
+  READ(N); I := 0; S := 0; P := 1; C := 0; A := 7; D := 5;
+  WHILE I < N
+    BEGIN
+      S := S + (I * I MOD 1000003) * (I MOD 7 + 2);
+      I := I + 1;
+      P := (I MOD 5 + 1) * P;
+      C := C OR (I MOD 999983 = 12345);
+      A := A AND (I < N + 5);
+      D := D - I * 3
+    END
+END
+EOF
+  cat > "$WORK/parseq.tips" <<'EOF'
+PROGRAM PARSEQ;
+VAR I : INTEGER; N : INTEGER; S : INTEGER;
+BEGIN
+  READ(N); I := 0; S := 0;
+  WHILE I < N
+    BEGIN
+      S := S + I MOD 3;
+      IF I MOD 100000 = 0 THEN WRITE(S);
+      I := I + 1
+    END
+END
+EOF
+  for t in 2 4 8; do
+    compare "reduce-t$t" "$WORK/par.tips" "10000000" "--threads=$t"
+  done
+  compare "reduce-with-write" "$WORK/parseq.tips" "1000000" --threads=4
+fi
+
+# -----------------------------------------------------------------------------
+# Output coalescing (-O): banner-style runs of constant WRITEs in a loop body
+# -----------------------------------------------------------------------------
+if want output; then
+  echo "== output coalescing =="
+  {
+    echo "PROGRAM BANNERS;"
+    echo "VAR I : INTEGER; N : INTEGER; K : INTEGER;"
+    echo "BEGIN"
+    echo "  READ(N); I := 0;"
+    echo "  WHILE I < N"
+    echo "    BEGIN"
+    echo "      IF I MOD 2 = 0 THEN"
+    echo "        BEGIN"
+    for k in $(seq 12); do echo "          WRITE('even banner line $k ------------------------------');"; done
+    echo "          K := 42; WRITE(K); SENIORITIS"
+    echo "        END"
+    echo "      ELSE"
+    echo "        BEGIN"
+    for k in $(seq 12); do echo "          WRITE('odd banner line $k');"; done
+    echo "          WRITE(I)"
+    echo "        END;"
+    echo "      I := I + 1"
+    echo "    END"
+    echo "END"
+  } > "$WORK/banner.tips"
+  compare "banner" "$WORK/banner.tips" "300000" -O
+fi
+
+# -----------------------------------------------------------------------------
+# Flat AST (--flat): expression-heavy loop on the index-based layout, alone
+# and on top of -O
+# -----------------------------------------------------------------------------
+if want flat; then
+  echo "== flat AST =="
+  cat > "$WORK/flat.tips" <<'EOF'
+PROGRAM FLATB;
+VAR I : INTEGER; N : INTEGER; S : INTEGER; T : INTEGER; R : REAL;
+BEGIN
+  READ(N); I := 0; S := 0; T := 1; R := 0.0;
+  WHILE I < N
+    BEGIN
+      S := (S + I * 3 - (I MOD 7)) MOD 1000003;
+      IF (I MOD 3 = 0) AND (S > T) THEN T := T + 1 ELSE T := T - 1;
+      R := R + (I - T) / 4.0;
+      I := I + 1
+    END
+END
+EOF
+  compare "flat" "$WORK/flat.tips" "2000000" --flat
+  compare "flat-O" "$WORK/flat.tips" "2000000" -O --flat
+fi
+
+# -----------------------------------------------------------------------------
+# Value representation: BinaryExpr throughput on prebuilt trees (exprbench),
+# pointer tree vs. flat records
+# -----------------------------------------------------------------------------
+if want values; then
+  echo "== BinaryExpr microbenchmark =="
+  make -s exprbench
+  ./exprbench 4000000 | sed 's/^/  /'
+fi
+
+# -----------------------------------------------------------------------------
+# Record batches (--records=FILE): one process per input line vs. one lockstep
+# run over the whole file (banners are stripped before comparing), then the
+# lanes vs. sequential runs in the same process
+# -----------------------------------------------------------------------------
+if want records; then
+  echo "== record batches =="
+  awk 'BEGIN { srand(42); for (i = 0; i < 2000; ++i)
+         printf "%d %d %d\n", 1 + int(rand() * 4000), 1 + int(rand() * 4000), 1 + int(rand() * 300) }' \
+    > "$WORK/img.rec"
+  payload() { grep -v $'\e' | grep -v '^$' || true; }
+  t0=$(date +%s%N)
+  while IFS= read -r line; do
+    printf "%s" "$line" | "$TARGET" -s TestCasesPart3/imageScaler.tips 2>&1 | payload
+  done < "$WORK/img.rec" > "$WORK/rec.ref"
+  t1=$(date +%s%N)
+  "$TARGET" -s --records="$WORK/img.rec" TestCasesPart3/imageScaler.tips 2>&1 | payload > "$WORK/rec.opt"
+  t2=$(date +%s%N)
+  tr=$(awk -v ns=$(( t1 - t0 )) 'BEGIN { printf "%.3f", ns / 1e9 }')
+  to=$(awk -v ns=$(( t2 - t1 )) 'BEGIN { printf "%.3f", ns / 1e9 }')
+  if diff -q "$WORK/rec.ref" "$WORK/rec.opt" > /dev/null; then
+    printf "  %-28s per-line %7ss   --records %7ss   identical\n" "imageScaler x2000" "$tr" "$to"
+  else
+    printf "  %-28s OUTPUT DIFFERS with --records\n" "imageScaler x2000"
+    diff "$WORK/rec.ref" "$WORK/rec.opt" | head -20
+    exit 1
+  fi
+
+  # Lanes against the same runs one after another in one process (recordbench),
+  # so neither side pays process start-up: 1, 16 and 64 runs of a counting loop
+  # (1 is one short batch, which runs per lane), the same with trip counts that
+  # differ per record (lanes drop out of the WHILE one by one), and imageScaler
+  make -s recordbench
+  cat > "$WORK/acc.tips" <<'EOF'
+PROGRAM ACC;
+VAR A : INTEGER; I : INTEGER; S : INTEGER;
+BEGIN
+  READ(A); I := 0; S := 0;
+  WHILE I < A * 20000
+    BEGIN
+      S := S + A * I;
+      I := I + 1
+    END;
+  WRITE(S)
+END
+EOF
+  for n in 1 16 64; do
+    awk -v n="$n" 'BEGIN { for (i = 0; i < n; ++i) print 15 }' > "$WORK/acc$n.rec"
+    printf "  %-28s " "accumulate x$n"
+    ./recordbench "$WORK/acc.tips" "$WORK/acc$n.rec" -s 3
+  done
+  seq 1 16 > "$WORK/ramp.rec"
+  printf "  %-28s " "accumulate trips 1..16"
+  ./recordbench "$WORK/acc.tips" "$WORK/ramp.rec" -s 3
+  printf "  %-28s " "imageScaler x2000"
+  ./recordbench TestCasesPart3/imageScaler.tips "$WORK/img.rec" -s 3
+
+  # Sharding: a loop-heavy program over 100k records at 1 .. all cores (and at
+  # least 2, so the sharded path runs even on one core)
+  cat > "$WORK/shard.tips" <<'EOF'
+PROGRAM SHARD;
+VAR A : INTEGER; B : INTEGER; I : INTEGER; S : INTEGER; R : REAL;
+BEGIN
+  READ(A); READ(B); I := 0; S := 0; R := 0.0;
+  WHILE I < 200
+    BEGIN
+      S := S + (A * I + B) MOD 97;
+      R := R + A / (I + 1.0);
+      I := I + 1
+    END;
+  WRITE(S); WRITE(R)
+END
+EOF
+  awk 'BEGIN { srand(7); for (i = 0; i < 100000; ++i)
+         printf "%d %d\n", int(rand() * 1000), int(rand() * 1000) }' > "$WORK/shard.rec"
+  cores=$(nproc)
+  counts="1"
+  for (( t = 2; t < cores; t *= 2 )); do counts="$counts $t"; done
+  counts="$counts $(( cores > 1 ? cores : 2 ))"
+  for t in $counts; do
+    t0=$(date +%s%N)
+    "$TARGET" --threads="$t" --records="$WORK/shard.rec" "$WORK/shard.tips" > "$WORK/shard.t$t"
+    t1=$(date +%s%N)
+    secs=$(awk -v ns=$(( t1 - t0 )) 'BEGIN { printf "%.3f", ns / 1e9 }')
+    if [[ "$t" == 1 ]]; then
+      base="$secs"
+      printf "  %-28s %7ss\n" "shard x100000 threads=1" "$secs"
+    elif diff -q "$WORK/shard.t1" "$WORK/shard.t$t" > /dev/null; then
+      printf "  %-28s %7ss   speedup %5.2fx   identical\n" "shard x100000 threads=$t" "$secs" \
+        "$(awk -v a="$base" -v b="$secs" 'BEGIN { print a / b }')"
+    else
+      printf "  %-28s OUTPUT DIFFERS from threads=1\n" "shard x100000 threads=$t"
+      exit 1
+    fi
+  done
+fi
+
+# -----------------------------------------------------------------------------
+# Declaration lookup: programs declaring tens of thousands of VARs (in shuffled
+# order) and then using each one four times; mostly parse time. Set
+# BASELINE=path/to/older/parse to time the same programs on another build.
+# -----------------------------------------------------------------------------
+if want symbols; then
+  echo "== many VARs =="
+  for n in 20000 60000; do
+    awk -v n="$n" 'BEGIN {
+      srand(n)
+      for (i = 0; i < n; ++i) { name[i] = sprintf("V%c%05d", 65 + i % 26, i); ord[i] = i }
+      for (i = n - 1; i > 0; --i) { j = int(rand() * (i + 1)); t = ord[i]; ord[i] = ord[j]; ord[j] = t }
+      print "PROGRAM MANYVARS;"; print "VAR"
+      for (i = 0; i < n; ++i) printf "  %s : INTEGER;\n", name[ord[i]]
+      print "BEGIN"; printf "  %s := 1", name[0]
+      for (i = 1; i < n; ++i) printf ";\n  %s := %s + 1; WRITE(%s)", name[i], name[i - 1], name[i]
+      print ""; print "END" }' > "$WORK/vars.tips"
+    for bin in "$TARGET" ${BASELINE:+"$BASELINE"}; do
+      read -r secs kb < <(run_peak "$WORK/vars.out" "$bin" "$WORK/vars.tips")
+      label="$n VARs"; [[ "$bin" != "$TARGET" ]] && label="$label (baseline)"
+      if [[ "$(grep -v $'\e' "$WORK/vars.out" | grep -v '^$' | tail -1)" == "$n" ]]; then
+        printf "  %-28s %7ss   peak RSS %7d kB   ok\n" "$label" "$secs" "$kb"
+      else
+        printf "  %-28s WRONG OUTPUT\n" "$label"
+        tail -5 "$WORK/vars.out"
+        exit 1
+      fi
+    done
+  done
+fi
+
+# -----------------------------------------------------------------------------
+# Keyword skins: token dump (-t) of one keyword-dense program spelled in each
+# built-in skin; the dumps must match and should take the same time.
+# -----------------------------------------------------------------------------
+if want skins && flex_built "keyword skins"; then
+  echo "== keyword skins =="
+  "$TARGET" --list-skins | sed 's/^[* ] //' | while read -r skin spellings; do
+    awk -v map="$spellings" 'BEGIN {
+      split("PROGRAM BEGIN END WRITE READ IF THEN ELSE WHILE SENIORITIS NOT AND OR VAR INTEGER REAL MOD", kw, " ")
+      for (i in kw) k[kw[i]] = kw[i]
+      n = split(map, pairs, " ")
+      for (i = 1; i <= n; ++i) if (split(pairs[i], kv, "=") == 2) k[kv[1]] = kv[2]
+      printf "%s SKINS;\n%s X : %s; Y : %s;\n%s\n", k["PROGRAM"], k["VAR"], k["INTEGER"], k["REAL"], k["BEGIN"]
+      for (i = 0; i < 40000; ++i)
+        printf "  %s (X > %d) %s (%s Y < 1.5) %s X := X %s 7 %s %s %s(X); %s(Y) %s;\n",
+          k["IF"], i, k["AND"], k["NOT"], k["THEN"], k["MOD"], k["ELSE"], k["BEGIN"], k["WRITE"], k["READ"], k["END"]
+      printf "  %s (X < 0) %s (Y > 0) %s %s %s\n%s\n", k["WHILE"], k["OR"], k["BEGIN"], k["SENIORITIS"], k["END"], k["END"] }' \
+      > "$WORK/skin.$skin.tips"
+    "$TARGET" -t --skin="$skin" "$WORK/skin.$skin.tips" > /dev/null  # warm the page cache
+    t0=$(date +%s%N)
+    "$TARGET" -t --skin="$skin" "$WORK/skin.$skin.tips" > "$WORK/skin.$skin.tok"
+    t1=$(date +%s%N)
+    secs=$(awk -v ns=$(( t1 - t0 )) 'BEGIN { printf "%.3f", ns / 1e9 }')
+    if [[ ! -f "$WORK/skin.ref.tok" ]]; then
+      cp "$WORK/skin.$skin.tok" "$WORK/skin.ref.tok"
+      printf "  %-28s -t %7ss   %s tokens\n" "$skin" "$secs" "$(grep -c . "$WORK/skin.ref.tok")"
+    elif diff -q "$WORK/skin.ref.tok" "$WORK/skin.$skin.tok" > /dev/null; then
+      printf "  %-28s -t %7ss   same tokens\n" "$skin" "$secs"
+    else
+      printf "  %-28s TOKENS DIFFER from %s\n" "$skin" "default"
+      exit 1
+    fi
+  done
+fi
+
+# -----------------------------------------------------------------------------
+# Scanners: -t with flex and with --scanner=simd must agree on every test
+# source (tokens, line numbers, errors, exit code); then both scan a large,
+# mostly whitespace-and-comment source
+# -----------------------------------------------------------------------------
+if want scanner && flex_built "scanners"; then
+  echo "== scanners =="
+  srcs=0
+  for f in TestCasesPart*/*.tips TestCasesPart1/*.in; do
+    rf=0; rs=0
+    "$TARGET" -t "$f" > "$WORK/scan.flex" 2>&1 || rf=$?
+    "$TARGET" -t --scanner=simd "$f" > "$WORK/scan.simd" 2>&1 || rs=$?
+    if [[ "$rf" != "$rs" ]] || ! diff -q "$WORK/scan.flex" "$WORK/scan.simd" > /dev/null; then
+      printf "  %-28s TOKENS DIFFER with --scanner=simd\n" "$f"
+      diff "$WORK/scan.flex" "$WORK/scan.simd" | head -20
+      exit 1
+    fi
+    srcs=$(( srcs + 1 ))
+  done
+  printf "  %-28s %d sources   identical\n" "token streams" "$srcs"
+
+  awk 'BEGIN {
+    print "PROGRAM SCANB;"; print "VAR I : INTEGER; S : INTEGER;"; print "BEGIN"
+    for (i = 0; i < 60000; ++i) {
+      printf "                                ## step %d: add the next term to the running sum S\n", i
+      printf "                                ##   (comment lines like these dominate generated sources)\n"
+      printf "                                S      :=      S + %d   ;\n\n", i
+    }
+    print "  WRITE(S)"; print "END" }' > "$WORK/scan.tips"
+  mb=$(awk -v b="$(wc -c < "$WORK/scan.tips")" 'BEGIN { printf "%.1f", b / 1048576 }')
+  for scanner in flex simd; do
+    "$TARGET" -t --scanner="$scanner" "$WORK/scan.tips" > /dev/null  # warm the page cache
+    t0=$(date +%s%N)
+    "$TARGET" -t --scanner="$scanner" "$WORK/scan.tips" > "$WORK/scan.$scanner"
+    t1=$(date +%s%N)
+    secs=$(awk -v ns=$(( t1 - t0 )) 'BEGIN { printf "%.3f", ns / 1e9 }')
+    printf "  %-28s -t %7ss   %6.1f MB/s\n" "$mb MB, $scanner" "$secs" \
+      "$(awk -v mb="$mb" -v s="$secs" 'BEGIN { print mb / s }')"
+  done
+  if ! diff -q "$WORK/scan.flex" "$WORK/scan.simd" > /dev/null; then
+    echo "  TOKENS DIFFER with --scanner=simd"
+    exit 1
+  fi
+fi
+
+# -----------------------------------------------------------------------------
+# String pool: 60k WRITE('...') statements run 20 times, with 16 distinct
+# literals and with every literal distinct; output is checked against awk.
+# Set BASELINE=path/to/older/parse to time the same programs on another build.
+# -----------------------------------------------------------------------------
+if want strings; then
+  echo "== WRITE string literals =="
+  for kind in dup unique; do
+    awk -v kind="$kind" 'BEGIN {
+      print "PROGRAM STRS;"; print "VAR I : INTEGER;"; print "BEGIN"
+      print "  I := 0;"; print "  WHILE I < 20"; print "    BEGIN"
+      for (i = 0; i < 60000; ++i) {
+        id = (kind == "dup") ? i % 16 : i
+        printf "      WRITE(%sline number %06d of the string pool benchmark%s);\n", "\047", id, "\047"
+      }
+      print "      I := I + 1"; print "    END"; print "END" }' > "$WORK/str.$kind.tips"
+    awk -v kind="$kind" 'BEGIN {
+      for (r = 0; r < 20; ++r) for (i = 0; i < 60000; ++i) {
+        id = (kind == "dup") ? i % 16 : i
+        printf "\047line number %06d of the string pool benchmark\047\n", id
+      } }' > "$WORK/str.$kind.want"
+    for bin in "$TARGET" ${BASELINE:+"$BASELINE"}; do
+      read -r secs kb < <(run_peak "$WORK/str.out" "$bin" "$WORK/str.$kind.tips")
+      grep -v $'\e' "$WORK/str.out" | grep -v '^$' > "$WORK/str.got" || true
+      label="$kind x60000"; [[ "$bin" != "$TARGET" ]] && label="$label (baseline)"
+      if diff -q "$WORK/str.$kind.want" "$WORK/str.got" > /dev/null; then
+        printf "  %-28s %7ss   peak RSS %7d kB   identical\n" "$label" "$secs" "$kb"
+      else
+        printf "  %-28s OUTPUT DIFFERS from expected\n" "$label"
+        diff "$WORK/str.$kind.want" "$WORK/str.got" | head -20
+        exit 1
+      fi
+    done
+  done
+fi
+
+# -----------------------------------------------------------------------------
+# Pipelined scanning: a 17 MB program whose statements sit under an IF that
+# is never taken, so the run is almost all scanning and parsing, with each
+# scanner directly and with --pipeline. A lexical error near the end must
+# be reported on the same line either way.
+# -----------------------------------------------------------------------------
+if want pipeline; then
+  echo "== scanner thread (--pipeline) =="
+  awk 'BEGIN {
+    print "PROGRAM PIPEB;"; print "VAR S : INTEGER; T : INTEGER;"; print "BEGIN"
+    print "  S := 0; T := 1;"; print "  IF T > 1 THEN"; print "    BEGIN"
+    for (i = 0; i < 200000; ++i) {
+      printf "      ## term %d\n", i
+      printf "      IF T > %d THEN S := S + (T * %d - %d) MOD 7 ELSE T := T + 1;\n", i % 50, i, i % 13
+    }
+    print "      S := S + 1"; print "    END;"; print "  WRITE(S)"; print "END" }' > "$WORK/pipe.tips"
+  mb=$(awk -v b="$(wc -c < "$WORK/pipe.tips")" 'BEGIN { printf "%.1f", b / 1048576 }')
+  ref=""
+  for scanner in flex simd; do
+    for mode in direct pipeline; do
+      flags=(--scanner="$scanner" -s)
+      [[ "$mode" == pipeline ]] && flags+=(--pipeline)
+      secs=$(run_timed "$WORK/pipe.out" "" "$TARGET" "${flags[@]}" "$WORK/pipe.tips")
+      [[ -z "$ref" ]] && { ref="$WORK/pipe.ref"; cp "$WORK/pipe.out" "$ref"; }
+      if diff -q "$ref" "$WORK/pipe.out" > /dev/null; then
+        printf "  %-28s %7ss   identical\n" "$mb MB, $scanner, $mode" "$secs"
+      else
+        printf "  %-28s OUTPUT DIFFERS\n" "$mb MB, $scanner, $mode"
+        diff "$ref" "$WORK/pipe.out" | head -20
+        exit 1
+      fi
+    done
+  done
+
+  head -n -2 "$WORK/pipe.tips" > "$WORK/pipe.bad.tips"
+  printf '  WRITE(S) @\nEND\n' >> "$WORK/pipe.bad.tips"
+  "$TARGET" "$WORK/pipe.bad.tips" > "$WORK/pipe.err.direct" 2>&1 || true
+  "$TARGET" --pipeline "$WORK/pipe.bad.tips" > "$WORK/pipe.err.pipeline" 2>&1 || true
+  if diff -q "$WORK/pipe.err.direct" "$WORK/pipe.err.pipeline" > /dev/null; then
+    printf "  %-28s %s\n" "lexical error" "$(grep -o 'line [0-9]*' "$WORK/pipe.err.pipeline") in both modes"
+  else
+    echo "  lexical error reported differently with --pipeline"
+    diff "$WORK/pipe.err.direct" "$WORK/pipe.err.pipeline"
+    exit 1
+  fi
+fi
+
+# -----------------------------------------------------------------------------
+# AST printer: one assignment whose right side is a 10000-term chain (a tree
+# 10000 levels deep) plus 163000 short assignments, about a million nodes and
+# 600 MB of -p output. The time without -p is the parse and run underneath;
+# -p and --flat -p must print the same bytes. Set BASELINE=path/to/older/parse
+# to time and check its -p as well.
+# -----------------------------------------------------------------------------
+if want printer; then
+  echo "== -p tree printer =="
+  awk 'BEGIN {
+    print "PROGRAM DEEP;"; print "VAR S : INTEGER; T : INTEGER;"; print "BEGIN"; print "  S := 0; T := 1;"
+    printf "  T := T"; for (i = 1; i < 10000; ++i) printf " + T"; print ";"
+    for (i = 0; i < 163000; ++i) printf "  S := (S + T) MOD %d;\n", i % 9 + 2
+    print "  WRITE(S)"; print "END" }' > "$WORK/deep.tips"
+  secs=$(run_timed /dev/null "" "$TARGET" "$WORK/deep.tips")
+  printf "  %-28s %7ss\n" "depth 10k, no -p" "$secs"
+  want_sum=$("$TARGET" -p "$WORK/deep.tips" | md5sum)
+  for run in "$TARGET -p" "$TARGET -p --flat" ${BASELINE:+"$BASELINE -p"}; do
+    read -r -a cmd <<< "$run"
+    secs=$(run_timed /dev/null "" "${cmd[@]}" "$WORK/deep.tips")
+    label="depth 10k, ${run#* }"; [[ "${cmd[0]}" != "$TARGET" ]] && label="$label (baseline)"
+    if [[ "$("${cmd[@]}" "$WORK/deep.tips" | md5sum)" == "$want_sum" ]]; then
+      printf "  %-28s %7ss   identical\n" "$label" "$secs"
+    else
+      printf "  %-28s OUTPUT DIFFERS\n" "$label"
+      exit 1
+    fi
+  done
+fi
+
+# -----------------------------------------------------------------------------
+# Machine-readable dumps: the text -t and -p against --dump-tokens=bin and
+# --dump-ast=json|bin on a 100000-statement program (time and size), then the
+# program run from source against the same run from its binary AST
+# (--load-ast), whose output and symbol table must be identical.
+# -----------------------------------------------------------------------------
+if want dumps; then
+  echo "== AST and token dumps =="
+  awk 'BEGIN {
+    print "PROGRAM DUMPB;"; print "VAR S : INTEGER; T : INTEGER; X : REAL;"; print "BEGIN"
+    print "  S := 0; T := 1; X := 0.5;"
+    for (i = 0; i < 100000; ++i) {
+      if (i % 4 == 0) printf "  IF T > %d THEN S := S + (T * %d - %d) MOD 7 ELSE T := T + 1;\n", i % 50, i, i % 13
+      else if (i % 4 == 1) printf "  X := X * 0.5 + %d.25;\n", i % 100
+      else if (i % 4 == 2) printf "  WRITE(%sline %d%s);\n", "\047", i % 1000, "\047"
+      else printf "  S := S MOD 1000 + ++T;\n"
+    }
+    print "  WRITE(S)"; print "END" }' > "$WORK/dump.tips"
+  size_of() { awk -v b="$(wc -c < "$1")" 'BEGIN { printf "%.1f MB", b / 1048576 }'; }
+  printf "  %-28s %17s\n" "source" "$(size_of "$WORK/dump.tips")"
+  for mode in "-t" "--dump-tokens=bin" "-p" "--dump-ast=json" "--dump-ast=bin"; do
+    secs=$(run_timed "$WORK/dump.out" "" "$TARGET" "$mode" "$WORK/dump.tips")
+    printf "  %-28s %7ss %9s\n" "$mode" "$secs" "$(size_of "$WORK/dump.out")"
+    [[ "$mode" == "--dump-ast=bin" ]] && cp "$WORK/dump.out" "$WORK/dump.bin"
+  done
+  secs=$(run_timed "$WORK/dump.src" "" "$TARGET" -s "$WORK/dump.tips")
+  printf "  %-28s %7ss\n" "run from source" "$secs"
+  secs=$(run_timed "$WORK/dump.ast" "" "$TARGET" -s --load-ast "$WORK/dump.bin")
+  if diff -q "$WORK/dump.src" "$WORK/dump.ast" > /dev/null; then
+    printf "  %-28s %7ss   identical\n" "run from --load-ast" "$secs"
+  else
+    echo "  run from --load-ast: OUTPUT DIFFERS"
+    diff "$WORK/dump.src" "$WORK/dump.ast" | head -20
+    exit 1
+  fi
+fi
+
+# -----------------------------------------------------------------------------
+# Incremental reparsing: random one-line edits to a ~100k-line program of
+# nested WHILE/IF/BEGIN blocks through IncrementalParser (reparsebench), each
+# timed against a full scan + parse; every 50th edit the tree is compared
+# with a full parse of the edited source.
+# -----------------------------------------------------------------------------
+if want reparse; then
+  echo "== incremental reparse =="
+  make -s reparsebench
+  awk 'BEGIN {
+    print "PROGRAM EDITS;"; print "VAR S : INTEGER; T : INTEGER; X : REAL;"; print "BEGIN"
+    print "  S := 0; T := 1; X := 0.5;"
+    for (b = 0; b < 5600; ++b) {
+      printf "  WHILE T < %d BEGIN\n", b % 7
+      for (k = 0; k < 6; ++k) printf "    S := (S + T * %d) MOD %d;\n", k + b % 10, k + 2
+      printf "    IF S > %d THEN\n      X := X * 0.5 + %d.25\n    ELSE BEGIN\n", b % 50, b % 9
+      for (k = 0; k < 4; ++k) printf "      T := T + %d;\n", k + 1
+      print "      WRITE(S)"; print "    END;"
+      print "    T := T + 1"; print "  END;"
+    }
+    print "  WRITE(S)"; print "END" }' > "$WORK/edits.tips"
+  ./reparsebench "$WORK/edits.tips" 2000 50 | sed 's/^/  /'
+fi
+
+# -----------------------------------------------------------------------------
+# Lazy parsing: a program that WRITEs once and then dispatches on a mode to
+# one of 4000 large BEGIN ... END handlers, so nearly all of its ~200k lines
+# never run. Time to the first line of output and total time, parsing
+# everything up front against --lazy (bodies parsed when first entered), with
+# each scanner; each run's output and symbol table must match the eager run's.
+# -----------------------------------------------------------------------------
+if want lazy; then
+  echo "== lazy parsing =="
+  awk 'BEGIN {
+    print "PROGRAM DISPATCH;"; print "VAR MODE : INTEGER; S : INTEGER; T : INTEGER; X : REAL;"; print "BEGIN"
+    print "  WRITE(\047first\047);"; print "  MODE := 17; S := 0; T := 1; X := 0.5;"
+    for (h = 0; h < 4000; ++h) {
+      printf "  IF MODE = %d THEN\n  BEGIN\n", h
+      printf "    WHILE T < %d\n    BEGIN\n", 50 + h % 7
+      for (k = 0; k < 20; ++k) printf "      S := (S + T * %d) MOD %d;\n", k + h % 10, k + 2
+      printf "      IF S > %d THEN BEGIN X := X * 0.5 + %d.25; T := T + 1 END\n", h % 50, h % 9
+      print "      ELSE T := T + 2"; print "    END;"
+      for (k = 0; k < 20; ++k) printf "    WRITE(%sstep %d%s);\n", "\047", k, "\047"
+      print "    WRITE(S)"; print "  END;"
+    }
+    print "  WRITE(\047last\047)"; print "END" }' > "$WORK/lazy.tips"
+  # first_output OUT FLAGS... : seconds until the program's first WRITE
+  # reaches the pipe (line-buffered with stdbuf), then seconds to exit; the
+  # whole output goes to OUT.
+  first_output() {
+    local out="$1"; shift
+    local t0 t1 t2
+    t0=$(date +%s%N)
+    stdbuf -oL "$TARGET" -s "$@" "$WORK/lazy.tips" < /dev/null 2>&1 | {
+      while IFS= read -r line; do
+        echo "$line"
+        [[ "$line" == first ]] && break
+      done
+      date +%s%N > "$WORK/lazy.t1"
+      cat
+    } > "$out"
+    t2=$(date +%s%N)
+    t1=$(cat "$WORK/lazy.t1")
+    awk -v a=$(( t1 - t0 )) -v b=$(( t2 - t0 )) 'BEGIN { printf "%.3fs first output, %.3fs total", a / 1e9, b / 1e9 }'
+  }
+  printf "  %-28s %s\n" "eager" "$(first_output "$WORK/lazy.ref")"
+  grep -q "executed successfully" "$WORK/lazy.ref" || { echo "  REFERENCE RUN FAILED"; exit 1; }
+  for flags in "--lazy" "--scanner=simd" "--scanner=simd --lazy"; do
+    # shellcheck disable=SC2086
+    result=$(first_output "$WORK/lazy.out" $flags)
+    if diff -q "$WORK/lazy.ref" "$WORK/lazy.out" > /dev/null; then
+      printf "  %-28s %s   identical\n" "$flags" "$result"
+    else
+      echo "  $flags: OUTPUT DIFFERS"
+      diff "$WORK/lazy.ref" "$WORK/lazy.out" | head -20
+      exit 1
+    fi
+  done
+fi
+
+# -----------------------------------------------------------------------------
+# Bundles: each test program (and a 100000-statement one) as a --bundle
+# executable against `parse file.tips`, 50 runs each with the same input;
+# the time is per run, start to exit, and the outputs must be identical.
+# -----------------------------------------------------------------------------
+if want bundle; then
+  echo "== --bundle startup =="
+  awk 'BEGIN {
+    print "PROGRAM BIGSTART;"; print "VAR S : INTEGER; T : INTEGER;"; print "BEGIN"; print "  S := 0; T := 1;"
+    for (i = 0; i < 100000; ++i) printf "  IF T > %d THEN S := S + (T * %d) MOD 7 ELSE T := T + 1;\n", i % 50, i
+    print "  WRITE(S)"; print "END" }' > "$WORK/bigstart.tips"
+  input="3 4 2 1 5 6 7 8 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20"
+  # per_run N CMD... : mean seconds per run over N runs of CMD with $input.
+  per_run() {
+    local n="$1"; shift
+    local t0 t1 k
+    t0=$(date +%s%N)
+    for (( k = 0; k < n; ++k )); do printf "%s" "$input" | "$@" > /dev/null 2>&1 || true; done
+    t1=$(date +%s%N)
+    awk -v ns=$(( t1 - t0 )) -v n="$n" 'BEGIN { printf "%.2f", ns / n / 1e6 }'
+  }
+  for f in TestCasesPart2/*.tips TestCasesPart3/*.tips TestCasesPart4/*.tips "$WORK/bigstart.tips"; do
+    name=$(basename "$f" .tips)
+    "$TARGET" --bundle "$WORK/$name.bundle" "$f" > /dev/null 2>&1 || continue  # a syntax-error test
+    a=$(printf "%s" "$input" | "$TARGET" "$f" 2>&1 || true)
+    b=$(printf "%s" "$input" | "$WORK/$name.bundle" 2>&1 || true)
+    if [[ "$a" != "$b" ]]; then
+      printf "  %-28s OUTPUT DIFFERS\n" "$name"
+      diff <(echo "$a") <(echo "$b") | head -20
+      exit 1
+    fi
+    printf "  %-28s parse %7s ms   bundle %7s ms   identical\n" "$name" \
+      "$(per_run 50 "$TARGET" "$f")" "$(per_run 50 "$WORK/$name.bundle")"
+  done
+fi
+
+# -----------------------------------------------------------------------------
+# tipsd: requests per second and latency of runs served by the daemon
+# (tipsload: by hash and sending the source each time, 1 and 4 clients)
+# against one `parse` process per run, on test programs; tipsc output must
+# match parse's between the interpretation banners.
+# -----------------------------------------------------------------------------
+if want daemon; then
+  echo "== tipsd daemon =="
+  make -s tipsd tipsc tipsload
+  sock="$WORK/tipsd.sock"
+  ./tipsd --socket="$sock" --workers=4 2> /dev/null &
+  daemon=$!
+  for (( k = 0; k < 100; ++k )); do [[ -S "$sock" ]] && break; sleep 0.05; done
+  printf "3 4 2 1 5 6 7 8 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20" > "$WORK/daemon.in"
+  for f in TestCasesPart4/euclid.tips TestCasesPart4/brainrot.tips TestCasesPart3/imageScaler.tips; do
+    name=$(basename "$f" .tips)
+    a=$("$TARGET" -s "$f" < "$WORK/daemon.in" 2>&1 | grep -v "=====" | grep -v '^$' || true)
+    b=$(./tipsc --socket="$sock" -s "$f" < "$WORK/daemon.in" 2>&1 | grep -v '^$' || true)
+    if [[ "$a" != "$b" ]]; then
+      echo "  $name: tipsc OUTPUT DIFFERS from parse"
+      diff <(echo "$a") <(echo "$b") | head -20
+      kill "$daemon"; exit 1
+    fi
+    t0=$(date +%s%N)
+    for (( k = 0; k < 200; ++k )); do "$TARGET" "$f" < "$WORK/daemon.in" > /dev/null 2>&1 || true; done
+    t1=$(date +%s%N)
+    awk -v ns=$(( t1 - t0 )) -v n="$name" 'BEGIN { printf "  %-12s parse per run      %6.0f req/s, %.0f us each\n", n, 200 / (ns / 1e9), ns / 200 / 1e3 }'
+    for run in "--clients=1" "--clients=4" "--clients=4 --source"; do
+      read -r -a opts <<< "$run"
+      ./tipsload --socket="$sock" --requests=20000 "${opts[@]}" "$f" "$WORK/daemon.in" | sed "s/^/  $(printf '%-12s' "$name") /"
+    done
+  done
+
+  # Clients that hang up on a run that never writes: every worker gets one,
+  # then a fresh request must still be served
+  printf "PROGRAM SPIN;\nVAR I : INTEGER;\nBEGIN\n  I := 0;\n  WHILE 1 = 1\n    I := I + 1\nEND\n" > "$WORK/spin.tips"
+  spinners=()
+  for (( k = 0; k < 4; ++k )); do
+    ./tipsc --socket="$sock" "$WORK/spin.tips" < /dev/null > /dev/null 2>&1 &
+    spinners+=($!)
+  done
+  sleep 0.5
+  kill "${spinners[@]}"
+  wait "${spinners[@]}" 2> /dev/null || true
+  t0=$(date +%s%N)
+  if ! timeout 10 ./tipsc --socket="$sock" TestCasesPart4/euclid.tips < "$WORK/daemon.in" > /dev/null 2>&1; then
+    echo "  hung-up clients still hold the workers"
+    kill "$daemon"; exit 1
+  fi
+  t1=$(date +%s%N)
+  awk -v ns=$(( t1 - t0 )) 'BEGIN { printf "  %-12s served %.0f ms after 4 silent runs lost their clients\n", "hang-up", ns / 1e6 }'
+  kill "$daemon"
+  wait "$daemon" || true
+fi
+
+# -----------------------------------------------------------------------------
+# Suspended sessions: 10k runs of each READ program on one SessionLoop, all
+# waiting at their first READ, then fed their input a token per round. Prints
+# resident memory per waiting session and the cost of a resume; every
+# session's output must equal a plain run's.
+# -----------------------------------------------------------------------------
+if want sessions; then
+  echo "== suspended sessions =="
+  make -s sessionbench
+  printf "3 4 2 1 5 6 7 8 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20" > "$WORK/sessions.in"
+  for f in TestCasesPart4/euclid.tips TestCasesPart4/gradeMe.tips TestCasesPart3/imageScaler.tips; do
+    echo "  $(basename "$f" .tips)"
+    ./sessionbench "$f" "$WORK/sessions.in" 10000 | sed 's/^/    /'
+  done
+fi
+
+# -----------------------------------------------------------------------------
+# Result cache: each test program on two inputs that differ only past what
+# most of them READ, plus a long-running loop. Per input: a run without the
+# cache, the first run with it (stores) and a repeat (replays); stdout,
+# stderr and exit code of both cached runs must equal the plain run's.
+# -----------------------------------------------------------------------------
+if want resultcache; then
+  echo "== --result-cache =="
+  cat > "$WORK/spin.tips" <<'TIPS'
+PROGRAM SPIN;
+VAR N : INTEGER; I : INTEGER; S : INTEGER;
+BEGIN
+  WRITE('How many?');
+  READ(N);
+  I := 0; S := 0;
+  WHILE I < N
+  BEGIN
+    S := (S + I * 7) MOD 1000003;
+    I := I + 1
+  END;
+  WRITE(S)
+END
+TIPS
+  cache="$WORK/results"
+  # timed_run TAG INPUT ARGS... : runs parse, keeping stdout, stderr and status
+  timed_run() {
+    local tag="$1" input="$2"; shift 2
+    local t0 t1 rc=0
+    t0=$(date +%s%N)
+    printf "%s" "$input" | "$TARGET" "$@" > "$WORK/rc.$tag.out" 2> "$WORK/rc.$tag.err" || rc=$?
+    t1=$(date +%s%N)
+    echo "$rc" >> "$WORK/rc.$tag.err"
+    awk -v ns=$(( t1 - t0 )) 'BEGIN { printf "%.1f", ns / 1e6 }'
+  }
+  for f in TestCasesPart3/*.tips TestCasesPart4/*.tips "$WORK/spin.tips"; do
+    name=$(basename "$f" .tips)
+    for input in "20000000 4 2 1 5 6 7 8 2 3 4 5 6 7 8 9 10" "20000000 4 2 1 5 6 7 8 2 3 4 5 6 7 8 9 11"; do
+      tp=$(timed_run plain "$input" -s "$f")
+      tc=$(timed_run cold "$input" -s --result-cache="$cache" "$f")
+      tw=$(timed_run warm "$input" -s --result-cache="$cache" "$f")
+      for tag in cold warm; do
+        if ! cmp -s "$WORK/rc.plain.out" "$WORK/rc.$tag.out" || ! cmp -s "$WORK/rc.plain.err" "$WORK/rc.$tag.err"; then
+          printf "  %-14s %s run DIFFERS from the plain run
+" "$name" "$tag"
+          diff "$WORK/rc.plain.out" "$WORK/rc.$tag.out" | head -10
+          exit 1
+        fi
+      done
+      printf "  %-14s plain %8s ms   store %8s ms   replay %6s ms   identical
+" "$name" "$tp" "$tc" "$tw"
+    done
+  done
+fi
+
+if want limits; then
+  echo "== --max-steps / --timeout / --max-output =="
+  cat > "$WORK/loop.tips" <<'TIPS'
+PROGRAM LOOP;
+VAR N : INTEGER; I : INTEGER; S : INTEGER;
+BEGIN
+  READ(N);
+  I := 0; S := 0;
+  WHILE I < N
+  BEGIN
+    S := (S + I * 7) MOD 1000003;
+    I := I + 1
+  END;
+  WRITE(S)
+END
+TIPS
+  cat > "$WORK/chatty.tips" <<'TIPS'
+PROGRAM CHATTY;
+VAR I : INTEGER;
+BEGIN
+  I := 0;
+  WHILE 1 > 0
+  BEGIN
+    WRITE(I);
+    I := I + 1
+  END
+END
+TIPS
+  # A limit nobody reaches must not change the output; time what checking costs.
+  for opt in "" "--flat" "-O"; do
+    t0=$(run_timed "$WORK/lim.ref" "20000000" "$TARGET" -s $opt "$WORK/loop.tips")
+    t1=$(run_timed "$WORK/lim.out" "20000000" "$TARGET" -s $opt --max-steps=1000000000000 --timeout=1000 \
+           --max-output=1000000 "$WORK/loop.tips")
+    if ! cmp -s "$WORK/lim.ref" "$WORK/lim.out"; then
+      echo "  loop ${opt:-plain}: output DIFFERS under limits"
+      exit 1
+    fi
+    printf "  loop 20M trips %-7s no limits %6ss   with limits %6ss   identical\n" "${opt:-plain}" "$t0" "$t1"
+  done
+  # Loops the optimizer collapses (closed form) or splits over threads must
+  # count the same steps as stepping them: around the exact limit of each,
+  # -O and -O --threads=4 exit like the plain run.
+  cat > "$WORK/counted.tips" <<'TIPS'
+PROGRAM COUNTED;
+VAR I : INTEGER; S : INTEGER; Q : INTEGER; N : INTEGER;
+BEGIN
+  READ(N); I := 0; S := 0;
+  WHILE I < N
+    BEGIN
+      S := S + I;
+      I := I + 1
+    END;
+  I := 0; Q := 0;
+  WHILE I < N
+    BEGIN
+      Q := Q + I * I;
+      I := I + 1
+    END;
+  WRITE(S); WRITE(Q)
+END
+TIPS
+  for n in 1000 100000; do
+    steps=$(( 6 * n + 9 ))  # 3 steps a trip in each loop, 9 statements around them
+    for m in $(( n * 3 / 2 )) $(( steps - 1 )) "$steps"; do
+      want=""
+      for opt in "" "-O" "-O --threads=4"; do
+        rc=0
+        echo "$n" | "$TARGET" $opt --max-steps="$m" "$WORK/counted.tips" > /dev/null 2>&1 || rc=$?
+        if [[ -z "$want" ]]; then
+          want=$rc
+          if [[ $rc != $(( m < steps ? 4 : 0 )) ]]; then
+            echo "  counted x$n --max-steps=$m: plain run exit status $rc"
+            exit 1
+          fi
+        elif [[ $rc != "$want" ]]; then
+          echo "  counted x$n --max-steps=$m ${opt}: exit status $rc, plain run $want"
+          exit 1
+        fi
+      done
+    done
+    printf "  %-28s same exit status with and without -O at --max-steps=%d..%d\n" "counted loops x$n" \
+      "$(( steps - 1 ))" "$steps"
+  done
+  # Runaway programs: each must stop with exit status 4 and say which limit.
+  for lim in "--max-steps=1000000" "--timeout=0.5" "--max-output=4096"; do
+    for f in loop chatty; do
+      [[ $f == loop && $lim == --max-output=* ]] && continue  # loop writes one line
+      [[ $f == loop ]] && echo 2000000000 > "$WORK/n" || : > "$WORK/n"
+      rc=0
+      t0=$(date +%s%N)
+      "$TARGET" $lim "$WORK/$f.tips" < "$WORK/n" > "$WORK/lim.out" 2> "$WORK/lim.err" || rc=$?
+      t1=$(date +%s%N)
+      if [[ $rc != 4 ]]; then
+        echo "  $f $lim: exit status $rc, expected 4"
+        exit 1
+      fi
+      printf "  %-7s %-20s stopped after %7.1f ms: %s\n" "$f" "$lim" \
+        "$(awk -v ns=$(( t1 - t0 )) 'BEGIN { print ns / 1e6 }')" "$(tail -1 "$WORK/lim.err")"
+    done
+  done
+fi
+
+if want checkpoint; then
+  echo "== --checkpoint / --resume =="
+  cat > "$WORK/job.tips" <<'TIPS'
+PROGRAM JOB;
+VAR N : INTEGER; M : INTEGER; I : INTEGER; J : INTEGER; S : INTEGER; K : INTEGER; R : REAL;
+BEGIN
+  WRITE('Rounds?');
+  READ(N);
+  READ(M);
+  S := 0; R := 0.5; K := 0;
+  WHILE ++K < N + 1
+  BEGIN
+    READ(J);
+    S := S + J;
+    I := 0;
+    WHILE I < M
+    BEGIN
+      IF (I MOD 2) = 0 THEN
+        S := (S + I * 7) MOD 1000003
+      ELSE
+      BEGIN
+        S := (S * 3 + 1) MOD 1000003;
+        R := R + 0.25
+      END;
+      I := I + 1
+    END;
+    IF (S MOD 3) = 0 THEN WRITE(S) ELSE BEGIN WRITE(K); WRITE(R) END
+  END;
+  WRITE(S)
+END
+TIPS
+  { echo "60 400000"; for ((k = 1; k <= 60; k++)); do echo $(( (k * 7919) % 997 )); done; } > "$WORK/job.in"
+  for opt in "" "-O"; do
+    t0=$(date +%s%N)
+    "$TARGET" -s $opt "$WORK/job.tips" < "$WORK/job.in" > "$WORK/ck.ref"
+    t1=$(date +%s%N)
+    "$TARGET" -s $opt --checkpoint="$WORK/ck.snap" --checkpoint-every=0.01 "$WORK/job.tips" \
+      < "$WORK/job.in" > "$WORK/ck.every"
+    t2=$(date +%s%N)
+    if ! cmp -s "$WORK/ck.ref" "$WORK/ck.every"; then
+      echo "  ${opt:-plain}: output with a snapshot every 10 ms DIFFERS"
+      exit 1
+    fi
+    # Stop the run every 0.2 s and resume it, appending to the same file.
+    rm -f "$WORK/ck.snap"
+    : > "$WORK/ck.out"
+    stops=0
+    resume=()
+    while :; do
+      "$TARGET" -s $opt --checkpoint="$WORK/ck.snap" "${resume[@]}" "$WORK/job.tips" \
+        < "$WORK/job.in" >> "$WORK/ck.out" 2> /dev/null &
+      pid=$!
+      sleep 0.2
+      kill -TERM $pid 2> /dev/null || true
+      rc=0
+      wait $pid || rc=$?
+      [[ $rc == 143 ]] || break
+      stops=$((stops + 1))
+      resume=(--resume "$WORK/ck.snap")
+    done
+    if [[ $rc != 0 ]] || ! cmp -s "$WORK/ck.ref" "$WORK/ck.out"; then
+      echo "  ${opt:-plain}: run stopped $stops times and resumed DIFFERS (exit status $rc)"
+      exit 1
+    fi
+    printf "  job %-5s unbroken %7.1f ms   snapshot every 10 ms %7.1f ms   stopped %2d times: identical\n" \
+      "${opt:-plain}" "$(awk -v ns=$(( t1 - t0 )) 'BEGIN { print ns / 1e6 }')" \
+      "$(awk -v ns=$(( t2 - t1 )) 'BEGIN { print ns / 1e6 }')" "$stops"
+  done
+fi
@@ -0,0 +1,244 @@
+// =============================================================================
+//   session.cpp — suspendable runs and the loop that multiplexes them
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   See session.h. A suspended session is its Frame, its unread input and
+//   one 16-byte Step per statement open on the way to its READ: no thread,
+//   no stack of its own.
+// =============================================================================
+#include <sstream>
+#include <stdexcept>
+#include "session.h"
+using namespace std;
+
+namespace {
+
+constexpr const char* SPACE = " \t\n\v\f\r";  // what `>>` skips
+constexpr size_t COMPACT_AT = 4096;             // unread input moves down past this
+
+bool finished(const Session& s) {  // resume() has nothing more to do
+  return s.state() == Session::State::DONE || s.state() == Session::State::FAILED;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+// SessionProgram
+// -----------------------------------------------------------------------------
+SessionProgram::SessionProgram(const Program& prog, const Frame& frame) : frame(frame) {
+  if (prog.block && prog.block->body) {
+    root = prog.block->body.get();
+    markReads(root);
+  }
+}
+
+// True if `s` can reach a READ; records every such statement.
+bool SessionProgram::markReads(const Statement* s) {
+  bool found = false;
+  if (auto* c = dynamic_cast<const CompoundStmt*>(s)) {
+    for (auto& k : c->stmts) found |= markReads(k.get());
+  } else if (auto* i = dynamic_cast<const IfStmt*>(s)) {
+    found = markReads(i->thenBranch.get());
+    if (i->elseBranch) found |= markReads(i->elseBranch.get());
+  } else if (auto* w = dynamic_cast<const WhileStmt*>(s)) {
+    found = markReads(w->body.get());
+  } else {
+    found = dynamic_cast<const ReadStmt*>(s) != nullptr;
+  }
+  if (found) reads.insert(s);
+  return found;
+}
+
+// -----------------------------------------------------------------------------
+// Session
+// -----------------------------------------------------------------------------
+Session::Session(const SessionProgram& prog) : prog(&prog), vars(prog.initialFrame()) {
+  if (prog.body()) stack.push_back({prog.body(), 0, Step::IN_BLOCK});
+}
+
+void Session::feed(string_view bytes) {
+  if (pos == input.size()) {
+    input.clear();
+    pos = 0;
+  } else if (pos > COMPACT_AT && pos * 2 > input.size()) {
+    input.erase(0, pos);
+    pos = 0;
+  }
+  input.append(bytes);
+}
+
+Session::State Session::resume(ostream& out) {
+  if (st == State::DONE || st == State::FAILED) return st;
+  Frame* saved = activeFrame;
+  activeFrame = &vars;
+  try {
+    run(out);
+  } catch (const exception& e) {
+    err = e.what();
+    st = State::FAILED;
+    stack.clear();
+  }
+  activeFrame = saved;
+  return st;
+}
+
+void Session::run(ostream& out) {
+  while (!stack.empty()) {
+    Step& top = stack.back();
+    switch (top.kind) {
+      case Step::AT_READ:
+        if (!readToken(*static_cast<const ReadStmt*>(top.stmt))) {
+          st = State::NEED_INPUT;
+          return;
+        }
+        stack.pop_back();
+        break;
+      case Step::IN_BLOCK: {
+        auto* c = static_cast<const CompoundStmt*>(top.stmt);
+        if (top.next == c->stmts.size()) {
+          stack.pop_back();
+        } else {
+          tick();
+          enter(c->stmts[top.next++].get(), out);  // may grow the stack
+        }
+        break;
+      }
+      case Step::IN_LOOP: {
+        auto* w = static_cast<const WhileStmt*>(top.stmt);
+        if (isTrueValue(w->condition->eval())) {
+          tick();
+          enter(w->body.get(), out);
+        } else {
+          stack.pop_back();
+        }
+        break;
+      }
+    }
+  }
+  st = State::DONE;
+}
+
+// Starts `s`: to completion if it cannot READ, else as far as its first step.
+void Session::enter(const Statement* s, ostream& out) {
+  if (!prog->mayRead(s)) {
+    s->interpret(out);
+  } else if (auto* c = dynamic_cast<const CompoundStmt*>(s)) {
+    stack.push_back({c, 0, Step::IN_BLOCK});
+  } else if (auto* w = dynamic_cast<const WhileStmt*>(s)) {
+    for (auto* h : w->hoisted) h->prime();
+    stack.push_back({w, 0, Step::IN_LOOP});
+  } else if (auto* i = dynamic_cast<const IfStmt*>(s)) {
+    if (isTrueValue(i->condition->eval())) enter(i->thenBranch.get(), out);
+    else if (i->elseBranch) enter(i->elseBranch.get(), out);
+  } else {
+    stack.push_back({s, 0, Step::AT_READ});
+  }
+}
+
+// Reads the next token into r's VAR. False if it may not have fully arrived.
+bool Session::readToken(const ReadStmt& r) {
+  size_t begin = input.find_first_not_of(SPACE, pos);
+  size_t end = begin == string::npos ? string::npos : input.find_first_of(SPACE, begin);
+  if (end == string::npos && !closed) return false;
+  if (begin == string::npos) begin = input.size();
+  if (end == string::npos) end = input.size();
+
+  static thread_local istringstream in;
+  in.clear();
+  in.str(input.substr(begin, end - begin));
+  ValueVariant& cell = vars.slots[r.slot];
+  if (cell.isInt()) {
+    IntType v; if (!(in >> v)) throw runtime_error("Input error: expected INTEGER for " + r.id);
+    cell = v;
+  } else {
+    RealType v; if (!(in >> v)) throw runtime_error("Input error: expected REAL for " + r.id);
+    cell = v;
+  }
+  // `>>` stops where the number does, which may be inside the token
+  streamoff taken = in.eof() ? static_cast<streamoff>(end - begin) : static_cast<streamoff>(in.tellg());
+  used += begin + static_cast<size_t>(taken) - pos;
+  pos = begin + static_cast<size_t>(taken);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// SessionLoop
+// -----------------------------------------------------------------------------
+SessionLoop::SessionLoop(const SessionProgram& prog, OutputFn onOutput, DoneFn onDone)
+  : prog(prog), onOutput(std::move(onOutput)), onDone(std::move(onDone)) {}
+
+SessionLoop::Id SessionLoop::open() {
+  Id id;
+  if (!freeIds.empty()) {
+    id = freeIds.back();
+    freeIds.pop_back();
+  } else {
+    id = static_cast<Id>(sessions.size());
+    sessions.emplace_back();
+    queued.push_back(0);
+  }
+  sessions[id] = make_unique<Session>(prog);
+  wake(id);
+  return id;
+}
+
+// A session that has finished is still there during the callbacks of the
+// resume that finished it; input for it is dropped, not a reason to wake it.
+void SessionLoop::feed(Id id, string_view bytes) {
+  if (id >= sessions.size() || !sessions[id]) throw runtime_error("session: no session " + to_string(id));
+  if (finished(*sessions[id])) return;
+  sessions[id]->feed(bytes);
+  wake(id);
+}
+
+void SessionLoop::endInput(Id id) {
+  if (id >= sessions.size() || !sessions[id]) throw runtime_error("session: no session " + to_string(id));
+  if (finished(*sessions[id])) return;
+  sessions[id]->endInput();
+  wake(id);
+}
+
+void SessionLoop::wake(Id id) {
+  if (queued[id]) return;
+  queued[id] = 1;
+  ready.push_back(id);
+}
+
+size_t SessionLoop::runReady() {
+  vector<Id> now;
+  now.swap(ready);  // sessions fed from the callbacks wait for the next round
+  ostream out(&collect);
+  for (Id id : now) {
+    queued[id] = 0;
+    if (!sessions[id]) continue;  // finished since it was woken
+    Session& s = *sessions[id];
+    Session::State st = s.resume(out);
+    if (!collect.text.empty()) {
+      if (onOutput) onOutput(id, collect.text);
+      collect.text.clear();
+    }
+    if (finished(s)) {
+      if (onDone) onDone(id, s);
+      sessions[id].reset();
+      freeIds.push_back(id);
+    }
+  }
+  size_t ran = now.size();
+  if (ready.empty()) {
+    now.clear();
+    ready.swap(now);  // keep the capacity
+  }
+  return ran;
+}
+
+SessionLoop::Collect::int_type SessionLoop::Collect::overflow(int_type c) {
+  if (!traits_type::eq_int_type(c, traits_type::eof())) text.push_back(traits_type::to_char_type(c));
+  return traits_type::not_eof(c);
+}
+
+streamsize SessionLoop::Collect::xsputn(const char* s, streamsize n) {
+  text.append(s, static_cast<size_t>(n));
+  return n;
+}
@@ -0,0 +1,138 @@
+// =============================================================================
+//   session.h — runs that wait for input without holding a thread
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   ReadStmt::interpret blocks its thread on the input stream. A Session
+//   runs the same tree but, when a READ finds no complete token in the
+//   bytes it has been fed, it returns NEED_INPUT instead and picks up at
+//   that READ on the next resume(). Its whole state is its own variable
+//   frame, the unread input and a small stack of continuations.
+//
+//   Only the statements that can reach a READ are walked step by step:
+//   BEGIN ... END (which child is next), WHILE (re-test the condition when
+//   the body finishes), IF (enter the chosen branch) and the READ itself.
+//   Every other statement runs through its ordinary interpret(), so apart
+//   from the READs a session costs what a plain run does. The statements the
+//   optimizer builds never contain a READ (it leaves such loops alone).
+//
+//   A token counts as complete once whitespace follows it or the input is
+//   ended; it is then converted exactly as `cin >>` would, with the same
+//   error for a bad one.
+//
+//   SessionLoop keeps any number of sessions of one program on the calling
+//   thread: input arrives with feed(), and runReady() resumes each session
+//   that has something new to work on and hands on what it wrote.
+// =============================================================================
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "ast.h"
+
+// A parsed program prepared for sessions: which of its statements contain a
+// READ. Sessions keep a pointer to it, so it must outlive them.
+class SessionProgram {
+public:
+  // `frame` is what every session starts from (VARs as declared).
+  SessionProgram(const Program& prog, const Frame& frame);
+
+  const CompoundStmt* body() const { return root; }
+  const Frame& initialFrame() const { return frame; }
+  bool mayRead(const Statement* s) const { return reads.count(s) != 0; }
+
+private:
+  const CompoundStmt* root = nullptr;
+  Frame frame;
+  std::unordered_set<const Statement*> reads;
+
+  bool markReads(const Statement* s);
+};
+
+class Session {
+public:
+  enum class State : uint8_t { READY, NEED_INPUT, DONE, FAILED };
+
+  explicit Session(const SessionProgram& prog);
+
+  void feed(std::string_view bytes);
+  void endInput() { closed = true; }  // no more bytes will come
+
+  // Runs until a READ lacks input, the program ends or a runtime error
+  // stops it; WRITE output goes to `out`. Does nothing once DONE or FAILED.
+  State resume(std::ostream& out);
+
+  State state() const { return st; }
+  const std::string& error() const { return err; }   // FAILED: the message
+  const Frame& frame() const { return vars; }
+  uint64_t consumed() const { return used; }         // input bytes read so far
+
+private:
+  // One statement still in progress on the path to the current READ.
+  struct Step {
+    enum Kind : uint8_t { IN_BLOCK, IN_LOOP, AT_READ };
+    const Statement* stmt;
+    uint32_t next;  // IN_BLOCK: index of the child to run next
+    Kind kind;
+  };
+
+  const SessionProgram* prog;
+  Frame vars;
+  std::vector<Step> stack;
+  std::string input;  // fed bytes from `pos` on are unread
+  size_t pos = 0;
+  uint64_t used = 0;
+  bool closed = false;
+  State st = State::READY;
+  std::string err;
+
+  void run(std::ostream& out);
+  void enter(const Statement* s, std::ostream& out);
+  bool readToken(const ReadStmt& r);
+};
+
+class SessionLoop {
+public:
+  using Id = uint32_t;
+  using OutputFn = std::function<void(Id, std::string_view)>;
+  using DoneFn = std::function<void(Id, const Session&)>;
+
+  // onOutput gets each session's WRITE output after every resume, onDone
+  // the session when it finishes or fails; its id is then free for reuse.
+  SessionLoop(const SessionProgram& prog, OutputFn onOutput, DoneFn onDone);
+
+  // feed() and endInput() do nothing for a session that has finished, even
+  // from the callbacks of the resume that finished it.
+  Id open();                          // starts on the next runReady()
+  void feed(Id id, std::string_view bytes);
+  void endInput(Id id);
+  size_t runReady();                  // resumes every session with news; returns how many
+  size_t live() const { return sessions.size() - freeIds.size(); }
+
+private:
+  // Collects one resume's output so it can be handed on in one piece.
+  class Collect : public std::streambuf {
+  public:
+    std::string text;
+  protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+  };
+
+  const SessionProgram& prog;
+  OutputFn onOutput;
+  DoneFn onDone;
+  std::vector<std::unique_ptr<Session>> sessions;  // null: free id
+  std::vector<Id> freeIds;
+  std::vector<Id> ready;
+  std::vector<char> queued;  // per id: already in `ready`
+  Collect collect;
+
+  void wake(Id id);
+};
@@ -0,0 +1,177 @@
+// =============================================================================
+//   sessionbench.cpp — many suspended sessions on one thread (session.h)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Parses FILE, runs it once the ordinary way with INPUT (a file of READ
+//   input) as the reference, then opens N sessions of it on a SessionLoop:
+//     open    every session runs to its first READ; resident memory before
+//             and after, divided by N, is the cost of a waiting session
+//     feed    INPUT is handed out one token at a time, round robin over all
+//             live sessions, each round followed by runReady(), then the
+//             input is ended; timed, with the number of resumes
+//   Every session's output (and error, if the reference run failed) must
+//   equal the reference run's; the bench exits 1 on the first that does not.
+//     answer  a second loop of N sessions whose onOutput answers every
+//             prompt by feeding "42\n" to the session that wrote it, also
+//             when that resume is the one that finishes it; every session
+//             must finish (input is ended after ANSWER_ROUNDS rounds)
+//
+//   Build/run:  make sessionbench && ./sessionbench FILE INPUT [sessions]
+// =============================================================================
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "incremental.h"
+#include "lexer.h"
+#include "session.h"
+#include "simdscan.h"
+using namespace std;
+
+unique_ptr<Program> parseProgram();
+
+using Clock = chrono::steady_clock;
+
+static double msSince(Clock::time_point t0) {
+  return chrono::duration<double, milli>(Clock::now() - t0).count();
+}
+
+static long residentBytes() {
+  long pages = 0, rss = 0;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (!f) return 0;
+  if (fscanf(f, "%ld %ld", &pages, &rss) != 2) rss = 0;
+  fclose(f);
+  return rss * sysconf(_SC_PAGESIZE);
+}
+
+static string readFile(const char* path) {
+  ifstream in(path, ios::binary);
+  if (!in) { perror(path); exit(1); }
+  return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s FILE INPUT [sessions]\n", argv[0]);
+    return 1;
+  }
+  FILE* src = fopen(argv[1], "r");
+  if (!src) { perror(argv[1]); return 1; }
+  string input = readFile(argv[2]);
+  size_t n = argc > 3 ? strtoul(argv[3], nullptr, 10) : 10000;
+
+  unique_ptr<Program> prog;
+  try {
+    resetParser();
+    restartScanner(src);
+    yylineno = 1;
+    prog = parseProgram();
+  } catch (const exception& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  fclose(src);
+
+  // Reference: a plain run reading all of INPUT.
+  string wantOut, wantErr;
+  {
+    Frame frame = varFrame;
+    istringstream in(input);
+    ostringstream out;
+    activeFrame = &frame;
+    activeInput = &in;
+    try { prog->interpret(out); } catch (const exception& e) { wantErr = e.what(); }
+    activeFrame = &varFrame;
+    activeInput = &cin;
+    wantOut = out.str();
+  }
+
+  vector<string> tokens;
+  {
+    istringstream words(input);
+    for (string w; words >> w;) tokens.push_back(w);
+  }
+
+  SessionProgram sp(*prog, varFrame);
+  vector<string> output(n);
+  vector<string> error(n);
+  vector<char> finished(n);
+  size_t done = 0;
+  SessionLoop loop(sp,
+                   [&](SessionLoop::Id id, string_view text) { output[id].append(text); },
+                   [&](SessionLoop::Id id, const Session& s) {
+                     error[id] = s.error();
+                     finished[id] = 1;
+                     ++done;
+                   });
+
+  long before = residentBytes();
+  auto t0 = Clock::now();
+  for (size_t i = 0; i < n; ++i) loop.open();
+  size_t resumes = loop.runReady();
+  double openMs = msSince(t0);
+  long after = residentBytes();
+  printf("%zu sessions: %zu waiting for input after %.1f ms; %.0f bytes resident per session\n",
+         n, loop.live(), openMs, static_cast<double>(after - before) / static_cast<double>(n));
+
+  // Ids are only reused once a session finishes, and none is opened from
+  // here on, so session i keeps id i.
+  t0 = Clock::now();
+  for (const string& w : tokens) {
+    if (loop.live() == 0) break;
+    string piece = w + "\n";
+    for (size_t i = 0; i < n; ++i)
+      if (!finished[i]) loop.feed(static_cast<SessionLoop::Id>(i), piece);
+    resumes += loop.runReady();
+  }
+  for (size_t i = 0; i < n; ++i)
+    if (!finished[i]) loop.endInput(static_cast<SessionLoop::Id>(i));
+  resumes += loop.runReady();
+  double feedMs = msSince(t0);
+  printf("fed %zu tokens to each: %zu resumes in %.1f ms (%.2f us per resume)\n",
+         tokens.size(), resumes, feedMs, feedMs * 1000.0 / static_cast<double>(resumes ? resumes : 1));
+
+  for (size_t i = 0; i < n; ++i) {
+    if (!finished[i] || output[i] != wantOut || error[i] != wantErr) {
+      fprintf(stderr, "session %zu differs from the plain run%s\n", i, finished[i] ? "" : " (never finished)");
+      fprintf(stderr, "--- plain\n%s%s\n--- session\n%s%s\n", wantOut.c_str(), wantErr.c_str(),
+              output[i].c_str(), error[i].c_str());
+      return 1;
+    }
+  }
+  printf("all %zu sessions match the plain run (%zu finished)\n", n, done);
+
+  // Input from inside the callbacks: onOutput feeds the session that just
+  // wrote, which may be finishing in that very resume.
+  constexpr size_t ANSWER_ROUNDS = 1000;
+  size_t answered = 0;
+  SessionLoop* self = nullptr;
+  SessionLoop answers(sp,
+                      [&](SessionLoop::Id id, string_view) { self->feed(id, "42\n"); },
+                      [&](SessionLoop::Id, const Session&) { ++answered; });
+  self = &answers;
+  for (size_t i = 0; i < n; ++i) answers.open();
+  size_t rounds = 0;
+  t0 = Clock::now();
+  while (answers.live() && rounds < ANSWER_ROUNDS) {
+    answers.runReady();
+    ++rounds;
+  }
+  for (size_t i = 0; i < n && answers.live(); ++i) answers.endInput(static_cast<SessionLoop::Id>(i));
+  while (answers.runReady()) ++rounds;
+  if (answered != n || answers.live()) {
+    fprintf(stderr, "answering from onOutput: %zu of %zu sessions finished\n", answered, n);
+    return 1;
+  }
+  printf("answered every prompt from onOutput: %zu sessions finished in %zu rounds, %.1f ms\n", n,
+         rounds, msSince(t0));
+  return 0;
+}
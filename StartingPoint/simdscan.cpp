@@ -0,0 +1,207 @@
+// =============================================================================
+//   simdscan.cpp — hand-written scanner with vectorized byte-class runs
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   The whole input is read into one buffer padded with zero bytes, so a
+//   block load never reads past the allocation. Whitespace runs (counting
+//   their newlines for yylineno), ## comments, identifier and number bodies
+//   and string literals are each the run up to the first byte of some class,
+//   found a block at a time by comparing the block against the class and
+//   taking the lowest set bit of the movemask. Blocks are 32 bytes with AVX2
+//   (build with -mavx2 or -march=native), 16 with SSE2 (any x86-64) and a
+//   single byte elsewhere.
+//
+//   Everything else mirrors rules.l: longest match, UNKNOWN for words over
+//   8 characters that are not keywords, for string literals over 80
+//   characters or without a closing quote on their line, and for any single
+//   byte no rule matches.
+// =============================================================================
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "simdscan.h"
+#include "skins.h"
+using namespace std;
+
+int (*gLex)(void) = yylex;
+
+namespace {
+
+// -----------------------------------------------------------------------------
+// Blocks of W bytes: load, compare against a byte or a byte range, movemask
+// -----------------------------------------------------------------------------
+#if defined(__AVX2__)
+struct Block {
+  static constexpr size_t W = 32;
+  __m256i v;
+  explicit Block(const char* p) : v(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))) {}
+  uint32_t eq(char c) const {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+  }
+  uint32_t in(char lo, char hi) const {  // lo <= byte <= hi, for ASCII lo/hi
+    __m256i ge = _mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1)));
+    __m256i le = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v);
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(ge, le)));
+  }
+};
+constexpr const char* WIDTH = "AVX2";
+#elif defined(__SSE2__)
+struct Block {
+  static constexpr size_t W = 16;
+  __m128i v;
+  explicit Block(const char* p) : v(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+  uint32_t eq(char c) const {
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+  }
+  uint32_t in(char lo, char hi) const {
+    __m128i ge = _mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1)));
+    __m128i le = _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(ge, le)));
+  }
+};
+constexpr const char* WIDTH = "SSE2";
+#else
+struct Block {
+  static constexpr size_t W = 1;
+  signed char v;
+  explicit Block(const char* p) : v(static_cast<signed char>(*p)) {}
+  uint32_t eq(char c) const { return v == static_cast<signed char>(c); }
+  uint32_t in(char lo, char hi) const { return v >= lo && v <= hi; }
+};
+constexpr const char* WIDTH = "scalar";
+#endif
+constexpr uint32_t FULL = Block::W == 32 ? 0xFFFFFFFFu : (1u << Block::W) - 1;
+
+string src;               // yyin, then Block::W zero bytes
+const char* cur = nullptr;
+const char* limit = nullptr;
+string text;              // yytext storage
+
+// First byte at or after p whose bit `stop` sets, or `limit`.
+template <class Stop>
+const char* findFirst(const char* p, Stop stop) {
+  for (; p < limit; p += Block::W) {
+    uint32_t m = stop(Block(p));
+    if (m) return min(p + __builtin_ctz(m), limit);
+  }
+  return limit;
+}
+
+const char* skipSpace(const char* p, int& lines) {
+  for (; p < limit; p += Block::W) {
+    Block b(p);
+    uint32_t nl = b.eq('\n');
+    uint32_t other = ~(nl | b.eq(' ') | b.eq('\t') | b.eq('\r')) & FULL;
+    if (other) {
+      lines += __builtin_popcount(nl & ((other & -other) - 1));
+      return min(p + __builtin_ctz(other), limit);
+    }
+    lines += __builtin_popcount(nl);
+  }
+  return limit;
+}
+
+const char* spanWord(const char* p) {
+  return findFirst(p, [](const Block& b) { return ~(b.in('A', 'Z') | b.in('0', '9')) & FULL; });
+}
+const char* spanDigits(const char* p) {
+  return findFirst(p, [](const Block& b) { return ~b.in('0', '9') & FULL; });
+}
+const char* findNewline(const char* p) {
+  return findFirst(p, [](const Block& b) { return b.eq('\n'); });
+}
+const char* findQuoteOrNewline(const char* p) {
+  return findFirst(p, [](const Block& b) { return b.eq('\'') | b.eq('\n'); });
+}
+
+void load() {
+  FILE* in = yyin ? yyin : stdin;
+  char chunk[1 << 16];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof chunk, in)) > 0) src.append(chunk, n);
+  size_t size = src.size();
+  src.append(Block::W, '\0');
+  cur = src.data();
+  limit = cur + size;
+}
+
+int emit(const char* s, const char* e, int tok) {
+  text.assign(s, e);
+  yytext = &text[0];
+  cur = e;
+  return tok;
+}
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+}  // namespace
+
+// -----------------------------------------------------------------------------
+// Scanner
+// -----------------------------------------------------------------------------
+int simdLex(void) {
+  if (!cur) load();
+  for (;;) {
+    const char* p = skipSpace(cur, yylineno);
+    if (p == limit) return emit(limit, limit, 0);
+    char c = p[0], d = p[1];  // p[1] is padding at the last byte
+
+    if (c >= 'A' && c <= 'Z') {
+      const char* e = spanWord(p + 1);
+      size_t n = static_cast<size_t>(e - p);
+      if (Token k = lookupKeyword(p, n)) return emit(p, e, k);
+      if (n > 8) return emit(p, e, UNKNOWN);
+      emit(p, e, IDENT);
+      yyidkey = packIdent(yytext);
+      return IDENT;
+    }
+    if (isDigit(c)) {
+      const char* e = spanDigits(p + 1);
+      if (e < limit && e[0] == '.' && isDigit(e[1])) return emit(p, spanDigits(e + 2), FLOATLIT);
+      return emit(p, e, INTLIT);
+    }
+    if (c == '\'') {
+      const char* q = findQuoteOrNewline(p + 1);
+      if (q == limit || *q == '\n') return emit(p, q, UNKNOWN);  // unterminated
+      return emit(p, q + 1, q - (p + 1) <= 80 ? STRINGLIT : UNKNOWN);
+    }
+    if (c == '#' && d == '#') {
+      cur = findNewline(p + 2);
+      continue;
+    }
+
+    switch (c) {
+      case ':': return d == '=' ? emit(p, p + 2, ASSIGN) : emit(p, p + 1, COLON);
+      case '+': return d == '+' ? emit(p, p + 2, INCREMENT) : emit(p, p + 1, PLUS);
+      case '-': return d == '-' ? emit(p, p + 2, DECREMENT) : emit(p, p + 1, MINUS);
+      case '<': return d == '>' ? emit(p, p + 2, NOTEQUALTO) : emit(p, p + 1, LESSTHAN);
+      case '^': return d == '^' ? emit(p, p + 2, CUSTOM_OPER) : emit(p, p + 1, UNKNOWN);
+      case '(': return emit(p, p + 1, OPENPAREN);
+      case ')': return emit(p, p + 1, CLOSEPAREN);
+      case ';': return emit(p, p + 1, SEMICOLON);
+      case '/': return emit(p, p + 1, DIVIDE);
+      case '*': return emit(p, p + 1, MULTIPLY);
+      case '=': return emit(p, p + 1, EQUALTO);
+      case '>': return emit(p, p + 1, GREATERTHAN);
+      default:  return emit(p, p + 1, UNKNOWN);
+    }
+  }
+}
+
+const char* simdLexWidth() { return WIDTH; }
+
+void restartScanner(FILE* in) {
+  yyin = in;
+  if (gLex == simdLex) {
+    src.clear();
+    cur = limit = nullptr;
+  } else {
+    yyrestart(in);
+  }
+}
@@ -0,0 +1,22 @@
+// =============================================================================
+//   simdscan.h — hand-written scanner, an alternative to flex (--scanner=simd)
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   simdLex() returns exactly the token stream of rules.l and maintains the
+//   same yytext, yylineno and yyidkey, so the parser and -t can use either
+//   scanner through gLex (lexer.h). See simdscan.cpp.
+// =============================================================================
+#pragma once
+#include "lexer.h"
+
+// Reads all of yyin on the first call, then returns one token per call.
+int simdLex(void);
+
+// Vector width simdLex() was built for: "AVX2", "SSE2" or "scalar".
+const char* simdLexWidth();
+
+// Points gLex at the start of `in`, discarding whatever either scanner had
+// buffered from the previous input. yylineno is left for the caller to set.
+void restartScanner(FILE* in);
@@ -0,0 +1,196 @@
+// =============================================================================
+//   skins.cpp — keyword skin tables and their perfect hashes
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   A skin is the list of spellings of the KEYWORDS below. Loading a skin
+//   searches for a seed under which the FNV-1a hashes of its spellings land
+//   in distinct buckets of a small power-of-two table; lookupKeyword() then
+//   hashes the lexeme with that seed and compares it against the one
+//   spelling in its bucket.
+// =============================================================================
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "hashing.h"
+#include "skins.h"
+using namespace std;
+
+// -----------------------------------------------------------------------------
+// Keywords and built-in spellings
+// -----------------------------------------------------------------------------
+struct Keyword {
+  const char* name;  // default spelling, also the name used in skin files
+  Token tok;
+};
+static const Keyword KEYWORDS[] = {
+  {"PROGRAM", PROGRAM}, {"BEGIN", TOK_BEGIN}, {"END", END},     {"WRITE", WRITE},
+  {"READ", READ},       {"IF", IF},           {"THEN", THEN},   {"ELSE", ELSE},
+  {"WHILE", WHILE},     {"SENIORITIS", SENIORITIS},             {"NOT", TOK_NOT},
+  {"AND", TOK_AND},     {"OR", TOK_OR},       {"VAR", VAR},     {"INTEGER", INTEGER},
+  {"REAL", REAL},       {"MOD", MOD},
+};
+constexpr size_t NKEYWORDS = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+
+struct BuiltinSkin {
+  const char* name;
+  const char* spellings[NKEYWORDS];  // in KEYWORDS order; nullptr = default
+};
+static const BuiltinSkin BUILTINS[] = {
+  {"default", {}},
+  {"pirate", {"VOYAGE", "AHOY", "AVAST", "SQUAWK", "SPYGLASS", "MAYHAP", "THAR", "NAY",
+              "WHILST", "GROG", "NAE", "AN", "ER", "BOOTY", "DOUBLOON", "PIECEOF8", "PLUNDER"}},
+  {"cat",    {"CATNIP", "PURR", "HISS", "MEOW", "SNIFF", "SNOOP", "POUNCE", "IGNORE",
+              "CHASE", "NAP", "NOPE", "ALSO", "EITHER", "KITTEN", "WHISKER", "FUR", "SCRATCH"}},
+};
+
+// -----------------------------------------------------------------------------
+// Skin tables
+// -----------------------------------------------------------------------------
+class Skin {
+public:
+  string name;
+  string spelling[NKEYWORDS];
+
+  // Finds a collision-free seed; call after filling `spelling`.
+  void build() {
+    for (size_t size = 32;; size *= 2) {
+      for (uint64_t seed = 1; seed <= 4096; ++seed) {
+        if (tryBuild(seed, size)) return;
+      }
+    }
+  }
+
+  Token lookup(const char* s, size_t n) const {
+    const Bucket& b = buckets[hash(s, n, seed) & mask];
+    if (b.len != n || b.tok == 0 || memcmp(b.text, s, n) != 0) return 0;
+    return b.tok;
+  }
+
+private:
+  struct Bucket {
+    const char* text = nullptr;  // points into `spelling`
+    size_t len = 0;
+    Token tok = 0;
+  };
+  vector<Bucket> buckets;
+  uint64_t seed = 0;
+  size_t mask = 0;
+
+  static uint64_t hash(const char* s, size_t n, uint64_t seed) {  // seeded FNV-1a
+    uint64_t h = fnv::hash(std::string_view(s, n), fnv::BASIS ^ (seed * 0x9E3779B97F4A7C15ull));
+    return h ^ (h >> 29);
+  }
+
+  bool tryBuild(uint64_t s, size_t size) {
+    vector<Bucket> table(size);
+    for (size_t k = 0; k < NKEYWORDS; ++k) {
+      Bucket& b = table[hash(spelling[k].data(), spelling[k].size(), s) & (size - 1)];
+      if (b.tok != 0) return false;
+      b = Bucket{spelling[k].data(), spelling[k].size(), KEYWORDS[k].tok};
+    }
+    buckets = std::move(table);
+    seed = s;
+    mask = size - 1;
+    return true;
+  }
+};
+
+static vector<unique_ptr<Skin>> loaded;  // built-ins first, then skin files
+static const Skin* active = nullptr;
+
+static bool isWord(const string& w) {
+  if (w.empty() || w[0] < 'A' || w[0] > 'Z') return false;
+  for (char c : w)
+    if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))) return false;
+  return true;
+}
+
+static void loadBuiltins() {
+  if (!loaded.empty()) return;
+  for (const BuiltinSkin& b : BUILTINS) {
+    auto skin = make_unique<Skin>();
+    skin->name = b.name;
+    for (size_t k = 0; k < NKEYWORDS; ++k)
+      skin->spelling[k] = b.spellings[k] ? b.spellings[k] : KEYWORDS[k].name;
+    skin->build();
+    loaded.push_back(std::move(skin));
+  }
+  active = loaded.front().get();
+}
+
+static string available() {
+  string names = "default, INITIAL";
+  for (size_t i = 1; i < loaded.size(); ++i) names += ", " + loaded[i]->name;
+  return names + ", or a skin file";
+}
+
+static unique_ptr<Skin> loadFile(const string& path) {
+  ifstream in(path);
+  if (!in) throw runtime_error("Cannot open skin file: " + path);
+  auto skin = make_unique<Skin>();
+  skin->name = path;
+  for (size_t k = 0; k < NKEYWORDS; ++k) skin->spelling[k] = KEYWORDS[k].name;
+
+  string line;
+  for (int lineNo = 1; getline(in, line); ++lineNo) {
+    istringstream fields(line);
+    string key, spelled, extra;
+    if (!(fields >> key) || key[0] == '#') continue;
+    string where = path + ":" + to_string(lineNo) + ": ";
+    if (!(fields >> spelled) || (fields >> extra))
+      throw runtime_error(where + "expected KEYWORD SPELLING");
+    size_t k = 0;
+    while (k < NKEYWORDS && key != KEYWORDS[k].name) ++k;
+    if (k == NKEYWORDS) throw runtime_error(where + "unknown keyword " + key);
+    if (!isWord(spelled)) throw runtime_error(where + "spelling must match [A-Z][A-Z0-9]*: " + spelled);
+    skin->spelling[k] = spelled;
+  }
+  for (size_t a = 0; a < NKEYWORDS; ++a)
+    for (size_t b = a + 1; b < NKEYWORDS; ++b)
+      if (skin->spelling[a] == skin->spelling[b])
+        throw runtime_error(path + ": " + KEYWORDS[a].name + " and " + KEYWORDS[b].name +
+                            " are both spelled " + skin->spelling[a]);
+  skin->build();
+  return skin;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+Token lookupKeyword(const char* s, size_t n) {
+  if (!active) loadBuiltins();
+  return active->lookup(s, n);
+}
+
+void selectSkin(const string& name) {
+  loadBuiltins();
+  if (name == "INITIAL") { active = loaded.front().get(); return; }
+  for (const auto& skin : loaded) {
+    if (skin->name == name) { active = skin.get(); return; }
+  }
+  if (name.find_first_of("/.") == string::npos)
+    throw runtime_error("Unknown skin: " + name + " (available: " + available() + ")");
+  loaded.push_back(loadFile(name));
+  active = loaded.back().get();
+}
+
+void listSkins(ostream& os) {
+  loadBuiltins();
+  for (const auto& skin : loaded) {
+    os << (skin.get() == active ? "* " : "  ") << skin->name;
+    bool respelled = false;
+    for (size_t k = 0; k < NKEYWORDS; ++k) {
+      if (skin->spelling[k] == KEYWORDS[k].name) continue;
+      os << ' ' << KEYWORDS[k].name << '=' << skin->spelling[k];
+      respelled = true;
+    }
+    os << (respelled ? "\n" : " (standard keywords)\n");
+  }
+}
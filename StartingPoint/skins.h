@@ -0,0 +1,34 @@
+// =============================================================================
+//   skins.h — keyword skins: per-skin spellings of the TIPS keywords
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   The scanner matches every word with the identifier pattern and asks
+//   lookupKeyword() whether the active skin spells a keyword that way. Each
+//   skin is a perfect-hash table built once when it is loaded, so adding
+//   skins does not grow the scanner's DFA and a lookup is one hash and at
+//   most one compare whichever skin is active.
+//
+//   Built-in skins are default (alias INITIAL), pirate and cat. A skin file
+//   holds one "KEYWORD SPELLING" pair per line (blank lines and lines
+//   starting with # are ignored); keywords it does not mention keep their
+//   default spelling. Spellings must match [A-Z][A-Z0-9]* and be distinct.
+// =============================================================================
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include "lexer.h"
+
+// Keyword token the active skin spells as s[0..n), or 0 if it spells none.
+Token lookupKeyword(const char* s, size_t n);
+
+// Makes the built-in skin `name`, or the skin file at path `name` (any name
+// containing '/' or '.'), the active one. Throws runtime_error if there is no
+// such skin or the file is malformed; the message lists the skins available.
+void selectSkin(const std::string& name);
+
+// --list-skins: one line per loaded skin, the active one marked with '*',
+// showing the keywords it respells.
+void listSkins(std::ostream& os);
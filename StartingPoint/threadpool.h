@@ -0,0 +1,99 @@
+// =============================================================================
+//   threadpool.h — fixed worker pool for data-parallel interpreter work
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   run(n, fn) calls fn(0) .. fn(n-1) spread over the workers and the calling
+//   thread, and returns once every call has finished. Tasks are claimed under
+//   the pool mutex, so a run is meant for a handful of coarse chunks, not for
+//   one task per loop trip. An exception thrown by a task is rethrown from
+//   run() on the calling thread (the first one wins; the rest still finish).
+// =============================================================================
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+class ThreadPool {
+public:
+  // `threads` counts the caller too: ThreadPool(4) starts three workers.
+  explicit ThreadPool(unsigned threads) {
+    for (unsigned i = 1; i < threads; ++i) workers.emplace_back([this] { workerLoop(); });
+  }
+
+  ~ThreadPool() {
+    {
+      lock_guard<mutex> lk(m);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+  void run(size_t tasks, const function<void(size_t)>& fn) {
+    unique_lock<mutex> lk(m);
+    job = &fn;
+    next = 0;
+    total = tasks;
+    pending = tasks;
+    failure = nullptr;
+    wake.notify_all();
+    drain(lk);
+    done.wait(lk, [this] { return pending == 0; });
+    job = nullptr;
+    if (failure) rethrow_exception(failure);
+  }
+
+  // Process-wide pool, created by the first caller with its thread count.
+  static ThreadPool& shared(unsigned threads) {
+    static ThreadPool pool(threads);
+    return pool;
+  }
+
+private:
+  vector<thread> workers;
+  mutex m;
+  condition_variable wake, done;
+  const function<void(size_t)>* job = nullptr;
+  size_t next = 0, total = 0, pending = 0;
+  exception_ptr failure;
+  bool stopping = false;
+
+  // Runs unclaimed tasks of the current job; `lk` is held on entry and exit.
+  void drain(unique_lock<mutex>& lk) {
+    while (next < total) {
+      size_t i = next++;
+      const function<void(size_t)>* f = job;
+      lk.unlock();
+      exception_ptr err;
+      try {
+        (*f)(i);
+      } catch (...) {
+        err = current_exception();
+      }
+      lk.lock();
+      if (err && !failure) failure = err;
+      if (--pending == 0) done.notify_all();
+    }
+  }
+
+  void workerLoop() {
+    unique_lock<mutex> lk(m);
+    while (true) {
+      wake.wait(lk, [this] { return stopping || next < total; });
+      if (stopping) return;
+      drain(lk);
+    }
+  }
+};
@@ -0,0 +1,74 @@
+// =============================================================================
+//   tipsc.cpp — command-line client for tipsd
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Usage: tipsc [--socket=PATH] [-s] FILE
+//          tipsc [--socket=PATH] [-s] --hash=HEX
+//
+//   Runs FILE (or a program tipsd has cached, by the hash printed with
+//   --print-hash) on the daemon with this process's stdin as its input.
+//   WRITE output streams to stdout, an error goes to stderr, and the exit
+//   status is the daemon's: 0, 2 after an error, 3 for an unknown hash, 4 when
+//   the run went over one of the daemon's limits.
+// =============================================================================
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include "tipsd.h"
+using namespace std;
+
+int main(int argc, char** argv) {
+  string path = tipsd::DEFAULT_SOCKET;
+  const char* file = nullptr;
+  const char* hashArg = nullptr;
+  uint8_t flags = 0;
+  bool printHash = false;
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    if (!strncmp(a, "--socket=", 9)) path = a + 9;
+    else if (!strncmp(a, "--hash=", 7)) hashArg = a + 7;
+    else if (!strcmp(a, "--print-hash")) printHash = true;
+    else if (!strcmp(a, "-s")) flags |= tipsd::FLAG_SYMBOLS;
+    else if (a[0] != '-' && !file) file = a;
+    else {
+      fprintf(stderr, "usage: %s [--socket=PATH] [-s] [--print-hash] FILE | --hash=HEX\n", argv[0]);
+      return 1;
+    }
+  }
+  if (!file == !hashArg) {
+    fprintf(stderr, "%s: give a program FILE or --hash=HEX\n", argv[0]);
+    return 1;
+  }
+
+  string source;
+  uint64_t hash = 0;
+  if (file) {
+    ifstream in(file, ios::binary);
+    if (!in) { perror(file); return 1; }
+    source.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+  } else {
+    char* end = nullptr;
+    hash = strtoull(hashArg, &end, 16);
+    if (end == hashArg || *end) { fprintf(stderr, "%s: bad hash %s\n", argv[0], hashArg); return 1; }
+  }
+  string input(istreambuf_iterator<char>(cin), istreambuf_iterator<char>{});
+
+  try {
+    tipsd::Reply r = tipsd::run(path, file ? &source : nullptr, hash, input, flags,
+                                [](string_view out) { fwrite(out.data(), 1, out.size(), stdout); });
+    fflush(stdout);
+    if (!r.error.empty()) fprintf(stderr, "%s\n", r.error.c_str());
+    if (printHash && r.hash) fprintf(stderr, "hash %016" PRIx64 "\n", r.hash);
+    return r.status;
+  } catch (const exception& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+}
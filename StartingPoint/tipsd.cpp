@@ -0,0 +1,396 @@
+// =============================================================================
+//   tipsd.cpp — interpreter daemon: cached programs, runs on a worker pool
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Usage: tipsd [--socket=PATH] [--workers=N] [--cache=N] [-O]
+//                [--max-steps=N] [--timeout=SEC] [--max-output=N]
+//
+//   The main thread accepts connections on a Unix stream socket and queues
+//   them; a fixed pool of workers takes one connection at a time, reads its
+//   request (protocol in tipsd.h), runs it and closes it.
+//
+//   Programs are cached by the hash of their source, least recently used
+//   out past --cache entries. The parser keeps its state in globals, so
+//   compiling is serialized; each compiled program keeps its own copy of
+//   the variable frame and symbol table the parse left, and every run gets
+//   a fresh copy of that frame (activeFrame) and reads the request's input
+//   bytes (activeInput), so any number of runs of one tree go at once.
+//   Compiled trees are never written to while they run; a tree evicted
+//   while runs still use it lives until the last one finishes, and its
+//   WRITE literals, which are interned into a string pool of its own
+//   (activePool), go with it.
+//
+//   With -O every program is optimized as `parse -O -s` would (symbols are
+//   kept so any request may ask for them), without --threads. The limits
+//   apply to every run as they do for `parse`; a run that goes over one
+//   ends with status LIMIT and the message in its 'E' frame.
+//
+//   A client that hangs up, or stops sending or reading for 10 seconds,
+//   loses its connection: its run stops at the next frame the worker fails
+//   to send or, if it sends none, within CLOCK_EVERY steps (budget.h
+//   polls the socket), and the worker takes the next connection.
+// =============================================================================
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/time.h>
+#include "ast.h"
+#include "incremental.h"
+#include "lexer.h"
+#include "optimize.h"
+#include "simdscan.h"
+#include "tipsd.h"
+using namespace std;
+
+unique_ptr<Program> parseProgram();
+
+namespace {
+
+// -----------------------------------------------------------------------------
+// Program cache
+// -----------------------------------------------------------------------------
+struct Compiled {
+  string source;                  // to tell hash collisions apart
+  unique_ptr<StringPool> pool = make_unique<StringPool>();  // its WRITE operands
+  unique_ptr<Program> prog;
+  Frame frame;                    // VARs as declared, plus -O temporaries
+  map<string, size_t> symbols;    // this program's symbolTable
+};
+
+class ProgramCache {
+public:
+  ProgramCache(size_t capacity, bool optimize) : capacity(capacity), optimize(optimize) {}
+
+  shared_ptr<const Compiled> find(uint64_t h) {
+    lock_guard<mutex> lk(m);
+    auto it = entries.find(h);
+    if (it == entries.end()) return nullptr;
+    lru.splice(lru.begin(), lru, it->second.pos);
+    return it->second.prog;
+  }
+
+  // The cached compile of `src`, compiling it if needed. Throws
+  // runtime_error with the parser's message.
+  shared_ptr<const Compiled> get(uint64_t h, const string& src) {
+    if (auto c = find(h); c && c->source == src) return c;
+    auto c = compile(src);
+    lock_guard<mutex> lk(m);
+    auto it = entries.find(h);
+    if (it != entries.end()) {
+      it->second.prog = c;
+      lru.splice(lru.begin(), lru, it->second.pos);
+      return c;
+    }
+    lru.push_front(h);
+    entries[h] = {c, lru.begin()};
+    if (entries.size() > capacity) {
+      entries.erase(lru.back());
+      lru.pop_back();
+    }
+    return c;
+  }
+
+private:
+  struct Entry {
+    shared_ptr<const Compiled> prog;
+    list<uint64_t>::iterator pos;
+  };
+  size_t capacity;
+  bool optimize;
+  mutex m;                    // entries and lru
+  mutex parserLock;           // the parser's globals
+  unordered_map<uint64_t, Entry> entries;
+  list<uint64_t> lru;         // most recently used first
+
+  shared_ptr<const Compiled> compile(const string& src) {
+    if (src.empty()) throw runtime_error("Parse error: empty program");
+    auto c = make_shared<Compiled>();
+    c->source = src;
+    lock_guard<mutex> lk(parserLock);
+    FILE* in = fmemopen(const_cast<char*>(c->source.data()), c->source.size(), "r");
+    if (!in) throw runtime_error("tipsd: cannot scan the program");
+    activePool = c->pool.get();
+    try {
+      resetParser();
+      restartScanner(in);
+      yylineno = 1;
+      c->prog = parseProgram();
+      if (optimize) {
+        OptOptions opts;
+        opts.keepSymbols = true;
+        optimizeProgram(*c->prog, opts);
+      }
+    } catch (...) {
+      activePool = &stringPool;
+      fclose(in);
+      throw;
+    }
+    activePool = &stringPool;
+    fclose(in);
+    c->frame = varFrame;
+    c->symbols = symbolTable;
+    return c;
+  }
+};
+
+// -----------------------------------------------------------------------------
+// Output: an ostream whose bytes go out as 'O' frames
+// -----------------------------------------------------------------------------
+// A frame that cannot be sent throws ClientGone (budget.h), as a client
+// found hung up between steps does.
+void sendFrame(int fd, char type, string_view body) {
+  string f(1, type);
+  tipsd::putLE(f, body.size(), 4);
+  f.append(body);
+  if (!tipsd::writeFull(fd, f.data(), f.size())) throw ClientGone{};
+}
+
+class FrameBuf : public streambuf {
+public:
+  explicit FrameBuf(int fd) : fd(fd) { setp(buf, buf + sizeof buf); }
+
+protected:
+  int_type overflow(int_type c) override {
+    flushBuf();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+  int sync() override {
+    flushBuf();
+    return 0;
+  }
+
+private:
+  int fd;
+  char buf[16 * 1024];
+
+  void flushBuf() {
+    if (pptr() == pbase()) return;
+    sendFrame(fd, 'O', string_view(pbase(), static_cast<size_t>(pptr() - pbase())));
+    setp(buf, buf + sizeof buf);
+  }
+};
+
+// -----------------------------------------------------------------------------
+// One connection
+// -----------------------------------------------------------------------------
+void sendDone(int fd, uint8_t status) { sendFrame(fd, 'D', string_view(reinterpret_cast<char*>(&status), 1)); }
+
+// Lends the interpreter a run's frame, input and string pool, counts its
+// steps and watches its client; gives the thread's own back however the
+// run ends.
+struct RunScope {
+  RunScope(Frame& frame, istream& in, StringPool& pool, const Limits& limits, int client) {
+    activeFrame = &frame;
+    activeInput = &in;
+    activePool = &pool;
+    budget::start(limits);
+    budget::watchClient(client);
+  }
+  ~RunScope() {
+    budget::stop();
+    activeFrame = &varFrame;
+    activeInput = &cin;
+    activePool = &stringPool;
+  }
+};
+
+bool readPayload(int fd, string& out) {
+  uint64_t n;
+  if (!tipsd::readLE(fd, n, 4) || n > tipsd::MAX_PAYLOAD) return false;
+  out.resize(n);
+  return tipsd::readFull(fd, &out[0], n);
+}
+
+void serve(int fd, ProgramCache& cache, const Limits& limits) {
+  unsigned char kind;
+  uint64_t h = 0;
+  string source, input;
+  if (!tipsd::readFull(fd, &kind, 1)) return;
+  if (kind == 'S') {
+    if (!readPayload(fd, source)) return;
+    h = tipsd::programHash(source);
+  } else if (kind != 'H' || !tipsd::readLE(fd, h, 8)) {
+    return;
+  }
+  unsigned char flags;
+  if (!tipsd::readFull(fd, &flags, 1) || !readPayload(fd, input)) return;
+
+  shared_ptr<const Compiled> c;
+  try {
+    c = kind == 'S' ? cache.get(h, source) : cache.find(h);
+  } catch (const exception& e) {
+    sendFrame(fd, 'E', e.what());
+    sendDone(fd, tipsd::FAILED);
+    return;
+  }
+  if (!c) {
+    sendFrame(fd, 'E', "tipsd: program not cached; send its source");
+    sendDone(fd, tipsd::UNKNOWN_HASH);
+    return;
+  }
+  string hash;
+  tipsd::putLE(hash, h, 8);
+  sendFrame(fd, 'H', hash);
+
+  Frame frame = c->frame;
+  istringstream in(input);
+  FrameBuf buf(fd);
+  OutputLimit limited(&buf, limits.maxOutput);
+  streambuf* sink = limits.maxOutput ? static_cast<streambuf*>(&limited) : &buf;
+  ostream out(sink);
+  out.exceptions(ios::badbit);  // let LimitExceeded through
+  uint8_t status = tipsd::OK;
+  RunScope scope(frame, in, *c->pool, limits, fd);
+  try {
+    if (c->prog->block) c->prog->block->interpret(out);
+    budget::stop();
+    if (flags & tipsd::FLAG_SYMBOLS) printSymbols(out, frame, c->symbols);
+    sink->pubsync();
+  } catch (const exception& e) {
+    budget::stop();
+    sink->pubsync();
+    sendFrame(fd, 'E', e.what());
+    status = dynamic_cast<const LimitExceeded*>(&e) ? tipsd::LIMIT : tipsd::FAILED;
+  }
+  sendDone(fd, status);
+}
+
+// -----------------------------------------------------------------------------
+// Accept loop and workers
+// -----------------------------------------------------------------------------
+atomic<int> listenFd{-1};
+atomic<bool> stopping{false};
+
+void onSignal(int) {
+  stopping = true;
+  int fd = listenFd.load();
+  if (fd >= 0) shutdown(fd, SHUT_RDWR);  // wakes accept()
+}
+
+template <typename N>
+bool numberFlag(const char* arg, const char* name, N& out) {
+  size_t n = strlen(name);
+  if (strncmp(arg, name, n) != 0) return false;
+  char* end = nullptr;
+  out = static_cast<N>(strtoull(arg + n, &end, 10));
+  if (end == arg + n || *end || arg[n] == '-' || out == 0) {
+    fprintf(stderr, "tipsd: bad value in %s\n", arg);
+    exit(1);
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  string path = tipsd::DEFAULT_SOCKET;
+  unsigned long workers = thread::hardware_concurrency() ? thread::hardware_concurrency() : 1;
+  unsigned long capacity = 256;
+  bool optimize = false;
+  Limits limits;
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    if (!strncmp(a, "--socket=", 9)) path = a + 9;
+    else if (numberFlag(a, "--workers=", workers) || numberFlag(a, "--cache=", capacity)) {}
+    else if (numberFlag(a, "--max-steps=", limits.maxSteps) || numberFlag(a, "--max-output=", limits.maxOutput)) {}
+    else if (!strncmp(a, "--timeout=", 10)) {
+      char* end = nullptr;
+      limits.timeout = strtod(a + 10, &end);
+      if (end == a + 10 || *end || !(limits.timeout > 0) || limits.timeout > 1e9) {
+        fprintf(stderr, "tipsd: bad value in %s\n", a);
+        return 1;
+      }
+    }
+    else if (!strcmp(a, "-O")) optimize = true;
+    else {
+      fprintf(stderr, "usage: %s [--socket=PATH] [--workers=N] [--cache=N] [-O]\n"
+                      "       [--max-steps=N] [--timeout=SEC] [--max-output=N]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) { perror("tipsd: socket"); return 1; }
+  sockaddr_un addr;
+  try { addr = tipsd::socketAddress(path); }
+  catch (const exception& e) { fprintf(stderr, "%s\n", e.what()); return 1; }
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0 || listen(fd, 512) != 0) {
+    perror(("tipsd: " + path).c_str());
+    return 1;
+  }
+  listenFd = fd;
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  ProgramCache cache(capacity, optimize);
+  mutex qm;
+  condition_variable qcv;
+  deque<int> queue;
+  bool closing = false;
+  vector<thread> pool;
+  for (unsigned long w = 0; w < workers; ++w) {
+    pool.emplace_back([&] {
+      for (;;) {
+        int conn;
+        {
+          unique_lock<mutex> lk(qm);
+          qcv.wait(lk, [&] { return closing || !queue.empty(); });
+          if (queue.empty()) return;
+          conn = queue.front();
+          queue.pop_front();
+        }
+        try { serve(conn, cache, limits); }
+        catch (const ClientGone&) {}  // nothing more to say to it
+        close(conn);
+      }
+    });
+  }
+  fprintf(stderr, "tipsd: listening on %s with %lu workers\n", path.c_str(), workers);
+
+  while (!stopping) {
+    int conn = accept(fd, nullptr, nullptr);
+    if (conn < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (!stopping) perror("tipsd: accept");
+      break;
+    }
+    timeval limit{10, 0};  // a client that stops sending or reading does not hold a worker
+    setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof limit);
+    setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof limit);
+    {
+      lock_guard<mutex> lk(qm);
+      queue.push_back(conn);
+    }
+    qcv.notify_one();
+  }
+
+  {
+    lock_guard<mutex> lk(qm);
+    closing = true;  // queued connections are still served
+  }
+  qcv.notify_all();
+  for (auto& t : pool) t.join();
+  close(fd);
+  unlink(path.c_str());
+  return 0;
+}
@@ -0,0 +1,159 @@
+// =============================================================================
+//   tipsd.h — wire protocol of the tipsd interpreter daemon
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   tipsd (tipsd.cpp) listens on a Unix stream socket and serves one run per
+//   connection. Integers are little endian.
+//
+//   request  program: u8 'S', u32 n, n bytes of source
+//                  or u8 'H', u64 hash from an earlier reply
+//            u8 flags (FLAG_SYMBOLS: append the symbol table)
+//            u32 n, n bytes of input for READ
+//   reply    frames of u8 type, u32 n, n bytes:
+//            'H'  u64 hash of the program, before anything else
+//            'O'  WRITE output, streamed in order as the run produces it
+//            'E'  a parse, runtime or input error, or an unknown hash
+//            'D'  u8 status, always last: 0 the run finished, 2 it stopped on
+//                 an error, 3 the hash is not (or no longer) cached, 4 it
+//                 went over one of the daemon's limits (budget.h)
+//
+//   The output is what `parse` writes between the BEGIN INTERPRETATION and
+//   INTERPRETATION COMPLETE banners (without the SYMBOL TABLE banner), as in
+//   --records mode. The client half is here too, for tipsc and tipsload.
+// =============================================================================
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "hashing.h"
+
+namespace tipsd {
+
+constexpr const char* DEFAULT_SOCKET = "/tmp/tipsd.sock";
+constexpr uint8_t FLAG_SYMBOLS = 1;
+constexpr uint32_t MAX_PAYLOAD = 64u << 20;  // largest source or input accepted
+
+enum Status : uint8_t { OK = 0, FAILED = 2, UNKNOWN_HASH = 3, LIMIT = 4 };
+
+// FNV-1a of the source text: the key programs are cached under.
+inline uint64_t programHash(std::string_view src) { return fnv::hash(src); }
+
+// -----------------------------------------------------------------------------
+// Socket I/O
+// -----------------------------------------------------------------------------
+inline bool readFull(int fd, void* buf, size_t n) {
+  char* p = static_cast<char*>(buf);
+  while (n > 0) {
+    ssize_t got = ::read(fd, p, n);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) return false;
+    p += got;
+    n -= static_cast<size_t>(got);
+  }
+  return true;
+}
+
+inline bool writeFull(int fd, const void* buf, size_t n) {
+  const char* p = static_cast<const char*>(buf);
+  while (n > 0) {
+    ssize_t put = ::send(fd, p, n, MSG_NOSIGNAL);
+    if (put < 0 && errno == EINTR) continue;
+    if (put <= 0) return false;
+    p += put;
+    n -= static_cast<size_t>(put);
+  }
+  return true;
+}
+
+inline void putLE(std::string& out, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; ++i) out.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+inline uint64_t getLE(const unsigned char* p, int bytes) {
+  uint64_t v = 0;
+  for (int i = bytes - 1; i >= 0; --i) v = (v << 8) | p[i];
+  return v;
+}
+
+inline bool readLE(int fd, uint64_t& v, int bytes) {
+  unsigned char b[8];
+  if (!readFull(fd, b, static_cast<size_t>(bytes))) return false;
+  v = getLE(b, bytes);
+  return true;
+}
+
+inline sockaddr_un socketAddress(const std::string& path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof addr.sun_path)
+    throw std::runtime_error("tipsd: socket path too long: " + path);
+  memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return addr;
+}
+
+// -----------------------------------------------------------------------------
+// Client
+// -----------------------------------------------------------------------------
+struct Reply {
+  uint64_t hash = 0;
+  std::string output;  // the 'O' frames, joined (unless streamed)
+  std::string error;   // the 'E' frame, if any
+  int status = -1;     // the 'D' frame
+};
+
+// Runs `source` (or, when `source` is null, the cached program `hash`) on
+// the daemon at `path` with `input` as its stdin. Output goes to `onOutput`
+// as it arrives if that is set. Throws runtime_error if the daemon cannot
+// be reached or hangs up early.
+inline Reply run(const std::string& path, const std::string* source, uint64_t hash,
+                 std::string_view input, uint8_t flags = 0,
+                 const std::function<void(std::string_view)>& onOutput = nullptr) {
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) throw std::runtime_error(std::string("tipsd: socket: ") + strerror(errno));
+  sockaddr_un addr = socketAddress(path);
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0) {
+    int err = errno;
+    ::close(fd);
+    throw std::runtime_error("tipsd: cannot connect to " + path + ": " + strerror(err));
+  }
+
+  std::string req;
+  if (source) {
+    req.push_back('S');
+    putLE(req, source->size(), 4);
+    req += *source;
+  } else {
+    req.push_back('H');
+    putLE(req, hash, 8);
+  }
+  req.push_back(static_cast<char>(flags));
+  putLE(req, input.size(), 4);
+  req.append(input);
+
+  Reply r;
+  bool ok = writeFull(fd, req.data(), req.size());
+  while (ok) {
+    unsigned char head[5];
+    if (!(ok = readFull(fd, head, sizeof head))) break;
+    std::string body(getLE(head + 1, 4), '\0');
+    if (!(ok = readFull(fd, &body[0], body.size()))) break;
+    if (head[0] == 'O') { if (onOutput) onOutput(body); else r.output += body; }
+    else if (head[0] == 'E') r.error = body;
+    else if (head[0] == 'H' && body.size() == 8) r.hash = getLE(reinterpret_cast<const unsigned char*>(body.data()), 8);
+    else if (head[0] == 'D' && body.size() == 1) { r.status = static_cast<unsigned char>(body[0]); break; }
+  }
+  ::close(fd);
+  if (!ok) throw std::runtime_error("tipsd: connection closed before the run finished");
+  return r;
+}
+
+}  // namespace tipsd
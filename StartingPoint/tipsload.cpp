@@ -0,0 +1,124 @@
+// =============================================================================
+//   tipsload.cpp — load generator for tipsd
+// =============================================================================
+// MSU CSE 4714/6714 Capstone Project (Fall 2025)
+// Author: Kevin Ho
+//
+//   Usage: tipsload [--socket=PATH] [--clients=N] [--requests=N] [--source]
+//                   FILE [INPUT]
+//
+//   N client threads each send their share of the requests back to back,
+//   one connection per request, running FILE with the contents of INPUT (or
+//   no input) as stdin. The first request sends the source; the rest name
+//   the program by its hash unless --source is given, in which case every
+//   request sends (and the daemon hashes) the full source. A hash the
+//   daemon no longer caches is followed by the source, as a real client
+//   would. Every reply must match the first one: same output, error and
+//   status.
+//
+//   Reports requests per second and latency percentiles over all requests.
+//
+//   Build/run:  make tipsload && ./tipsload FILE [INPUT]
+// =============================================================================
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "tipsd.h"
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+static string slurp(const char* path) {
+  ifstream in(path, ios::binary);
+  if (!in) { perror(path); exit(1); }
+  return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static bool numberFlag(const char* arg, const char* name, unsigned long& out) {
+  size_t n = strlen(name);
+  if (strncmp(arg, name, n) != 0) return false;
+  out = strtoul(arg + n, nullptr, 10);
+  if (out == 0) { fprintf(stderr, "tipsload: bad value in %s\n", arg); exit(1); }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  string path = tipsd::DEFAULT_SOCKET;
+  unsigned long clients = 4, requests = 10000;
+  bool sendSource = false;
+  const char* file = nullptr;
+  const char* inputFile = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    if (!strncmp(a, "--socket=", 9)) path = a + 9;
+    else if (numberFlag(a, "--clients=", clients) || numberFlag(a, "--requests=", requests)) {}
+    else if (!strcmp(a, "--source")) sendSource = true;
+    else if (a[0] != '-' && !file) file = a;
+    else if (a[0] != '-' && !inputFile) inputFile = a;
+    else {
+      fprintf(stderr, "usage: %s [--socket=PATH] [--clients=N] [--requests=N] [--source] FILE [INPUT]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (!file) { fprintf(stderr, "%s: no program FILE\n", argv[0]); return 1; }
+  string source = slurp(file);
+  string input = inputFile ? slurp(inputFile) : string();
+
+  tipsd::Reply first;
+  try { first = tipsd::run(path, &source, 0, input); }
+  catch (const exception& e) { fprintf(stderr, "%s\n", e.what()); return 1; }
+  if (first.status == tipsd::UNKNOWN_HASH || (first.status != tipsd::OK && !first.hash)) {
+    fprintf(stderr, "%s does not compile: %s\n", file, first.error.c_str());
+    return 1;
+  }
+
+  vector<vector<double>> us(clients);
+  atomic<size_t> bad{0}, resent{0};
+  auto t0 = Clock::now();
+  vector<thread> pool;
+  for (unsigned long c = 0; c < clients; ++c) {
+    pool.emplace_back([&, c] {
+      size_t mine = requests / clients + (c < requests % clients);
+      us[c].reserve(mine);
+      for (size_t k = 0; k < mine; ++k) {
+        auto t = Clock::now();
+        try {
+          tipsd::Reply r = tipsd::run(path, sendSource ? &source : nullptr, first.hash, input);
+          if (r.status == tipsd::UNKNOWN_HASH) {
+            ++resent;
+            r = tipsd::run(path, &source, 0, input);
+          }
+          if (r.status != first.status || r.output != first.output || r.error != first.error) ++bad;
+        } catch (const exception&) {
+          ++bad;
+        }
+        us[c].push_back(chrono::duration<double, micro>(Clock::now() - t).count());
+      }
+    });
+  }
+  for (auto& t : pool) t.join();
+  double secs = chrono::duration<double>(Clock::now() - t0).count();
+
+  vector<double> all;
+  for (auto& v : us) all.insert(all.end(), v.begin(), v.end());
+  sort(all.begin(), all.end());
+  auto pct = [&](double p) { return all[min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+  printf("%zu requests, %lu clients, %s: %.0f req/s\n", all.size(), clients,
+         sendSource ? "source each time" : "by hash", all.size() / secs);
+  printf("latency us: p50 %.0f  p90 %.0f  p99 %.0f  max %.0f\n", pct(0.5), pct(0.9), pct(0.99), all.back());
+  if (resent) printf("%zu hashes were no longer cached; sent the source again\n", resent.load());
+  if (bad) {
+    printf("%zu requests differed from the first run\n", bad.load());
+    return 1;
+  }
+  return 0;
+}